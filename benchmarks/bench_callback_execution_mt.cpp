@@ -0,0 +1,131 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/barrier.hpp>
+#include "./mpi_environment.hpp"
+#include "./args.hpp"
+#include "./timer.hpp"
+#include "./utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// Exchange of inflight messages per iteration whose receive callbacks are artificially expensive
+// (busy waiting for OOMPH_BENCH_CALLBACK_US microseconds, default 20), for each of the callback
+// execution policies. With the thread pool, progress continues while callbacks are running.
+
+namespace oomph
+{
+void
+busy_wait(double us)
+{
+    using clock_type = std::chrono::steady_clock;
+    const auto start = clock_type::now();
+    while (std::chrono::duration<double, std::micro>(clock_type::now() - start).count() < us) {}
+}
+
+void
+run(context& ctxt, callback_execution e, int niter, int buff_size, int inflight, int num_threads,
+    double callback_us, int mpi_rank)
+{
+    using message = message_buffer<char>;
+
+    barrier          b(num_threads);
+    timer            t0;
+    std::atomic<int> num_callbacks{0};
+
+#ifdef OOMPH_BENCHMARKS_MT
+#pragma omp parallel
+#endif
+    {
+        auto       comm = ctxt.get_communicator();
+        const auto rank = comm.rank();
+        const auto size = comm.size();
+        const auto thread_id = THREADID;
+        const auto peer_rank = (rank + 1) % size;
+        comm.set_callback_execution(e);
+
+        std::vector<message> smsgs(inflight);
+        std::vector<message> rmsgs(inflight);
+        for (int j = 0; j < inflight; j++)
+        {
+            smsgs[j] = comm.make_buffer<char>(buff_size);
+            rmsgs[j] = comm.make_buffer<char>(buff_size);
+            for (auto& c : smsgs[j]) c = 0;
+        }
+
+        b(comm);
+        if (thread_id == 0) t0.tic();
+
+        for (int i = 0; i < niter; ++i)
+        {
+            for (int j = 0; j < inflight; j++)
+            {
+                comm.recv(rmsgs[j], peer_rank, thread_id * inflight + j,
+                    [callback_us, &num_callbacks](message&, int, int)
+                    {
+                        busy_wait(callback_us);
+                        ++num_callbacks;
+                    });
+                comm.send_detached(smsgs[j], peer_rank, thread_id * inflight + j);
+            }
+            comm.wait_all();
+        }
+
+        b(comm);
+    }
+
+    const auto t = t0.toc();
+    if (mpi_rank == 0)
+    {
+        std::cout << (e == callback_execution::immediate  ? "immediate\n"
+                      : e == callback_execution::deferred ? "deferred\n"
+                                                          : "thread pool\n");
+        std::cout << "time:                   " << t / 1000000 << "s\n";
+        std::cout << "time per iteration:     " << t / niter << "us\n";
+        std::cout << "callbacks:              " << num_callbacks.load() << "\n";
+    }
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    args cmd_args(argc, argv);
+    if (!cmd_args) return exit(argv[0]);
+
+    // the thread pool requires a thread safe context
+    mpi_environment env(true, argc, argv);
+    if (env.size != 2) return exit(argv[0]);
+
+    char const*  us_str = std::getenv("OOMPH_BENCH_CALLBACK_US");
+    double const callback_us = us_str ? std::atof(us_str) : 20.0;
+
+    if (env.rank == 0)
+    {
+        std::cout << "inflight = " << cmd_args.inflight << std::endl;
+        std::cout << "size     = " << cmd_args.buff_size << std::endl;
+        std::cout << "N        = " << cmd_args.n_iter << std::endl;
+        std::cout << "callback = " << callback_us << "us" << std::endl;
+        std::cout << "\n\nrunning test " << __FILE__ << "\n\n";
+    }
+
+    context ctxt(MPI_COMM_WORLD, true);
+    for (auto e : {callback_execution::immediate, callback_execution::deferred,
+             callback_execution::thread_pool})
+        run(ctxt, e, cmd_args.n_iter, cmd_args.buff_size, cmd_args.inflight,
+            cmd_args.num_threads, callback_us, env.rank);
+
+    return 0;
+}
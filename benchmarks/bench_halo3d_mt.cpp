@@ -0,0 +1,502 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/barrier.hpp>
+#include "./mpi_environment.hpp"
+#include "./timer.hpp"
+#include "./utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef OOMPH_BENCHMARKS_MT
+#include <omp.h>
+#endif
+
+// Halo exchange of a 3D domain decomposed over a periodic MPI_Cart grid of ranks, as done by
+// stencil codes: every rank owns n^3 cells of each field plus a halo of width w, which is updated
+// from the 6 face, 18 face and edge, or all 26 neighbours. The fields are distributed over the
+// threads of a rank (OpenMP build), each thread exchanging its fields through its own communicator.
+// Variants:
+// - future:   one message per field and neighbour, packed from and unpacked into the field, waiting
+//             for the requests
+// - callback: as future, the receives are unpacked by their callbacks
+// - multi:    the boundary layer is split into 26 disjoint face, edge and corner regions; each is
+//             packed once and sent with send_multi to all neighbours which need it
+// The halos are checked after the first exchange of every variant. Reported are the time per
+// exchange (slowest rank) and the bytes sent per rank and exchange over that time.
+
+namespace oomph
+{
+using message = message_buffer<double>;
+
+enum class variant
+{
+    future,
+    callback,
+    multi
+};
+
+char const*
+name(variant v)
+{
+    switch (v)
+    {
+    case variant::future: return "future";
+    case variant::callback: return "callback";
+    default: return "multi";
+    }
+}
+
+struct config
+{
+    int niter = 100;
+    int n = 64;       // cells per dimension and rank
+    int stencil = 26; // number of neighbours: 6, 18 or 26
+    int nfields = 4;
+    int w = 1; // halo width
+};
+
+// offset of a neighbour or region, components in {-1, 0, 1}
+struct direction
+{
+    int d[3];
+
+    int  index() const noexcept { return (d[0] + 1) * 9 + (d[1] + 1) * 3 + (d[2] + 1); }
+    int  order() const noexcept { return (d[0] != 0) + (d[1] != 0) + (d[2] != 0); }
+    auto operator-() const noexcept { return direction{{-d[0], -d[1], -d[2]}}; }
+
+    // region r is needed by the neighbour at offset *this
+    bool covered_by(direction const& r) const noexcept
+    {
+        for (int i = 0; i < 3; ++i)
+            if (d[i] != 0 && d[i] != r.d[i]) return false;
+        return true;
+    }
+};
+
+std::vector<direction>
+directions(int max_order)
+{
+    std::vector<direction> dirs;
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            for (int z = -1; z <= 1; ++z)
+            {
+                direction const d{{x, y, z}};
+                if (d.order() > 0 && d.order() <= max_order) dirs.push_back(d);
+            }
+    return dirs;
+}
+
+// half-open index range per dimension of the local field, including the halo
+struct box
+{
+    int lo[3];
+    int hi[3];
+
+    std::size_t size() const noexcept
+    {
+        return std::size_t(hi[0] - lo[0]) * (hi[1] - lo[1]) * (hi[2] - lo[2]);
+    }
+};
+
+struct layout
+{
+    int n;
+    int w;
+
+    int extent() const noexcept { return n + 2 * w; }
+
+    // cells sent to the neighbour at offset d
+    box send_box(direction const& d) const noexcept
+    {
+        box b;
+        for (int i = 0; i < 3; ++i)
+        {
+            b.lo[i] = d.d[i] < 0 ? w : (d.d[i] > 0 ? n : w);
+            b.hi[i] = d.d[i] < 0 ? 2 * w : n + w;
+        }
+        return b;
+    }
+
+    // halo cells received from the neighbour at offset d
+    box recv_box(direction const& d) const noexcept
+    {
+        box b;
+        for (int i = 0; i < 3; ++i)
+        {
+            b.lo[i] = d.d[i] < 0 ? 0 : (d.d[i] > 0 ? n + w : w);
+            b.hi[i] = d.d[i] < 0 ? w : (d.d[i] > 0 ? n + 2 * w : n + w);
+        }
+        return b;
+    }
+
+    // disjoint regions of the boundary layer: layers of width w towards r, the rest of the
+    // interior along the other dimensions
+    box region_box(direction const& r) const noexcept
+    {
+        box b;
+        for (int i = 0; i < 3; ++i)
+        {
+            b.lo[i] = r.d[i] < 0 ? w : (r.d[i] > 0 ? n : 2 * w);
+            b.hi[i] = r.d[i] < 0 ? 2 * w : (r.d[i] > 0 ? n + w : n);
+        }
+        return b;
+    }
+
+    // halo cells receiving region r of the neighbour at offset d
+    box region_recv_box(direction const& d, direction const& r) const noexcept
+    {
+        box b = region_box(r);
+        auto const h = recv_box(d);
+        for (int i = 0; i < 3; ++i)
+            if (d.d[i] != 0)
+            {
+                b.lo[i] = h.lo[i];
+                b.hi[i] = h.hi[i];
+            }
+        return b;
+    }
+};
+
+struct field
+{
+    int                 m;
+    std::vector<double> data;
+
+    field(int m_)
+    : m{m_}
+    , data(std::size_t(m) * m * m, 0)
+    {
+    }
+
+    double& operator()(int i, int j, int k) noexcept
+    {
+        return data[(std::size_t(i) * m + j) * m + k];
+    }
+
+    void pack(box const& b, double* out) noexcept
+    {
+        for (int i = b.lo[0]; i < b.hi[0]; ++i)
+            for (int j = b.lo[1]; j < b.hi[1]; ++j)
+                for (int k = b.lo[2]; k < b.hi[2]; ++k) *out++ = (*this)(i, j, k);
+    }
+
+    void unpack(box const& b, double const* in) noexcept
+    {
+        for (int i = b.lo[0]; i < b.hi[0]; ++i)
+            for (int j = b.lo[1]; j < b.hi[1]; ++j)
+                for (int k = b.lo[2]; k < b.hi[2]; ++k) (*this)(i, j, k) = *in++;
+    }
+};
+
+// position of this rank in the periodic grid of ranks
+struct decomposition
+{
+    MPI_Comm comm;
+    int      dims[3] = {0, 0, 0};
+    int      coords[3];
+
+    decomposition(int size)
+    {
+        int periods[3] = {1, 1, 1};
+        MPI_Dims_create(size, 3, dims);
+        MPI_Cart_create(MPI_COMM_WORLD, 3, dims, periods, 0, &comm);
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Cart_coords(comm, rank, 3, coords);
+    }
+
+    ~decomposition() { MPI_Comm_free(&comm); }
+
+    // rank in MPI_COMM_WORLD, as the cartesian communicator does not reorder
+    int neighbor(direction const& d) const
+    {
+        int c[3], rank;
+        for (int i = 0; i < 3; ++i) c[i] = coords[i] + d.d[i];
+        MPI_Cart_rank(comm, c, &rank);
+        return rank;
+    }
+
+    // value of a cell, from its global position
+    double value(layout const& l, int f, int i, int j, int k) const noexcept
+    {
+        int  g[3] = {i, j, k};
+        long id = f;
+        for (int x = 0; x < 3; ++x)
+        {
+            long const e = long(dims[x]) * l.n;
+            id = id * e + ((coords[x] * l.n + g[x] - l.w) % e + e) % e;
+        }
+        return id;
+    }
+};
+
+// messages of one thread
+struct exchange_state
+{
+    struct item
+    {
+        field*           f;
+        box              b;
+        message          msg;
+        int              rank;
+        int              tag;
+        std::vector<int> ranks; // send_multi only
+    };
+
+    std::vector<item> sends;
+    std::vector<item> recvs;
+
+    exchange_state(communicator& comm, variant v, layout const& l, decomposition const& dec,
+        std::vector<direction> const& neighbors, std::vector<field*> const& fields,
+        std::vector<int> const& field_ids)
+    {
+        auto const add =
+            [&comm](std::vector<item>& items, field* f, box const& b, int rank, int tag)
+        { items.push_back(item{f, b, comm.make_buffer<double>(b.size()), rank, tag, {}}); };
+        for (std::size_t i = 0; i < fields.size(); ++i)
+        {
+            auto const f = fields[i];
+            auto const tag0 = field_ids[i] * 27;
+            if (v != variant::multi)
+            {
+                for (auto const& d : neighbors)
+                {
+                    add(sends, f, l.send_box(d), dec.neighbor(d), tag0 + d.index());
+                    add(recvs, f, l.recv_box(d), dec.neighbor(d), tag0 + (-d).index());
+                }
+                continue;
+            }
+            // empty if n == 2w
+            for (auto const& r : directions(3))
+            {
+                if (l.region_box(r).size() == 0) continue;
+                std::vector<int> ranks;
+                for (auto const& d : neighbors)
+                    if (d.covered_by(r)) ranks.push_back(dec.neighbor(d));
+                if (ranks.empty()) continue;
+                add(sends, f, l.region_box(r), -1, tag0 + r.index());
+                sends.back().ranks = std::move(ranks);
+            }
+            for (auto const& d : neighbors)
+                for (auto const& r : directions(3))
+                    if ((-d).covered_by(r) && l.region_box(r).size() > 0)
+                        add(recvs, f, l.region_recv_box(d, r), dec.neighbor(d), tag0 + r.index());
+        }
+    }
+
+    void exchange(communicator& comm, variant v)
+    {
+        if (v == variant::callback)
+        {
+            for (auto& x : recvs)
+                comm.recv(x.msg, x.rank, x.tag,
+                    [&x](message& m, int, int) { x.f->unpack(x.b, m.data()); });
+            for (auto& x : sends)
+            {
+                x.f->pack(x.b, x.msg.data());
+                comm.send(x.msg, x.rank, x.tag, [](message&, int, int) {});
+            }
+            comm.wait_all();
+            return;
+        }
+
+        std::vector<recv_request> rreqs;
+        std::vector<send_request> sreqs;
+        rreqs.reserve(recvs.size());
+        sreqs.reserve(sends.size());
+        for (auto& x : recvs) rreqs.push_back(comm.recv(x.msg, x.rank, x.tag));
+        for (auto& x : sends)
+        {
+            x.f->pack(x.b, x.msg.data());
+            if (v == variant::multi) sreqs.push_back(comm.send_multi(x.msg, x.ranks, x.tag));
+            else
+                sreqs.push_back(comm.send(x.msg, x.rank, x.tag));
+        }
+        for (std::size_t i = 0; i < recvs.size(); ++i)
+        {
+            rreqs[i].wait();
+            recvs[i].f->unpack(recvs[i].b, recvs[i].msg.data());
+        }
+        for (auto& r : sreqs) r.wait();
+    }
+
+    std::size_t bytes_sent() const noexcept
+    {
+        std::size_t n = 0;
+        for (auto const& x : sends)
+            n += x.msg.size() * sizeof(double) * std::max<std::size_t>(x.ranks.size(), 1);
+        return n;
+    }
+};
+
+// fills the interior, clears the halo
+void
+initialize(field& f, int id, layout const& l, decomposition const& dec)
+{
+    for (int i = 0; i < l.extent(); ++i)
+        for (int j = 0; j < l.extent(); ++j)
+            for (int k = 0; k < l.extent(); ++k)
+            {
+                bool const interior = i >= l.w && i < l.n + l.w && j >= l.w && j < l.n + l.w &&
+                                      k >= l.w && k < l.n + l.w;
+                f(i, j, k) = interior ? dec.value(l, id, i, j, k) : -1;
+            }
+}
+
+// number of wrong halo cells
+std::size_t
+check(field& f, int id, layout const& l, decomposition const& dec,
+    std::vector<direction> const& neighbors)
+{
+    std::size_t errors = 0;
+    for (auto const& d : neighbors)
+    {
+        auto const b = l.recv_box(d);
+        for (int i = b.lo[0]; i < b.hi[0]; ++i)
+            for (int j = b.lo[1]; j < b.hi[1]; ++j)
+                for (int k = b.lo[2]; k < b.hi[2]; ++k)
+                    if (f(i, j, k) != dec.value(l, id, i, j, k)) ++errors;
+    }
+    return errors;
+}
+
+// returns false if the halo check failed on any rank
+bool
+run(context& ctxt, variant v, config const& cfg, int num_threads, decomposition const& dec,
+    int mpi_rank)
+{
+    layout const             l{cfg.n, cfg.w};
+    int const                order = cfg.stencil == 6 ? 1 : (cfg.stencil == 18 ? 2 : 3);
+    auto const               neighbors = directions(order);
+    barrier                  b(num_threads);
+    timer                    t0;
+    std::atomic<std::size_t> errors{0};
+    std::atomic<std::size_t> bytes{0};
+
+#ifdef OOMPH_BENCHMARKS_MT
+#pragma omp parallel
+#endif
+    {
+        auto       comm = ctxt.get_communicator();
+        auto const thread_id = THREADID;
+
+        std::vector<field> fields;
+        std::vector<int>   ids;
+        for (int f = thread_id; f < cfg.nfields; f += num_threads)
+        {
+            fields.emplace_back(l.extent());
+            ids.push_back(f);
+        }
+        std::vector<field*> field_ptrs;
+        for (auto& f : fields) field_ptrs.push_back(&f);
+        exchange_state s(comm, v, l, dec, neighbors, field_ptrs, ids);
+        bytes += s.bytes_sent();
+
+        for (std::size_t i = 0; i < fields.size(); ++i) initialize(fields[i], ids[i], l, dec);
+        b(comm);
+        s.exchange(comm, v);
+        for (std::size_t i = 0; i < fields.size(); ++i)
+            errors += check(fields[i], ids[i], l, dec, neighbors);
+
+        b(comm);
+        if (thread_id == 0) t0.tic();
+        for (int i = 0; i < cfg.niter; ++i) s.exchange(comm, v);
+        b(comm);
+        if (thread_id == 0) t0.toc();
+    }
+
+    // slowest rank, bytes and errors summed over all ranks
+    double        t = t0.sum() / cfg.niter;
+    unsigned long counts[2] = {bytes.load(), errors.load()};
+    MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (mpi_rank == 0)
+    {
+        int size;
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        double const bytes_per_rank = double(counts[0]) / size;
+        std::cout << name(v) << ":\n";
+        std::cout << "  time per exchange:      " << t << " us\n";
+        std::cout << "  bytes per rank:         " << bytes_per_rank << "\n";
+        std::cout << "  bandwidth per rank:     " << bytes_per_rank / t << " MB/s\n";
+        if (counts[1]) std::cout << "  halo check FAILED:      " << counts[1] << " cells\n";
+    }
+    return counts[1] == 0;
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    config cfg;
+    std::string v = "all";
+    if (argc > 7 || (argc > 1 && std::string(argv[1]) == "-h"))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [future|callback|multi|all] [niter] [n] [stencil: 6|18|26] [fields]"
+                     " [halo width]"
+                  << std::endl;
+        return 1;
+    }
+    if (argc > 1) v = argv[1];
+    if (argc > 2) cfg.niter = std::atoi(argv[2]);
+    if (argc > 3) cfg.n = std::atoi(argv[3]);
+    if (argc > 4) cfg.stencil = std::atoi(argv[4]);
+    if (argc > 5) cfg.nfields = std::atoi(argv[5]);
+    if (argc > 6) cfg.w = std::atoi(argv[6]);
+    if ((cfg.stencil != 6 && cfg.stencil != 18 && cfg.stencil != 26) || cfg.n < 2 * cfg.w ||
+        cfg.w < 1)
+    {
+        std::cerr << "invalid arguments: stencil must be 6, 18 or 26, n at least twice the halo"
+                  << std::endl;
+        return 1;
+    }
+
+    int num_threads = 1;
+#ifdef OOMPH_BENCHMARKS_MT
+#pragma omp parallel
+    {
+#pragma omp master
+        num_threads = omp_get_num_threads();
+    }
+#endif
+    bool const multi_threaded = (num_threads > 1);
+
+    mpi_environment env(multi_threaded, argc, argv);
+    bool            ok = true;
+    {
+        decomposition const dec(env.size);
+        context             ctxt(MPI_COMM_WORLD, multi_threaded);
+        if (env.rank == 0)
+        {
+            std::cout << "\n\nrunning test " << __FILE__ << "\n\n";
+            std::cout << "ranks:           " << dec.dims[0] << " x " << dec.dims[1] << " x "
+                      << dec.dims[2] << "\n";
+            std::cout << "threads:         " << num_threads << "\n";
+            std::cout << "domain per rank: " << cfg.n << "^3, halo " << cfg.w << "\n";
+            std::cout << "neighbours:      " << cfg.stencil << "\n";
+            std::cout << "fields:          " << cfg.nfields << "\n";
+            std::cout << "N:               " << cfg.niter << "\n\n";
+        }
+        for (auto x : {variant::future, variant::callback, variant::multi})
+            if (v == "all" || v == name(x))
+                ok = run(ctxt, x, cfg, num_threads, dec, env.rank) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
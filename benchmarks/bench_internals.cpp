@@ -0,0 +1,313 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/barrier.hpp>
+#include <oomph/util/unique_function.hpp>
+#include <oomph/detail/request_state.hpp>
+#include "../src/mpi/callback_queue.hpp"
+#include "../src/ucx/request_data.hpp"
+#include "./mpi_environment.hpp"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Software overhead per message of the data structures on the critical path, in a single process:
+// run without mpirun, and select benchmarks with --benchmark_filter. The barrier benchmarks need a
+// context on MPI_COMM_WORLD, and are skipped if its RMA window cannot be created.
+
+namespace oomph
+{
+using time_point = callback_queue::time_point;
+using clock_type = std::chrono::steady_clock;
+
+std::unique_ptr<context>                g_context;
+std::map<int, std::unique_ptr<barrier>> g_barriers; // by number of threads
+
+// Whether an RMA window like the one of a context can be created: a single process may lack the
+// one-sided component. Errors are returned on a communicator of its own, MPI_COMM_WORLD keeps
+// aborting on errors.
+bool
+rma_available()
+{
+    MPI_Comm comm;
+    MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+    MPI_Comm_set_errhandler(comm, MPI_ERRORS_RETURN);
+    MPI_Win    win;
+    bool const created = MPI_Win_create_dynamic(MPI_INFO_NULL, comm, &win) == MPI_SUCCESS;
+    bool       ok = created;
+    if (created)
+    {
+        MPI_Win_set_errhandler(win, MPI_ERRORS_RETURN);
+        ok = MPI_Win_fence(0, win) == MPI_SUCCESS;
+        MPI_Win_free(&win);
+    }
+    MPI_Comm_free(&comm);
+    return ok;
+}
+
+// Receives of empty messages from the process itself stand in for the requests of the transport
+// layer: they complete once the matching sends are posted.
+MPI_Request
+self_recv()
+{
+    MPI_Request r;
+    MPI_Irecv(nullptr, 0, MPI_BYTE, 0, 0, MPI_COMM_SELF, &r);
+    return r;
+}
+
+MPI_Request
+self_send()
+{
+    MPI_Request r;
+    MPI_Isend(nullptr, 0, MPI_BYTE, 0, 0, MPI_COMM_SELF, &r);
+    return r;
+}
+
+void
+enqueue(callback_queue& q, std::vector<MPI_Request> const& reqs, int& invoked)
+{
+    for (auto r : reqs)
+        q.enqueue(mpi_request{r}, [&invoked]() { ++invoked; }, callback_queue::handle_ptr{}, 0,
+            time_point{});
+}
+
+int
+drain(callback_queue& q)
+{
+    int n = 0;
+    while (q.size())
+        n += q.progress([](int, time_point) {}, [](callback_queue::cb_type& cb, auto) { cb(); });
+    return n;
+}
+
+// enqueue a batch of callbacks, complete their requests and progress until all ran: posting the
+// requests and completing them is not timed
+void
+callback_queue_batch(benchmark::State& state)
+{
+    callback_queue           q;
+    std::vector<MPI_Request> reqs(state.range(0));
+    std::vector<MPI_Request> sends(state.range(0));
+    int                      invoked = 0;
+    for (auto _ : state)
+    {
+        for (auto& r : reqs) r = self_recv();
+        auto const start = clock_type::now();
+        enqueue(q, reqs, invoked);
+        auto const enqueued = clock_type::now();
+        for (auto& s : sends) s = self_send();
+        auto const sent = clock_type::now();
+        drain(q);
+        auto const end = clock_type::now();
+        state.SetIterationTime(
+            std::chrono::duration<double>((enqueued - start) + (end - sent)).count());
+        MPI_Waitall(sends.size(), sends.data(), MPI_STATUSES_IGNORE);
+    }
+    state.SetItemsProcessed(invoked);
+}
+BENCHMARK(callback_queue_batch)->RangeMultiplier(4)->Range(1, 256)->UseManualTime();
+
+// progress without any completion, with a number of pending requests
+void
+callback_queue_pending(benchmark::State& state)
+{
+    callback_queue           q;
+    std::vector<MPI_Request> reqs(state.range(0));
+    std::vector<MPI_Request> sends(state.range(0));
+    int                      invoked = 0;
+    for (auto& r : reqs) r = self_recv();
+    enqueue(q, reqs, invoked);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            q.progress([](int, time_point) {}, [](callback_queue::cb_type& cb, auto) { cb(); }));
+    for (auto& s : sends) s = self_send();
+    drain(q);
+    MPI_Waitall(sends.size(), sends.data(), MPI_STATUSES_IGNORE);
+}
+BENCHMARK(callback_queue_pending)->RangeMultiplier(4)->Range(1, 256);
+
+// a typical completion callback: a few pointers, stored inline
+void
+unique_function_small(benchmark::State& state)
+{
+    int  x = 0;
+    int* p = &x;
+    for (auto _ : state)
+    {
+        util::unique_function<void()> f([p, &x]() { *p += x + 1; });
+        benchmark::DoNotOptimize(f);
+        f();
+    }
+    benchmark::DoNotOptimize(x);
+}
+BENCHMARK(unique_function_small);
+
+// too large to be stored inline
+void
+unique_function_large(benchmark::State& state)
+{
+    std::array<char, 2 * util::unique_function<void()>::buffer_size> a{};
+    int                                                                x = 0;
+    for (auto _ : state)
+    {
+        util::unique_function<void()> f([a, &x]() { x += a[0] + 1; });
+        benchmark::DoNotOptimize(f);
+        f();
+    }
+    benchmark::DoNotOptimize(x);
+}
+BENCHMARK(unique_function_large);
+
+void
+unique_function_move(benchmark::State& state)
+{
+    int                           x = 0;
+    util::unique_function<void()> f([&x]() { ++x; });
+    util::unique_function<void()> g;
+    for (auto _ : state)
+    {
+        g = std::move(f);
+        f = std::move(g);
+    }
+    f();
+    benchmark::DoNotOptimize(x);
+}
+BENCHMARK(unique_function_move);
+
+void
+unique_function_invoke(benchmark::State& state)
+{
+    int                           x = 0;
+    util::unique_function<void()> f([&x]() { ++x; });
+    for (auto _ : state) f();
+    benchmark::DoNotOptimize(x);
+}
+BENCHMARK(unique_function_invoke);
+
+// a request taken from and returned to the pool, as for every send and receive
+void
+shared_request_create(benchmark::State& state)
+{
+    boost::pool<> pool(sizeof(detail::request_state), detail::request_pool_start_size);
+    std::size_t   scheduled = 0;
+    for (auto _ : state)
+    {
+        detail::shared_request_ptr r(&pool, nullptr, &scheduled);
+        benchmark::DoNotOptimize(r.get());
+    }
+}
+BENCHMARK(shared_request_create);
+
+void
+shared_request_copy(benchmark::State& state)
+{
+    boost::pool<>              pool(sizeof(detail::request_state), detail::request_pool_start_size);
+    std::size_t                scheduled = 0;
+    detail::shared_request_ptr r(&pool, nullptr, &scheduled);
+    for (auto _ : state)
+    {
+        auto copy = r;
+        benchmark::DoNotOptimize(copy.get());
+    }
+}
+BENCHMARK(shared_request_copy);
+
+// a batch of requests in flight at the same time, growing the pool beyond its first chunk
+void
+shared_request_batch(benchmark::State& state)
+{
+    boost::pool<>                           pool(
+        sizeof(detail::request_state), detail::request_pool_start_size);
+    std::size_t                             scheduled = 0;
+    std::vector<detail::shared_request_ptr> reqs;
+    reqs.reserve(state.range(0));
+    for (auto _ : state)
+    {
+        for (int i = 0; i < state.range(0); ++i) reqs.emplace_back(&pool, nullptr, &scheduled);
+        reqs.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(shared_request_batch)->RangeMultiplier(8)->Range(8, 4096);
+
+// synchronization of the threads of a rank
+void
+barrier_in_node(benchmark::State& state)
+{
+    if (!g_context)
+    {
+        state.SkipWithError("no context");
+        return;
+    }
+    auto  comm = g_context->get_communicator();
+    auto& b = *g_barriers.at(state.threads());
+    for (auto _ : state) b.in_node(comm);
+}
+BENCHMARK(barrier_in_node)->ThreadRange(1, 4)->UseRealTime();
+
+// completions of a batch of receives passed back to the owning thread (UCX)
+void
+lockfree_queue_batch(benchmark::State& state)
+{
+    completion_lockfree_queue q(128);
+    std::size_t               n = 0;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < state.range(0); ++i)
+            while (!q.push(request_data::completion{})) {}
+        n += q.consume_all([](request_data::completion const&) {});
+    }
+    state.SetItemsProcessed(n);
+}
+BENCHMARK(lockfree_queue_batch)->RangeMultiplier(4)->Range(1, 256);
+
+// one queue shared by several threads, each pushing and consuming
+void
+lockfree_queue_shared(benchmark::State& state)
+{
+    static completion_lockfree_queue q(128);
+    for (auto _ : state)
+    {
+        while (!q.push(request_data::completion{})) {}
+        benchmark::DoNotOptimize(q.consume_one([](request_data::completion const&) {}));
+    }
+}
+BENCHMARK(lockfree_queue_shared)->ThreadRange(1, 4)->UseRealTime();
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    mpi_environment env(true, argc, argv);
+    if (rma_available())
+    {
+        g_context = std::make_unique<context>(MPI_COMM_WORLD, true);
+        for (int n = 1; n <= 4; n *= 2) g_barriers[n] = std::make_unique<barrier>(n);
+    }
+    else
+        std::cerr << "cannot create an RMA window, skipping the barrier" << std::endl;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    g_barriers.clear();
+    g_context.reset();
+    return 0;
+}
@@ -0,0 +1,332 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include "./mpi_environment.hpp"
+#include "./sample_accumulator.hpp"
+#ifdef OOMPH_BENCHMARKS_UCX
+#include <ucp/api/ucp.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Ping-pong latency between pairs of ranks (2i, 2i+1) for message sizes from 0 B up to max_size in
+// powers of two. The same exchange is run through oomph and directly through MPI (and UCX, when
+// built with the UCX backend), such that the overhead of oomph can be read off. Every round trip
+// after the warmup is a sample; the latency is half of it, in microseconds, with quantiles over
+// the samples of all pairs. Beyond 64 KiB the number of iterations is reduced in proportion to the
+// size, to at least 10.
+
+namespace oomph
+{
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::size_t full_iterations_size = 1 << 16;
+constexpr int         tag = 42;
+
+int
+iterations(std::size_t size, int niter)
+{
+    if (size <= full_iterations_size) return niter;
+    return std::max<int>(10, niter / (size / full_iterations_size));
+}
+
+// the initiator posts the receive and sends, the responder replies once the message has arrived
+class oomph_transport
+{
+  private:
+    using message = message_buffer<char>;
+
+    communicator m_comm;
+    int          m_peer;
+    message      m_smsg;
+    message      m_rmsg;
+
+  public:
+    static constexpr char const* name = "oomph";
+
+    oomph_transport(context& ctxt, int peer)
+    : m_comm{ctxt.get_communicator()}
+    , m_peer{peer}
+    {
+    }
+
+    void prepare(std::size_t size)
+    {
+        m_smsg = m_comm.make_buffer<char>(size);
+        m_rmsg = m_comm.make_buffer<char>(size);
+        for (auto& c : m_smsg) c = 1;
+    }
+
+    void round_trip(bool initiator)
+    {
+        auto r = m_comm.recv(m_rmsg, m_peer, tag);
+        if (!initiator) r.wait();
+        m_comm.send(m_smsg, m_peer, tag).wait();
+        r.wait();
+    }
+};
+
+class mpi_transport
+{
+  private:
+    MPI_Comm          m_comm;
+    int               m_peer;
+    std::vector<char> m_sbuf;
+    std::vector<char> m_rbuf;
+
+  public:
+    static constexpr char const* name = "mpi";
+
+    mpi_transport(context&, int peer)
+    : m_peer{peer}
+    {
+        MPI_Comm_dup(MPI_COMM_WORLD, &m_comm);
+    }
+
+    ~mpi_transport() { MPI_Comm_free(&m_comm); }
+
+    void prepare(std::size_t size)
+    {
+        m_sbuf.assign(size, 1);
+        m_rbuf.assign(size, 0);
+    }
+
+    void round_trip(bool initiator)
+    {
+        int const   n = m_sbuf.size();
+        MPI_Request r;
+        MPI_Irecv(m_rbuf.data(), n, MPI_CHAR, m_peer, tag, m_comm, &r);
+        if (!initiator) MPI_Wait(&r, MPI_STATUS_IGNORE);
+        MPI_Send(m_sbuf.data(), n, MPI_CHAR, m_peer, tag, m_comm);
+        MPI_Wait(&r, MPI_STATUS_IGNORE);
+    }
+};
+
+#ifdef OOMPH_BENCHMARKS_UCX
+// a context, worker and endpoint of its own, connected to the peer through MPI
+class ucx_transport
+{
+  private:
+    ucp_context_h     m_context;
+    ucp_worker_h      m_worker;
+    ucp_ep_h          m_ep;
+    std::vector<char> m_sbuf;
+    std::vector<char> m_rbuf;
+
+    static void check(ucs_status_t s)
+    {
+        if (s != UCS_OK) throw std::runtime_error(ucs_status_string(s));
+    }
+
+    static void send_cb(void*, ucs_status_t) {}
+    static void recv_cb(void*, ucs_status_t, ucp_tag_recv_info_t*) {}
+
+    void wait(ucs_status_ptr_t req)
+    {
+        if (UCS_PTR_IS_ERR(req)) check(UCS_PTR_STATUS(req));
+        if (req == nullptr) return;
+        while (ucp_request_check_status(req) == UCS_INPROGRESS) ucp_worker_progress(m_worker);
+        ucp_request_free(req);
+    }
+
+  public:
+    static constexpr char const* name = "ucx";
+
+    ucx_transport(context&, int peer)
+    {
+        ucp_config_t* config;
+        check(ucp_config_read(nullptr, nullptr, &config));
+        ucp_params_t params;
+        params.field_mask = UCP_PARAM_FIELD_FEATURES;
+        params.features = UCP_FEATURE_TAG;
+        check(ucp_init(&params, config, &m_context));
+        ucp_config_release(config);
+
+        ucp_worker_params_t wparams;
+        wparams.field_mask = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
+        wparams.thread_mode = UCS_THREAD_MODE_SINGLE;
+        check(ucp_worker_create(m_context, &wparams, &m_worker));
+
+        ucp_address_t* address;
+        std::size_t    length;
+        check(ucp_worker_get_address(m_worker, &address, &length));
+        unsigned long     n = length, peer_n;
+        MPI_Sendrecv(&n, 1, MPI_UNSIGNED_LONG, peer, 0, &peer_n, 1, MPI_UNSIGNED_LONG, peer, 0,
+            MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        std::vector<char> peer_address(peer_n);
+        MPI_Sendrecv(address, n, MPI_BYTE, peer, 0, peer_address.data(), peer_n, MPI_BYTE, peer,
+            0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        ucp_worker_release_address(m_worker, address);
+
+        ucp_ep_params_t eparams;
+        eparams.field_mask = UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
+        eparams.address = reinterpret_cast<ucp_address_t const*>(peer_address.data());
+        check(ucp_ep_create(m_worker, &eparams, &m_ep));
+    }
+
+    ~ucx_transport()
+    {
+        // both sides flush before either side destroys its worker
+        wait(ucp_ep_close_nb(m_ep, UCP_EP_CLOSE_MODE_FLUSH));
+        MPI_Barrier(MPI_COMM_WORLD);
+        ucp_worker_destroy(m_worker);
+        ucp_cleanup(m_context);
+    }
+
+    void prepare(std::size_t size)
+    {
+        m_sbuf.assign(size, 1);
+        m_rbuf.assign(size, 0);
+    }
+
+    void round_trip(bool initiator)
+    {
+        auto const r = ucp_tag_recv_nb(m_worker, m_rbuf.data(), m_rbuf.size(),
+            ucp_dt_make_contig(1), tag, ~ucp_tag_t(0), &recv_cb);
+        if (UCS_PTR_IS_ERR(r)) check(UCS_PTR_STATUS(r));
+        if (!initiator)
+            while (ucp_request_check_status(r) == UCS_INPROGRESS) ucp_worker_progress(m_worker);
+        wait(ucp_tag_send_nb(m_ep, m_sbuf.data(), m_sbuf.size(), ucp_dt_make_contig(1), tag,
+            &send_cb));
+        wait(r);
+    }
+};
+#endif
+
+struct result
+{
+    char const*        transport;
+    std::size_t        size;
+    int                niter;
+    sample_accumulator latency;
+};
+
+template<typename Transport>
+void
+run(context& ctxt, int rank, std::size_t max_size, int niter, int warmup,
+    std::vector<result>& results)
+{
+    int const  peer = rank ^ 1;
+    bool const initiator = (rank % 2) == 0;
+    Transport  t(ctxt, peer);
+    for (std::size_t size = 0; size <= max_size; size = size ? 2 * size : 1)
+    {
+        t.prepare(size);
+        int const          n = iterations(size, niter);
+        sample_accumulator acc;
+        acc.reserve(n);
+        MPI_Barrier(MPI_COMM_WORLD);
+        for (int i = 0; i < std::min(warmup, n); ++i) t.round_trip(initiator);
+        for (int i = 0; i < n; ++i)
+        {
+            auto const start = clock_type::now();
+            t.round_trip(initiator);
+            auto const end = clock_type::now();
+            if (initiator) acc(std::chrono::duration<double, std::micro>(end - start).count() / 2);
+        }
+        results.push_back({Transport::name, size, n, reduce(acc, MPI_COMM_WORLD)});
+    }
+}
+
+void
+print(std::ostream& os, std::vector<result>& results)
+{
+    auto const flags = os.flags();
+    os << std::fixed << std::setprecision(2);
+    os << "transport      size  iterations      mean       p50       p90       p99       max"
+          "  (us)\n";
+    for (auto& r : results)
+    {
+        auto& l = r.latency;
+        os << std::setw(9) << r.transport << std::setw(10) << r.size << std::setw(12) << r.niter
+           << std::setw(10) << l.mean() << std::setw(10) << l.quantile(0.5) << std::setw(10)
+           << l.quantile(0.9) << std::setw(10) << l.quantile(0.99) << std::setw(10) << l.max()
+           << "\n";
+    }
+    os.flags(flags);
+}
+
+void
+print_json(std::ostream& os, std::vector<result>& results, int num_ranks)
+{
+    os << "{\n  \"benchmark\": \"latency\",\n  \"ranks\": " << num_ranks
+       << ",\n  \"unit\": \"us\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        auto& r = results[i];
+        auto& l = r.latency;
+        os << "    {\"transport\": \"" << r.transport << "\", \"size\": " << r.size
+           << ", \"iterations\": " << r.niter << ", \"samples\": " << l.num_samples()
+           << ", \"mean\": " << l.mean() << ", \"p50\": " << l.quantile(0.5)
+           << ", \"p90\": " << l.quantile(0.9) << ", \"p99\": " << l.quantile(0.99)
+           << ", \"max\": " << l.max() << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    if (argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " [niter] [max_size] [json file]" << std::endl;
+        std::cerr << "       run with an even number of MPI processes: e.g.: mpirun -np 2 ..."
+                  << std::endl;
+        return 1;
+    }
+    int const         niter = argc > 1 ? std::atoi(argv[1]) : 1000;
+    std::size_t const max_size = argc > 2 ? std::atol(argv[2]) : (64 << 20);
+    std::string const json = argc > 3 ? argv[3] : "";
+    int const         warmup = std::max(1, niter / 10);
+
+    mpi_environment env(false, argc, argv);
+    if (env.size % 2 != 0)
+    {
+        if (env.rank == 0) std::cerr << "an even number of processes is required" << std::endl;
+        return 1;
+    }
+
+    std::vector<result> results;
+    {
+        context ctxt(MPI_COMM_WORLD, false);
+        run<oomph_transport>(ctxt, env.rank, max_size, niter, warmup, results);
+        run<mpi_transport>(ctxt, env.rank, max_size, niter, warmup, results);
+#ifdef OOMPH_BENCHMARKS_UCX
+        run<ucx_transport>(ctxt, env.rank, max_size, niter, warmup, results);
+#endif
+    }
+
+    if (env.rank == 0)
+    {
+        std::cout << "\n\nrunning test " << __FILE__ << "\n\n";
+        std::cout << "ranks:           " << env.size << "\n";
+        std::cout << "iterations:      " << niter << " (warmup " << warmup << ")\n\n";
+        print(std::cout, results);
+        if (!json.empty())
+        {
+            std::ofstream os(json);
+            print_json(os, results, env.size);
+            if (!os) std::cerr << "failed to write " << json << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/barrier.hpp>
+#include "./mpi_environment.hpp"
+#include "./accumulator.hpp"
+#include "./utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#ifdef OOMPH_BENCHMARKS_MT
+#include <omp.h>
+#endif
+
+// Small message rate between pairs of ranks (2i, 2i+1) for sizes from 8 to 256 B, with 1 up to
+// OMP_NUM_THREADS threads per rank (OpenMP build) in powers of two. Every thread owns a
+// communicator and repeatedly exchanges a window of inflight messages with the peer rank:
+// - private: each thread exchanges with the same thread on the peer, using its own tags
+// - shared:  all threads use the same tag, such that any thread's receive may match any message
+//            from the peer, which stresses shared matching and the transport lock
+// Reported are the rates of the threads (messages sent per second, min/mean/max over all threads
+// of all ranks), the rate per rank, and the contended acquisitions of the transport lock with the
+// time spent waiting for it, relative to the run time of the threads.
+
+namespace oomph
+{
+using clock_type = std::chrono::steady_clock;
+using message = message_buffer<char>;
+
+enum class pattern
+{
+    private_tags,
+    shared_tags
+};
+
+struct thread_result
+{
+    double        seconds = 0;
+    std::uint64_t messages = 0;
+    std::uint64_t lock_waits = 0;
+    std::uint64_t lock_wait_ns = 0;
+};
+
+struct configuration
+{
+    pattern                    p;
+    int                        threads;
+    std::size_t                size;
+    std::vector<thread_result> results; // per thread
+};
+
+void
+exchange(communicator& comm, std::vector<message>& smsgs, std::vector<message>& rmsgs, int peer,
+    int tag0, int tag_stride)
+{
+    for (std::size_t j = 0; j < rmsgs.size(); ++j)
+        comm.recv(rmsgs[j], peer, tag0 + j * tag_stride, [](message&, int, int) {});
+    for (std::size_t j = 0; j < smsgs.size(); ++j)
+        comm.send(smsgs[j], peer, tag0 + j * tag_stride, [](message&, int, int) {});
+    comm.wait_all();
+}
+
+// runs all configurations with the given number of threads
+void
+run(context& ctxt, int num_threads, int niter, int inflight, int rank,
+    std::vector<configuration>& configs)
+{
+    std::vector<configuration*> mine;
+    for (auto& c : configs)
+        if (c.threads == num_threads) mine.push_back(&c);
+    barrier b(num_threads);
+
+#ifdef OOMPH_BENCHMARKS_MT
+#pragma omp parallel num_threads(num_threads)
+#endif
+    {
+        auto       comm = ctxt.get_communicator();
+        auto const thread_id = THREADID;
+        auto const peer = rank ^ 1;
+
+        for (auto c : mine)
+        {
+            std::vector<message> smsgs, rmsgs;
+            for (int j = 0; j < inflight; ++j)
+            {
+                smsgs.push_back(comm.make_buffer<char>(c->size));
+                rmsgs.push_back(comm.make_buffer<char>(c->size));
+                for (auto& x : smsgs.back()) x = 1;
+            }
+            bool const shared = c->p == pattern::shared_tags;
+            int const  tag0 = shared ? 0 : thread_id;
+            int const  stride = shared ? 0 : num_threads;
+
+            exchange(comm, smsgs, rmsgs, peer, tag0, stride);
+            auto const before = comm.stats();
+            b(comm);
+            auto const start = clock_type::now();
+            for (int i = 0; i < niter; ++i) exchange(comm, smsgs, rmsgs, peer, tag0, stride);
+            auto const end = clock_type::now();
+            auto const after = comm.stats();
+            b(comm);
+
+            auto& r = c->results[thread_id];
+            r.seconds = std::chrono::duration<double>(end - start).count();
+            r.messages = std::uint64_t(niter) * inflight;
+            r.lock_waits = after.lock_waits - before.lock_waits;
+            r.lock_wait_ns = after.lock_wait_ns - before.lock_wait_ns;
+        }
+    }
+}
+
+void
+report(configuration const& c, int mpi_rank, int mpi_size)
+{
+    accumulator   thread_rates;
+    double        seconds = 0, busy_seconds = 0;
+    std::uint64_t totals[3] = {0, 0, 0}; // messages, lock waits, lock wait ns
+    for (auto const& r : c.results)
+    {
+        thread_rates(r.messages / r.seconds);
+        seconds = std::max(seconds, r.seconds);
+        busy_seconds += r.seconds;
+        totals[0] += r.messages;
+        totals[1] += r.lock_waits;
+        totals[2] += r.lock_wait_ns;
+    }
+    double const rank_rate = totals[0] / seconds;
+
+    auto const all_rates = reduce(thread_rates, MPI_COMM_WORLD);
+    double     rank_rates[2] = {rank_rate, busy_seconds};
+    MPI_Allreduce(MPI_IN_PLACE, rank_rates, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, totals, 3, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (mpi_rank != 0) return;
+
+    auto const flags = std::cout.flags();
+    std::cout << std::setw(8) << (c.p == pattern::private_tags ? "private" : "shared")
+              << std::setw(8) << c.threads << std::setw(6) << c.size << std::fixed
+              << std::setprecision(0) << std::setw(12) << all_rates.min() << std::setw(12)
+              << all_rates.mean() << std::setw(12) << all_rates.max() << std::setw(12)
+              << rank_rates[0] / mpi_size << std::setprecision(3) << std::setw(12)
+              << double(totals[1]) / totals[0] << std::setprecision(1) << std::setw(10)
+              << 100 * (totals[2] * 1e-9) / rank_rates[1] << "\n";
+    std::cout.flags(flags);
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    if (argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " [niter] [inflight]" << std::endl;
+        std::cerr << "       run with an even number of MPI processes: e.g.: mpirun -np 2 ..."
+                  << std::endl;
+        return 1;
+    }
+    int const niter = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int const inflight = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    int max_threads = 1;
+#ifdef OOMPH_BENCHMARKS_MT
+    max_threads = omp_get_max_threads();
+#endif
+    bool const multi_threaded = (max_threads > 1);
+
+    mpi_environment env(multi_threaded, argc, argv);
+    if (env.size % 2 != 0)
+    {
+        if (env.rank == 0) std::cerr << "an even number of processes is required" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    std::vector<configuration> configs;
+    for (auto t : thread_counts)
+        for (auto p : {pattern::private_tags, pattern::shared_tags})
+            for (std::size_t size = 8; size <= 256; size *= 2)
+                configs.push_back({p, t, size, std::vector<thread_result>(t)});
+
+    {
+        context ctxt(MPI_COMM_WORLD, multi_threaded);
+        for (auto t : thread_counts) run(ctxt, t, niter, inflight, env.rank, configs);
+    }
+
+    if (env.rank == 0)
+    {
+        std::cout << "\n\nrunning test " << __FILE__ << "\n\n";
+        std::cout << "ranks:           " << env.size << "\n";
+        std::cout << "inflight:        " << inflight << "\n";
+        std::cout << "N:               " << niter << "\n";
+#if defined(OOMPH_BENCHMARKS_UCX) && defined(OOMPH_UCX_USE_SPIN_LOCK)
+        std::cout << "transport lock:  spin lock\n";
+#elif defined(OOMPH_BENCHMARKS_UCX)
+        std::cout << "transport lock:  mutex\n";
+#endif
+        std::cout << "\n"
+                  << std::setw(8) << "pattern" << std::setw(8) << "threads" << std::setw(6)
+                  << "size" << std::setw(36) << "msg/s per thread (min mean max)"
+                  << std::setw(12) << "msg/s rank" << std::setw(12) << "waits/msg"
+                  << std::setw(10) << "wait %" << "\n";
+    }
+    for (auto const& c : configs) report(c, env.rank, env.size);
+
+    return 0;
+}
@@ -98,6 +98,7 @@ main(int argc, char** argv)
         std::vector<message>      rmsgs(inflight);
         std::vector<send_request> sreqs(inflight);
         std::vector<recv_request> rreqs(inflight);
+        std::vector<std::size_t>  completed(inflight);
         for (int j = 0; j < inflight; j++)
         {
             smsgs[j] = comm.make_buffer<char>(buff_size);
@@ -115,6 +116,16 @@ main(int argc, char** argv)
             t1.tic();
         }
 
+        // post the initial receives, the slots are re-posted as they complete
+        for (int j = 0; j < inflight; j++)
+        {
+            submit_recv_cnt += num_threads;
+            rdbg += num_threads;
+            dbg += num_threads;
+            rreqs[j] = comm.recv(rmsgs[j], peer_rank, thread_id * inflight + j, recv_callback);
+            lrecv++;
+        }
+
         // send/recv niter messages - as soon as a slot becomes free
         while (sent < niter || received < niter)
         {
@@ -143,22 +154,22 @@ main(int argc, char** argv)
                 sdbg = 0;
             }
 
-            for (int j = 0; j < inflight; j++)
+            // one progress pass for all receives
+            const auto num_completed = comm.test_some(rreqs, completed);
+            for (std::size_t k = 0; k < num_completed; k++)
             {
-                if (rreqs[j].test())
-                {
-                    submit_recv_cnt += num_threads;
-                    rdbg += num_threads;
-                    dbg += num_threads;
-                    rreqs[j] =
-                        comm.recv(rmsgs[j], peer_rank, thread_id * inflight + j, recv_callback);
-                    lrecv++;
-                }
-                //else
-                //    comm.progress();
+                const int j = static_cast<int>(completed[k]);
+                submit_recv_cnt += num_threads;
+                rdbg += num_threads;
+                dbg += num_threads;
+                rreqs[j] = comm.recv(rmsgs[j], peer_rank, thread_id * inflight + j, recv_callback);
+                lrecv++;
+            }
 
+            for (int j = 0; j < inflight; j++)
+            {
                 // if(lsent < lrecv+2*inflight && sent < niter && smsgs[j].use_count() == 1)
-                if (lsent < lrecv + 2 * inflight && sent < niter && (sreqs[j].test()))
+                if (lsent < lrecv + 2 * inflight && sent < niter && (sreqs[j].is_ready()))
                 {
                     submit_cnt += num_threads;
                     sdbg += num_threads;
@@ -0,0 +1,133 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/barrier.hpp>
+#include "./mpi_environment.hpp"
+#include "./args.hpp"
+#include "./timer.hpp"
+#include "./utils.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Cost of wrapping long-lived application arrays with make_buffer(ptr, size) and sending them,
+// every iteration, with and without the registration cache. The cache is configured through the
+// OOMPH_REGISTRATION_CACHE_SIZE environment variable before each context is created: its size is
+// kept if given (1G otherwise) for the first context, and 0 for the second one.
+// inflight is the number of distinct arrays (per direction) wrapped in each iteration.
+
+namespace oomph
+{
+void
+run(bool use_cache, int niter, int buff_size, int inflight, int num_threads, int mpi_rank)
+{
+    using message = message_buffer<char>;
+    using clock_type = std::chrono::steady_clock;
+
+    char const*       env = std::getenv("OOMPH_REGISTRATION_CACHE_SIZE");
+    std::string const size = env ? env : "";
+    setenv("OOMPH_REGISTRATION_CACHE_SIZE", !use_cache ? "0" : env ? size.c_str() : "1G", 1);
+    context ctxt(MPI_COMM_WORLD, num_threads > 1);
+    if (env) setenv("OOMPH_REGISTRATION_CACHE_SIZE", size.c_str(), 1);
+    else
+        unsetenv("OOMPH_REGISTRATION_CACHE_SIZE");
+
+    barrier b(num_threads);
+    timer   t0;
+    double  wrap_ns = 0;
+
+#ifdef OOMPH_BENCHMARKS_MT
+#pragma omp parallel reduction(max : wrap_ns)
+#endif
+    {
+        auto       comm = ctxt.get_communicator();
+        const auto rank = comm.rank();
+        const auto size = comm.size();
+        const auto thread_id = THREADID;
+        const auto peer_rank = (rank + 1) % size;
+
+        std::vector<std::vector<char>> s_arrays(inflight, std::vector<char>(buff_size, 0));
+        std::vector<std::vector<char>> r_arrays(inflight, std::vector<char>(buff_size, 0));
+        std::vector<message>           smsgs(inflight);
+        std::vector<message>           rmsgs(inflight);
+        std::vector<send_request>      sreqs(inflight);
+        std::vector<recv_request>      rreqs(inflight);
+
+        b(comm);
+        if (thread_id == 0) t0.tic();
+
+        for (int i = 0; i < niter; ++i)
+        {
+            const auto t_wrap = clock_type::now();
+            for (int j = 0; j < inflight; j++)
+            {
+                smsgs[j] = comm.make_buffer<char>(s_arrays[j].data(), buff_size);
+                rmsgs[j] = comm.make_buffer<char>(r_arrays[j].data(), buff_size);
+            }
+            wrap_ns += std::chrono::duration<double, std::nano>(clock_type::now() - t_wrap).count();
+
+            for (int j = 0; j < inflight; j++)
+            {
+                rreqs[j] = comm.recv(rmsgs[j], peer_rank, thread_id * inflight + j);
+                sreqs[j] = comm.send(smsgs[j], peer_rank, thread_id * inflight + j);
+            }
+            comm.wait_all();
+
+            // drop the wrapped buffers: without the cache the registrations are released here
+            for (int j = 0; j < inflight; j++)
+            {
+                smsgs[j] = message{};
+                rmsgs[j] = message{};
+            }
+        }
+
+        b(comm);
+    }
+
+    const auto t = t0.toc();
+    if (mpi_rank == 0)
+    {
+        const auto num_wraps = 2.0 * niter * inflight;
+        std::cout << (use_cache ? "with cache\n" : "without cache\n");
+        std::cout << "time:                   " << t / 1000000 << "s\n";
+        std::cout << "time per iteration:     " << t / niter << "us\n";
+        std::cout << "wrap time per buffer:   " << wrap_ns / num_wraps << "ns\n";
+    }
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    args cmd_args(argc, argv);
+    if (!cmd_args) return exit(argv[0]);
+    bool const multi_threaded = (cmd_args.num_threads > 1);
+
+    mpi_environment env(multi_threaded, argc, argv);
+    if (env.size != 2) return exit(argv[0]);
+
+    if (env.rank == 0)
+    {
+        std::cout << "inflight = " << cmd_args.inflight << std::endl;
+        std::cout << "size     = " << cmd_args.buff_size << std::endl;
+        std::cout << "N        = " << cmd_args.n_iter << std::endl;
+        std::cout << "\n\nrunning test " << __FILE__ << "\n\n";
+    }
+
+    for (bool use_cache : {true, false})
+        run(use_cache, cmd_args.n_iter, cmd_args.buff_size, cmd_args.inflight,
+            cmd_args.num_threads, env.rank);
+
+    return 0;
+}
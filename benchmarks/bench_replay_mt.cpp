@@ -0,0 +1,298 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include "./mpi_environment.hpp"
+#include "../src/record_format.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Replays a recording made with OOMPH_RECORD=<prefix> (one file per rank) with the backend this
+// executable is linked to. Every recorded communicator is replayed by its own thread: operations
+// are posted with the recorded peers, tags and sizes, completions are awaited where they were
+// observed, which reproduces the dependencies between operations, and the gaps in between are
+// spent busy waiting, scaled by gap_scale. Must be run with as many ranks as were recorded.
+
+namespace oomph
+{
+using clock_type = std::chrono::steady_clock;
+using message = message_buffer<char>;
+
+std::string
+record_path(std::string const& prefix, int rank)
+{
+    return prefix + "." + std::to_string(rank) + ".rec";
+}
+
+record_file_header
+read_header(std::istream& is, std::string const& path)
+{
+    record_file_header h;
+    is.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if (!is || std::memcmp(h.m_magic, record_file_header::magic, sizeof(h.m_magic)) != 0)
+        throw std::runtime_error(path + " is not an oomph recording");
+    if (h.m_version != record_file_header::current_version)
+        throw std::runtime_error(path + " has an unsupported version");
+    return h;
+}
+
+// number of recorded ranks and the largest number of communicators of any of them, read before
+// MPI is initialized to select the thread support
+std::pair<int, std::uint32_t>
+scan_recording(std::string const& prefix)
+{
+    std::ifstream is(record_path(prefix, 0), std::ios::binary);
+    if (!is) throw std::runtime_error("cannot open " + record_path(prefix, 0));
+    auto const    size = read_header(is, record_path(prefix, 0)).m_size;
+    std::uint32_t max_streams = 0;
+    for (int r = 0; r < size; ++r)
+    {
+        auto const    path = record_path(prefix, r);
+        std::ifstream f(path, std::ios::binary);
+        if (!f) throw std::runtime_error("cannot open " + path);
+        max_streams = std::max(max_streams, read_header(f, path).m_num_streams);
+    }
+    return {size, max_streams};
+}
+
+// the headers of the recorded streams of a rank, in order of creation
+std::vector<record_stream_header>
+load_streams(std::string const& path)
+{
+    std::ifstream is(path, std::ios::binary);
+    if (!is) throw std::runtime_error("cannot open " + path);
+    auto const                        h = read_header(is, path);
+    std::vector<record_stream_header> streams(h.m_num_streams);
+    is.seekg(h.m_streams_offset);
+    is.read(reinterpret_cast<char*>(streams.data()), streams.size() * sizeof(streams[0]));
+    if (!is) throw std::runtime_error(path + " is truncated");
+    return streams;
+}
+
+// reads the records of one stream chunk by chunk, skipping the chunks of the other streams
+class stream_reader
+{
+  private:
+    std::string const         m_path;
+    std::ifstream             m_is;
+    std::uint32_t const       m_stream;
+    std::uint64_t             m_end; // of the chunks
+    std::vector<record_entry> m_chunk;
+
+  public:
+    stream_reader(std::string const& path, std::uint32_t stream)
+    : m_path{path}
+    , m_is(path, std::ios::binary)
+    , m_stream{stream}
+    , m_end{read_header(m_is, path).m_streams_offset}
+    {
+    }
+
+    // the next chunk of records, empty at the end of the stream
+    std::vector<record_entry> const& next()
+    {
+        m_chunk.clear();
+        while (m_chunk.empty() && static_cast<std::uint64_t>(m_is.tellg()) < m_end)
+        {
+            record_chunk_header h;
+            m_is.read(reinterpret_cast<char*>(&h), sizeof(h));
+            if (!m_is) break;
+            if (h.m_stream != m_stream)
+            {
+                m_is.seekg(h.m_num_records * sizeof(record_entry), std::ios::cur);
+                continue;
+            }
+            m_chunk.resize(h.m_num_records);
+            m_is.read(reinterpret_cast<char*>(m_chunk.data()), m_chunk.size() * sizeof(m_chunk[0]));
+        }
+        if (!m_is) throw std::runtime_error(m_path + " is truncated");
+        return m_chunk;
+    }
+};
+
+void
+spin(std::uint64_t ns)
+{
+    if (!ns) return;
+    auto const end = clock_type::now() + std::chrono::nanoseconds(ns);
+    while (clock_type::now() < end) {}
+}
+
+// messages and bytes sent by a replayed stream
+struct replay_totals
+{
+    std::uint64_t m_messages = 0;
+    std::uint64_t m_bytes = 0;
+};
+
+// operation posted and not yet observed to complete
+struct live_operation
+{
+    message      m_msg;
+    bool         m_send;
+    send_request m_sreq;
+    recv_request m_rreq;
+};
+
+replay_totals
+replay(communicator& comm, stream_reader& reader, double gap_scale)
+{
+    replay_totals totals;
+    // indexed by operation, such that memory is bounded by the operations in flight
+    std::unordered_map<std::uint32_t, live_operation> live;
+    // buffers are reused for operations of the same size
+    std::unordered_map<std::size_t, std::vector<message>> free_msgs;
+
+    auto const get_msg = [&](std::size_t size)
+    {
+        size = std::max<std::size_t>(size, 1);
+        auto& l = free_msgs[size];
+        if (l.empty()) return comm.make_buffer<char>(size);
+        auto m = std::move(l.back());
+        l.pop_back();
+        return m;
+    };
+
+    for (auto const* chunk = &reader.next(); !chunk->empty(); chunk = &reader.next())
+    {
+        for (auto const& r : *chunk)
+        {
+            spin(std::uint64_t(r.m_gap_ns * gap_scale));
+            switch (r.m_kind)
+            {
+            case record_kind::send:
+            {
+                auto& op = live[r.m_op];
+                op.m_msg = get_msg(r.m_bytes);
+                op.m_send = true;
+                op.m_sreq = comm.send(op.m_msg, r.m_peer, r.m_tag);
+                ++totals.m_messages;
+                totals.m_bytes += r.m_bytes;
+                break;
+            }
+            case record_kind::recv:
+            {
+                auto& op = live[r.m_op];
+                op.m_msg = get_msg(r.m_bytes);
+                op.m_send = false;
+                op.m_rreq = comm.recv(op.m_msg, r.m_peer, r.m_tag);
+                break;
+            }
+            case record_kind::complete:
+            {
+                auto const it = live.find(r.m_op);
+                if (it == live.end()) break;
+                auto& op = it->second;
+                if (op.m_send)
+                    op.m_sreq.wait();
+                else
+                    op.m_rreq.wait();
+                auto const size = op.m_msg.size();
+                free_msgs[size].push_back(std::move(op.m_msg));
+                live.erase(it);
+                break;
+            }
+            }
+        }
+    }
+
+    // operations whose completion was not recorded, e.g. cancelled receives
+    for (auto& kv : live)
+        if (!kv.second.m_send) kv.second.m_rreq.cancel();
+    comm.wait_all();
+    return totals;
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " [recording prefix] [gap_scale]" << std::endl;
+        std::cerr << "       run with as many MPI processes as were recorded" << std::endl;
+        return 1;
+    }
+    std::string const prefix = argv[1];
+    double const      gap_scale = argc > 2 ? std::atof(argv[2]) : 1.0;
+
+    auto const      shape = scan_recording(prefix);
+    bool const      multi_threaded = shape.second > 1;
+    mpi_environment env(multi_threaded, argc, argv);
+    if (env.size != shape.first)
+    {
+        if (env.rank == 0)
+            std::cerr << "recording has " << shape.first << " ranks, running with " << env.size
+                      << std::endl;
+        return 1;
+    }
+
+    auto const    path = record_path(prefix, env.rank);
+    auto const    streams = load_streams(path);
+    std::uint64_t recorded_ns = 0;
+    for (auto const& s : streams) recorded_ns = std::max(recorded_ns, s.m_elapsed_ns);
+
+    {
+        context                    ctxt(MPI_COMM_WORLD, multi_threaded);
+        std::vector<communicator>  comms;
+        std::vector<stream_reader> readers;
+        for (std::uint32_t i = 0; i < streams.size(); ++i)
+        {
+            comms.push_back(ctxt.get_communicator());
+            readers.emplace_back(path, i);
+        }
+        std::vector<replay_totals> totals(streams.size());
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto const               start = clock_type::now();
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < streams.size(); ++i)
+            threads.emplace_back([&, i]()
+                { totals[i] = replay(comms[i], readers[i], gap_scale); });
+        if (!streams.empty()) totals[0] = replay(comms[0], readers[0], gap_scale);
+        for (auto& t : threads) t.join();
+        double const replayed_ns =
+            std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+
+        double times[2] = {(double)recorded_ns, replayed_ns};
+        MPI_Allreduce(MPI_IN_PLACE, times, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        std::uint64_t sums[2] = {0, 0};
+        for (auto const& t : totals)
+        {
+            sums[0] += t.m_messages;
+            sums[1] += t.m_bytes;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, sums, 2, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+        if (env.rank == 0)
+        {
+            std::cout << "ranks:           " << env.size << "\n";
+            std::cout << "messages:        " << sums[0] << "\n";
+            std::cout << "bytes:           " << sums[1] << "\n";
+            std::cout << "gap scale:       " << gap_scale << "\n";
+            std::cout << "recorded time:   " << times[0] / 1e9 << "s\n";
+            std::cout << "replayed time:   " << times[1] / 1e9 << "s\n";
+        }
+    }
+
+    return 0;
+}
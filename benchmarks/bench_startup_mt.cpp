@@ -0,0 +1,212 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/tool.hpp>
+#include "./mpi_environment.hpp"
+#include "./accumulator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Cost of creating and destroying a context, for ensembles of many short runs. Contexts are
+// created on the first n ranks of the world for n = 2, 4, 8, ... up to all ranks, such that a
+// single (possibly oversubscribed) run shows the scaling with the number of ranks. Every
+// repetition times
+// - the phases of setup and teardown reported through the tool interface (which phases there are
+//   depends on the transport layer: rank topology, clock synchronization, heaps, RMA window,
+//   worker creation and address exchange, endpoint closing and the teardown barriers, ...)
+// - the whole construction and destruction; "other" is the part not covered by any phase, e.g.
+//   freeing the RMA window or the workers
+// - the first message after construction: one exchange along a ring, including the creation of
+//   the communicator and of the endpoints, compared to a second exchange
+// Reported are mean and max over repetitions and ranks, in milliseconds.
+
+namespace oomph
+{
+using clock_type = std::chrono::steady_clock;
+
+constexpr int tag = 7;
+
+struct phase_samples
+{
+    std::string name;
+    accumulator ms;
+};
+
+// phases in order of first appearance
+struct phase_table
+{
+    std::vector<phase_samples> phases;
+
+    accumulator& operator[](std::string const& name)
+    {
+        auto it = std::find_if(phases.begin(), phases.end(),
+            [&name](auto const& p) { return p.name == name; });
+        if (it != phases.end()) return it->ms;
+        phases.push_back({name, accumulator{}});
+        return phases.back().ms;
+    }
+};
+
+struct reported_phase
+{
+    char const* name;
+    double      ms;
+};
+
+// filled by the tool hook, while a context is created or destroyed
+std::vector<reported_phase> g_reported;
+
+void
+record_phase(void*, tool::phase_info const& p)
+{
+    g_reported.push_back({p.name, p.duration_ns * 1e-6});
+}
+
+double
+ms_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+// one message to the next rank along a ring
+void
+ring_exchange(communicator& comm, message_buffer<char>& smsg, message_buffer<char>& rmsg)
+{
+    auto r = comm.recv(rmsg, (comm.rank() + comm.size() - 1) % comm.size(), tag);
+    comm.send(smsg, (comm.rank() + 1) % comm.size(), tag).wait();
+    r.wait();
+}
+
+// adds the reported phases to the table, returns their sum
+double
+collect(phase_table& t)
+{
+    double sum = 0;
+    for (auto const& p : g_reported)
+    {
+        t[p.name](p.ms);
+        sum += p.ms;
+    }
+    g_reported.clear();
+    return sum;
+}
+
+void
+run(MPI_Comm mpi_comm, int reps, phase_table& setup, phase_table& teardown, phase_table& totals)
+{
+    for (int i = 0; i < reps; ++i)
+    {
+        std::optional<context> ctxt;
+        MPI_Barrier(mpi_comm);
+        auto start = clock_type::now();
+        ctxt.emplace(mpi_comm, false);
+        auto ms = ms_since(start);
+        totals["construct"](ms);
+        ms -= collect(setup);
+        setup["other"](ms);
+
+        {
+            start = clock_type::now();
+            auto comm = ctxt->get_communicator();
+            auto smsg = comm.make_buffer<char>(8);
+            auto rmsg = comm.make_buffer<char>(8);
+            ring_exchange(comm, smsg, rmsg);
+            totals["first message"](ms_since(start));
+            start = clock_type::now();
+            ring_exchange(comm, smsg, rmsg);
+            totals["second message"](ms_since(start));
+        }
+
+        start = clock_type::now();
+        ctxt.reset();
+        ms = ms_since(start);
+        totals["destroy"](ms);
+        ms -= collect(teardown);
+        teardown["other"](ms);
+    }
+}
+
+void
+report(int n, char const* section, phase_table const& t, MPI_Comm comm, int rank)
+{
+    for (auto const& p : t.phases)
+    {
+        auto const all = reduce(p.ms, comm);
+        if (rank != 0) continue;
+        auto const flags = std::cout.flags();
+        std::cout << std::setw(8) << n << std::setw(10) << section << std::setw(20) << p.name
+                  << std::fixed << std::setprecision(3) << std::setw(12) << all.mean()
+                  << std::setw(12) << all.max() << "\n";
+        std::cout.flags(flags);
+    }
+}
+
+} // namespace oomph
+
+int
+main(int argc, char** argv)
+{
+    using namespace oomph;
+
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [repetitions]" << std::endl;
+        std::cerr << "       run with any number of MPI processes: e.g.: mpirun -np 8 ..."
+                  << std::endl;
+        return 1;
+    }
+    int const reps = argc > 1 ? std::atoi(argv[1]) : 10;
+
+    mpi_environment env(false, argc, argv);
+
+    tool::hooks h;
+    h.phase = &record_phase;
+    tool::attach_tool(h);
+
+    std::vector<int> counts;
+    for (int n = 2; n < env.size; n *= 2) counts.push_back(n);
+    counts.push_back(env.size);
+
+    if (env.rank == 0)
+    {
+        std::cout << "\n\nrunning test " << __FILE__ << "\n\n";
+        std::cout << "ranks:           " << env.size << "\n";
+        std::cout << "repetitions:     " << reps << "\n\n";
+        std::cout << std::setw(8) << "ranks" << std::setw(10) << "section" << std::setw(20)
+                  << "phase" << std::setw(12) << "mean" << std::setw(12) << "max"
+                  << "  (ms)\n";
+    }
+
+    for (auto n : counts)
+    {
+        // the ranks outside of the first n wait for the next round
+        MPI_Comm comm;
+        MPI_Comm_split(MPI_COMM_WORLD, env.rank < n ? 0 : MPI_UNDEFINED, env.rank, &comm);
+        if (comm != MPI_COMM_NULL)
+        {
+            phase_table setup, teardown, totals;
+            run(comm, reps, setup, teardown, totals);
+            report(n, "setup", setup, comm, env.rank);
+            report(n, "teardown", teardown, comm, env.rank);
+            report(n, "total", totals, comm, env.rank);
+            MPI_Comm_free(&comm);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    tool::detach_tool();
+    return 0;
+}
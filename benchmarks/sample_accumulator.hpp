@@ -0,0 +1,120 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "./accumulator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace oomph
+{
+/** @brief accumulator which also keeps the samples, such that quantiles can be computed */
+class sample_accumulator : public accumulator
+{
+  private: // member types
+    using base = accumulator;
+
+  private: // members
+    mutable std::vector<value_type> m_samples;
+    mutable bool                    m_sorted = true;
+
+  public: // ctors
+    sample_accumulator() = default;
+    sample_accumulator(const sample_accumulator&) = default;
+    sample_accumulator(sample_accumulator&&) noexcept = default;
+    sample_accumulator& operator=(const sample_accumulator&) = default;
+    sample_accumulator& operator=(sample_accumulator&&) noexcept = default;
+
+  public: // return statistics
+    const std::vector<value_type>& samples() const noexcept { return m_samples; }
+
+    /** @brief nearest-rank quantile
+              * @param q quantile in [0, 1]
+              * @return smallest sample such that a fraction q of the samples is not larger, 0 if
+              * there are no samples */
+    value_type quantile(double q) const
+    {
+        if (m_samples.empty()) return 0;
+        if (!m_sorted)
+        {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+        auto const n = m_samples.size();
+        auto const rank = static_cast<size_type>(std::ceil(q * n));
+        return m_samples[std::min(std::max<size_type>(rank, 1), n) - 1];
+    }
+
+  public: // add samples
+    /** @brief reserve room for samples
+              * @param n number of samples */
+    void reserve(size_type n) { m_samples.reserve(n); }
+
+    /** @brief accumulate one sample
+              * @param sample a sample
+              * @return reference to this object */
+    sample_accumulator& operator()(value_type sample)
+    {
+        base::operator()(sample);
+        m_samples.push_back(sample);
+        m_sorted = false;
+        return *this;
+    }
+
+    /** @brief accumulate another accumulator including its samples
+              * @param other another accumulator object
+              * @return reference to this object */
+    sample_accumulator& operator()(const sample_accumulator& other)
+    {
+        base::operator()(static_cast<const base&>(other));
+        m_samples.insert(m_samples.end(), other.m_samples.begin(), other.m_samples.end());
+        m_sorted = m_samples.empty();
+        return *this;
+    }
+
+  public:
+    /** @brief reset accumulator */
+    void clear() noexcept
+    {
+        base::clear();
+        m_samples.clear();
+        m_sorted = true;
+    }
+};
+
+/** @brief all-reduce sample accumulators over the MPI group defined by the communicator
+          * @param acc accumulator local to each rank
+          * @param comm MPI communicator
+          * @return combined accumulator holding the samples of all ranks */
+sample_accumulator
+reduce(const sample_accumulator& acc, MPI_Comm comm)
+{
+    int size;
+    MPI_Comm_size(comm, &size);
+    int              n = acc.samples().size();
+    std::vector<int> counts(size), offsets(size);
+    MPI_Allgather(&n, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+    int total = 0;
+    for (int r = 0; r < size; ++r)
+    {
+        offsets[r] = total;
+        total += counts[r];
+    }
+    std::vector<double> samples(total);
+    MPI_Allgatherv(acc.samples().data(), n, MPI_DOUBLE, samples.data(), counts.data(),
+        offsets.data(), MPI_DOUBLE, comm);
+    sample_accumulator acc_all;
+    acc_all.reserve(total);
+    for (auto x : samples) acc_all(x);
+    return acc_all;
+}
+
+} // namespace oomph
@@ -17,13 +17,22 @@ find_library(UCP_LIBRARY HINT ${UCP_DIR} NAMES ucp
     ${UCP_DIR}   ENV UCX_DIR
     PATH_SUFFIXES lib lib64)
 
+# optional: memory hooks (ucm) are used for invalidating registrations of unmapped memory
+find_library(UCM_LIBRARY NAMES ucm
+    HINTS
+    ${UCX_ROOT}  ENV UCX_ROOT
+    ${UCX_DIR}   ENV UCX_DIR
+    ${UCP_ROOT}  ENV UCX_ROOT
+    ${UCP_DIR}   ENV UCX_DIR
+    PATH_SUFFIXES lib lib64)
+
 set(UCP_LIBRARIES    ${UCP_LIBRARY} CACHE INTERNAL "")
 set(UCP_INCLUDE_DIRS ${UCP_INCLUDE_DIR} CACHE INTERNAL "")
 
 include(FindPackageHandleStandardArgs)
 find_package_handle_standard_args(UCP DEFAULT_MSG UCP_LIBRARY UCP_INCLUDE_DIR)
 
-mark_as_advanced(UCX_ROOT UCP_LIBRARY UCP_INCLUDE_DIR)
+mark_as_advanced(UCX_ROOT UCP_LIBRARY UCM_LIBRARY UCP_INCLUDE_DIR)
 
 if(NOT TARGET UCP::libucp AND UCP_FOUND)
   add_library(UCP::libucp SHARED IMPORTED)
@@ -32,3 +41,11 @@ if(NOT TARGET UCP::libucp AND UCP_FOUND)
     INTERFACE_INCLUDE_DIRECTORIES ${UCP_INCLUDE_DIR}
   )
 endif()
+
+if(NOT TARGET UCP::libucm AND UCP_FOUND AND UCM_LIBRARY)
+  add_library(UCP::libucm SHARED IMPORTED)
+  set_target_properties(UCP::libucm PROPERTIES
+    IMPORTED_LOCATION ${UCM_LIBRARY}
+    INTERFACE_INCLUDE_DIRECTORIES ${UCP_INCLUDE_DIR}
+  )
+endif()
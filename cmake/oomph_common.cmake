@@ -4,6 +4,8 @@
 set(OOMPH_USE_FAST_PIMPL OFF CACHE BOOL "store private implementations on stack")
 mark_as_advanced(OOMPH_USE_FAST_PIMPL)
 
+set(OOMPH_ENABLE_TRACING OFF CACHE BOOL "compile in the event tracer (see OOMPH_TRACE_FILE)")
+
 # ---------------------------------------------------------------------
 # compiler and linker flags
 # ---------------------------------------------------------------------
@@ -19,6 +19,20 @@ if (OOMPH_WITH_UCX)
         target_compile_definitions(oomph_ucx PRIVATE OOMPH_UCX_USE_PMI)
     endif()
 
+    # cached registrations of user memory are invalidated through the ucm memory hooks
+    if (TARGET UCP::libucm)
+        set(OOMPH_UCX_USE_MEMORY_HOOKS ON CACHE BOOL "invalidate cached registrations on unmap")
+    else()
+        set(OOMPH_UCX_USE_MEMORY_HOOKS OFF CACHE BOOL "invalidate cached registrations on unmap")
+    endif()
+    if (OOMPH_UCX_USE_MEMORY_HOOKS)
+        if (NOT TARGET UCP::libucm)
+            message(FATAL_ERROR "OOMPH_UCX_USE_MEMORY_HOOKS requires the ucm library")
+        endif()
+        target_link_libraries(oomph_ucx PRIVATE UCP::libucm)
+        target_compile_definitions(oomph_ucx PRIVATE OOMPH_UCX_USE_MEMORY_HOOKS)
+    endif()
+
     set(OOMPH_UCX_USE_SPIN_LOCK OFF CACHE BOOL "use pthread spin locks")
     if (OOMPH_UCX_USE_SPIN_LOCK)
         find_package(Threads REQUIRED)
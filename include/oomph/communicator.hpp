@@ -10,10 +10,17 @@
 #pragma once
 
 #include <oomph/message_buffer.hpp>
+#include <oomph/message_view.hpp>
+#include <oomph/iov.hpp>
 #include <oomph/request.hpp>
+#include <oomph/shared_request.hpp>
+#include <oomph/completion_queue.hpp>
+#include <oomph/stats.hpp>
+#include <oomph/latency.hpp>
 #include <oomph/util/mpi_error.hpp>
 #include <oomph/detail/communicator_helper.hpp>
 #include <oomph/util/unique_function.hpp>
+#include <oomph/util/span.hpp>
 #include <hwmalloc/device.hpp>
 #include <functional>
 #include <vector>
@@ -29,6 +36,14 @@ class recv_channel_base;
 
 class communicator_impl;
 
+/** @brief where the callbacks of send and recv operations are invoked */
+enum class callback_execution
+{
+    immediate,  // during progress, by the thread progressing the communicator (default)
+    deferred,   // by run_deferred_callbacks or a blocking wait, on the owning thread
+    thread_pool // by a thread pool shared by all communicators of the context
+};
+
 class communicator
 {
   public:
@@ -53,9 +68,11 @@ class communicator
     };
 
   private:
-    impl_type*                     m_impl;
-    std::unique_ptr<boost::pool<>> m_pool;
-    std::unique_ptr<schedule>      m_schedule;
+    impl_type*                                m_impl;
+    std::unique_ptr<boost::pool<>>            m_pool;
+    std::unique_ptr<schedule>                 m_schedule;
+    std::unique_ptr<detail::completion_queue> m_cq;
+    callback_execution                        m_execution = callback_execution::immediate;
 
   private:
     struct cb_none
@@ -64,11 +81,36 @@ class communicator
 
         void operator()() noexcept
         {
-            req->m_ready = true;
+            req->set_ready();
             --(*(req->m_scheduled));
         }
     };
 
+    struct cb_shared
+    {
+        std::size_t*   scheduled;
+        shared_request req;
+
+        void operator()()
+        {
+            --(*scheduled);
+            req.m->set_ready();
+        }
+    };
+
+    struct cb_cq
+    {
+        detail::completion_queue* q;
+        std::size_t*              scheduled;
+        completion                c;
+
+        void operator()() noexcept
+        {
+            q->push(c);
+            --(*scheduled);
+        }
+    };
+
     template<typename T, typename CallBack>
     struct cb_rref
     {
@@ -78,10 +120,12 @@ class communicator
         tag_type           t;
         CallBack           cb;
 
+        void invoke() { cb(std::move(m), r, t); }
+
         void operator()() noexcept
         {
-            cb(std::move(m), r, t);
-            req->m_ready = true;
+            invoke();
+            req->set_ready();
             --(*(req->m_scheduled));
         }
     };
@@ -95,10 +139,12 @@ class communicator
         tag_type           t;
         CallBack           cb;
 
+        void invoke() { cb(*m, r, t); }
+
         void operator()() noexcept
         {
-            cb(*m, r, t);
-            req->m_ready = true;
+            invoke();
+            req->set_ready();
             --(*(req->m_scheduled));
         }
     };
@@ -112,18 +158,61 @@ class communicator
         tag_type                 t;
         CallBack                 cb;
 
+        void invoke() { cb(*m, r, t); }
+
         void operator()() noexcept
         {
-            cb(*m, r, t);
-            req->m_ready = true;
+            invoke();
+            req->set_ready();
             --(*(req->m_scheduled));
         }
     };
 
+    template<typename T, typename CallBack>
+    struct cb_view
+    {
+        shared_request_ptr req;
+        message_view<T>    m;
+        rank_type          r;
+        tag_type           t;
+        CallBack           cb;
+
+        void invoke() { cb(m, r, t); }
+
+        void operator()() noexcept
+        {
+            invoke();
+            req->set_ready();
+            --(*(req->m_scheduled));
+        }
+    };
+
+    // callback which is not invoked immediately on completion, see callback_execution
+    template<typename CallBack>
+    struct cb_offload
+    {
+        impl_type*         impl;
+        callback_execution e;
+        CallBack           cb;
+
+        void operator()()
+        {
+            if (e == callback_execution::deferred) defer_callback(impl, std::move(cb));
+            else
+                offload_callback(impl,
+                    [impl = impl, cb = std::move(cb)]() mutable
+                    {
+                        cb.invoke();
+                        complete_offloaded(impl, std::move(cb.req));
+                    });
+        }
+    };
+
   private:
     communicator(impl_type* impl_) noexcept
     : m_impl{impl_}
-    , m_pool{std::make_unique<boost::pool<>>(sizeof(detail::request_state), 128)}
+    , m_pool{std::make_unique<boost::pool<>>(
+          sizeof(detail::request_state), detail::request_pool_start_size)}
     , m_schedule{std::make_unique<schedule>()}
     {
     }
@@ -135,6 +224,8 @@ class communicator
     : m_impl{std::exchange(other.m_impl, nullptr)}
     , m_pool{std::move(other.m_pool)}
     , m_schedule{std::move(other.m_schedule)}
+    , m_cq{std::move(other.m_cq)}
+    , m_execution{other.m_execution}
     {
     }
 
@@ -145,6 +236,8 @@ class communicator
         m_impl = std::exchange(other.m_impl, nullptr);
         m_pool = std::move(other.m_pool);
         m_schedule = std::move(other.m_schedule);
+        m_cq = std::move(other.m_cq);
+        m_execution = other.m_execution;
         return *this;
     }
 
@@ -159,10 +252,13 @@ class communicator
     std::size_t scheduled_recvs() const noexcept { return m_schedule->scheduled_recvs; }
     bool is_ready() const noexcept { return (scheduled_sends() == 0) && (scheduled_recvs() == 0); }
 
-    void wait_all()
-    {
-        while (!is_ready()) { progress(); }
-    }
+    /** @brief snapshot of the counters of this communicator, see communication_stats */
+    communication_stats stats() const;
+
+    /** @brief latency from posting to completion of the operations with each peer, by rank */
+    std::vector<peer_latency> latency() const;
+
+    void wait_all();
 
     template<typename T>
     message_buffer<T> make_buffer(std::size_t size)
@@ -208,7 +304,7 @@ class communicator
         auto& scheduled = m_schedule->scheduled_recvs;
         ++scheduled;
         recv_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
-        recv(msg.m.m_heap_ptr.get(), msg.size() * sizeof(T), src, tag, cb_none{r.m_data}, r.m_data);
+        recv(msg.m.m_heap_ptr.get(), 0, msg.size() * sizeof(T), src, tag, &scheduled, r.m_data);
         return r;
     }
 
@@ -219,10 +315,190 @@ class communicator
         auto& scheduled = m_schedule->scheduled_sends;
         ++scheduled;
         send_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
-        send(msg.m.m_heap_ptr.get(), msg.size() * sizeof(T), dst, tag, cb_none{r.m_data}, r.m_data);
+        send(msg.m.m_heap_ptr.get(), 0, msg.size() * sizeof(T), dst, tag, &scheduled, r.m_data);
         return r;
     }
 
+    template<typename T>
+    [[nodiscard]] recv_request recv(message_view<T> const& v, rank_type src, tag_type tag)
+    {
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_recvs;
+        ++scheduled;
+        recv_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
+        recv(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), src, tag, &scheduled, r.m_data);
+        return r;
+    }
+
+    template<typename T>
+    [[nodiscard]] send_request send(message_view<T> const& v, rank_type dst, tag_type tag)
+    {
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_sends;
+        ++scheduled;
+        send_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
+        send(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), dst, tag, &scheduled, r.m_data);
+        return r;
+    }
+
+    // shared request versions
+    // =======================
+    // The returned requests may be used from other threads, see shared_request.hpp. They cannot
+    // be cancelled.
+
+    template<typename T>
+    [[nodiscard]] shared_request recv_shared(message_buffer<T>& msg, rank_type src, tag_type tag)
+    {
+        assert(msg);
+        auto& scheduled = m_schedule->scheduled_recvs;
+        ++scheduled;
+        shared_request r(m_impl, std::this_thread::get_id());
+        recv(msg.m.m_heap_ptr.get(), msg.size() * sizeof(T), src, tag, cb_shared{&scheduled, r},
+            shared_request_ptr{});
+        return r;
+    }
+
+    template<typename T>
+    [[nodiscard]] shared_request send_shared(message_buffer<T> const& msg, rank_type dst,
+        tag_type tag)
+    {
+        assert(msg);
+        auto& scheduled = m_schedule->scheduled_sends;
+        ++scheduled;
+        shared_request r(m_impl, std::this_thread::get_id());
+        send(msg.m.m_heap_ptr.get(), msg.size() * sizeof(T), dst, tag, cb_shared{&scheduled, r},
+            shared_request_ptr{});
+        return r;
+    }
+
+    template<typename T>
+    [[nodiscard]] shared_request recv_shared(message_view<T> const& v, rank_type src,
+        tag_type tag)
+    {
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_recvs;
+        ++scheduled;
+        shared_request r(m_impl, std::this_thread::get_id());
+        recv(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), src, tag, cb_shared{&scheduled, r},
+            shared_request_ptr{});
+        return r;
+    }
+
+    template<typename T>
+    [[nodiscard]] shared_request send_shared(message_view<T> const& v, rank_type dst,
+        tag_type tag)
+    {
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_sends;
+        ++scheduled;
+        shared_request r(m_impl, std::this_thread::get_id());
+        send(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), dst, tag, cb_shared{&scheduled, r},
+            shared_request_ptr{});
+        return r;
+    }
+
+    // detached versions
+    // =================
+    // No request is created: completion is only reflected by scheduled_sends(). The message must
+    // be kept alive until then, e.g. until wait_all() returns.
+
+    template<typename T>
+    void send_detached(message_buffer<T> const& msg, rank_type dst, tag_type tag)
+    {
+        assert(msg);
+        auto& scheduled = m_schedule->scheduled_sends;
+        ++scheduled;
+        send(msg.m.m_heap_ptr.get(), 0, msg.size() * sizeof(T), dst, tag, &scheduled,
+            shared_request_ptr{});
+    }
+
+    template<typename T>
+    void send_detached(message_view<T> const& v, rank_type dst, tag_type tag)
+    {
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_sends;
+        ++scheduled;
+        send(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), dst, tag, &scheduled,
+            shared_request_ptr{});
+    }
+
+    // completion queue versions
+    // =========================
+    // No request is created: the completion of the operation is recorded in the completion queue
+    // of the communicator, which must have been enabled with enable_completion_queue(). The records
+    // are retrieved with poll_completions(). The message must be kept alive until then.
+
+    /**
+     * @brief enable the completion queue with room for capacity records
+     *
+     * The capacity bounds the number of operations which are outstanding or whose records have not
+     * been polled yet. The queue can only be resized while it is empty.
+     */
+    void enable_completion_queue(std::size_t capacity);
+
+    /**
+     * @brief progress once and retrieve completion records
+     * @return number of records stored in out, oldest first
+     */
+    std::size_t poll_completions(util::span<completion> out);
+
+    template<typename T>
+    void post_recv(message_buffer<T>& msg, rank_type src, tag_type tag, void* cookie = nullptr)
+    {
+        assert(msg);
+        auto const bytes = msg.size() * sizeof(T);
+        post_cq(m_schedule->scheduled_recvs,
+            {cookie, src, tag, bytes, completion_kind::recv, completion_status::success},
+            [&](cb_cq&& cb)
+            {
+                recv(msg.m.m_heap_ptr.get(), bytes, src, tag, std::move(cb),
+                    shared_request_ptr{});
+            });
+    }
+
+    template<typename T>
+    void post_send(message_buffer<T> const& msg, rank_type dst, tag_type tag,
+        void* cookie = nullptr)
+    {
+        assert(msg);
+        auto const bytes = msg.size() * sizeof(T);
+        post_cq(m_schedule->scheduled_sends,
+            {cookie, dst, tag, bytes, completion_kind::send, completion_status::success},
+            [&](cb_cq&& cb)
+            {
+                send(msg.m.m_heap_ptr.get(), bytes, dst, tag, std::move(cb),
+                    shared_request_ptr{});
+            });
+    }
+
+    template<typename T>
+    void post_recv(message_view<T> const& v, rank_type src, tag_type tag, void* cookie = nullptr)
+    {
+        assert(v);
+        auto const bytes = v.size() * sizeof(T);
+        post_cq(m_schedule->scheduled_recvs,
+            {cookie, src, tag, bytes, completion_kind::recv, completion_status::success},
+            [&](cb_cq&& cb)
+            {
+                recv(v.m_heap_ptr, v.m_offset, bytes, src, tag, std::move(cb),
+                    shared_request_ptr{});
+            });
+    }
+
+    template<typename T>
+    void post_send(message_view<T> const& v, rank_type dst, tag_type tag, void* cookie = nullptr)
+    {
+        assert(v);
+        auto const bytes = v.size() * sizeof(T);
+        post_cq(m_schedule->scheduled_sends,
+            {cookie, dst, tag, bytes, completion_kind::send, completion_status::success},
+            [&](cb_cq&& cb)
+            {
+                send(v.m_heap_ptr, v.m_offset, bytes, dst, tag, std::move(cb),
+                    shared_request_ptr{});
+            });
+    }
+
     template<typename T>
     [[nodiscard]] send_request send_multi(message_buffer<T> const& msg,
         std::vector<rank_type> const& neighs, tag_type tag)
@@ -245,7 +521,7 @@ class communicator
                     if ((--(*counter)) == 0)
                     {
                         delete counter;
-                        rd->m_ready = true;
+                        rd->set_ready();
                     }
                     --(*(rd->m_scheduled));
                 },
@@ -254,6 +530,17 @@ class communicator
         return r;
     }
 
+    // scatter/gather versions
+    // =======================
+    // The pieces are transferred as one logical message and can be matched by a contiguous
+    // send/recv of the same total size on the peer.
+
+    [[nodiscard]] recv_request recv_iov(std::vector<iov_element> const& iov, rank_type src,
+        tag_type tag);
+
+    [[nodiscard]] send_request send_iov(std::vector<iov_element> const& iov, rank_type dst,
+        tag_type tag);
+
     // callback versions
     // =================
 
@@ -266,12 +553,11 @@ class communicator
         ++scheduled;
         recv_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
         const auto   s = msg.size();
-        auto         m_ptr = msg.m.m_heap_ptr.get();
+        auto         cb = make_callback(cb_rref<T, std::decay_t<CallBack>>{
+            r.m_data, std::move(msg), src, tag, std::forward<CallBack>(callback)});
+        auto         m_ptr = held_message<cb_rref<T, std::decay_t<CallBack>>>(cb).m_heap_ptr.get();
 
-        recv(m_ptr, s * sizeof(T), src, tag,
-            cb_rref<T, std::decay_t<CallBack>>{r.m_data, std::move(msg), src, tag,
-                std::forward<CallBack>(callback)},
-            r.m_data);
+        recv(m_ptr, s * sizeof(T), src, tag, std::move(cb), r.m_data);
         return r;
     }
 
@@ -287,8 +573,8 @@ class communicator
         auto         m_ptr = msg.m.m_heap_ptr.get();
 
         recv(m_ptr, s * sizeof(T), src, tag,
-            cb_lref<T, std::decay_t<CallBack>>{r.m_data, &msg, src, tag,
-                std::forward<CallBack>(callback)},
+            make_callback(cb_lref<T, std::decay_t<CallBack>>{
+                r.m_data, &msg, src, tag, std::forward<CallBack>(callback)}),
             r.m_data);
         return r;
     }
@@ -302,12 +588,11 @@ class communicator
         ++scheduled;
         send_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
         const auto   s = msg.size();
-        auto         m_ptr = msg.m.m_heap_ptr.get();
+        auto         cb = make_callback(cb_rref<T, std::decay_t<CallBack>>{
+            r.m_data, std::move(msg), dst, tag, std::forward<CallBack>(callback)});
+        auto         m_ptr = held_message<cb_rref<T, std::decay_t<CallBack>>>(cb).m_heap_ptr.get();
 
-        send(m_ptr, s * sizeof(T), dst, tag,
-            cb_rref<T, std::decay_t<CallBack>>{r.m_data, std::move(msg), dst, tag,
-                std::forward<CallBack>(callback)},
-            r.m_data);
+        send(m_ptr, s * sizeof(T), dst, tag, std::move(cb), r.m_data);
         return r;
     }
 
@@ -323,8 +608,8 @@ class communicator
         auto         m_ptr = msg.m.m_heap_ptr.get();
 
         send(m_ptr, s * sizeof(T), dst, tag,
-            cb_lref<T, std::decay_t<CallBack>>{r.m_data, &msg, dst, tag,
-                std::forward<CallBack>(callback)},
+            make_callback(cb_lref<T, std::decay_t<CallBack>>{
+                r.m_data, &msg, dst, tag, std::forward<CallBack>(callback)}),
             r.m_data);
         return r;
     }
@@ -342,8 +627,40 @@ class communicator
         auto         m_ptr = msg.m.m_heap_ptr.get();
 
         send(m_ptr, s * sizeof(T), dst, tag,
-            cb_lref_const<T, std::decay_t<CallBack>>{r.m_data, &msg, dst, tag,
-                std::forward<CallBack>(callback)},
+            make_callback(cb_lref_const<T, std::decay_t<CallBack>>{
+                r.m_data, &msg, dst, tag, std::forward<CallBack>(callback)}),
+            r.m_data);
+        return r;
+    }
+
+    template<typename T, typename CallBack>
+    recv_request recv(message_view<T> const& v, rank_type src, tag_type tag, CallBack&& callback)
+    {
+        OOMPH_CHECK_CALLBACK_VIEW(CallBack)
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_recvs;
+        ++scheduled;
+        recv_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
+
+        recv(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), src, tag,
+            make_callback(cb_view<T, std::decay_t<CallBack>>{
+                r.m_data, v, src, tag, std::forward<CallBack>(callback)}),
+            r.m_data);
+        return r;
+    }
+
+    template<typename T, typename CallBack>
+    send_request send(message_view<T> const& v, rank_type dst, tag_type tag, CallBack&& callback)
+    {
+        OOMPH_CHECK_CALLBACK_VIEW(CallBack)
+        assert(v);
+        auto& scheduled = m_schedule->scheduled_sends;
+        ++scheduled;
+        send_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
+
+        send(v.m_heap_ptr, v.m_offset, v.size() * sizeof(T), dst, tag,
+            make_callback(cb_view<T, std::decay_t<CallBack>>{
+                r.m_data, v, dst, tag, std::forward<CallBack>(callback)}),
             r.m_data);
         return r;
     }
@@ -365,8 +682,8 @@ class communicator
 
         send_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
         const auto   s = msg.size();
-        auto         m_ptr = msg.m.m_heap_ptr.get();
         auto         m = new msg_ref_count{std::move(msg), {(int)neighs.size()}, neighs};
+        auto         m_ptr = m->msg.m.m_heap_ptr.get();
 
         for (auto id : neighs)
         {
@@ -378,7 +695,7 @@ class communicator
                     {
                         cb(std::move(m->msg), std::move(m->neighs), tag);
                         delete m;
-                        rd->m_ready = true;
+                        rd->set_ready();
                     }
                     --(*(rd->m_scheduled));
                 },
@@ -417,7 +734,7 @@ class communicator
                     {
                         cb(*(m->msg), std::move(m->neighs), tag);
                         delete m;
-                        rd->m_ready = true;
+                        rd->set_ready();
                     }
                     --(*(rd->m_scheduled));
                 },
@@ -456,7 +773,7 @@ class communicator
                     {
                         cb(*(m->msg), std::move(m->neighs), tag);
                         delete m;
-                        rd->m_ready = true;
+                        rd->set_ready();
                     }
                     --(*(rd->m_scheduled));
                 },
@@ -467,7 +784,89 @@ class communicator
 
     void progress();
 
+    // callback execution
+    // ==================
+    // The policy applies to callbacks of operations posted afterwards (send_multi excepted, whose
+    // callbacks are always invoked immediately). The request of an operation becomes ready once its
+    // callback has returned: deferred callbacks are run by run_deferred_callbacks and by the test
+    // and wait functions of requests and request sets, but not by progress. Callbacks run by the
+    // thread pool must not use the communicator, and message buffers they release are freed on the
+    // pool threads, which requires a thread safe context. The pool size is set with the environment
+    // variable OOMPH_CALLBACK_THREADS.
+
+    void               set_callback_execution(callback_execution e) noexcept;
+    callback_execution get_callback_execution() const noexcept { return m_execution; }
+
+    /** @brief run the deferred callbacks of completed operations, returns their number */
+    std::size_t run_deferred_callbacks();
+
+    // request sets
+    // ============
+    // One progress pass serves the whole set of requests, which must have been issued by this
+    // communicator. Completed requests are reported by their index and reset, and empty requests
+    // are ignored (like MPI_REQUEST_NULL).
+
+    /**
+     * @brief progress once and collect completed requests
+     * @return number of completed requests, whose indices are stored in indices. If there are
+     * more than indices.size(), the remaining ones are left untouched and reported next time.
+     */
+    std::size_t test_some(util::span<send_request> reqs, util::span<std::size_t> indices);
+    std::size_t test_some(util::span<recv_request> reqs, util::span<std::size_t> indices);
+
+    /** @brief as test_some, but progress until at least one request completes (or none is left) */
+    std::size_t wait_some(util::span<send_request> reqs, util::span<std::size_t> indices);
+    std::size_t wait_some(util::span<recv_request> reqs, util::span<std::size_t> indices);
+
+    /** @brief index of the first request to complete, or reqs.size() if all requests are empty */
+    std::size_t wait_any(util::span<send_request> reqs);
+    std::size_t wait_any(util::span<recv_request> reqs);
+
   private:
+    template<typename CallBack>
+    util::unique_function<void()> make_callback(CallBack&& cb)
+    {
+        if (m_execution == callback_execution::immediate) return std::move(cb);
+        return cb_offload<CallBack>{m_impl, m_execution, std::move(cb)};
+    }
+
+    // the message which a callback made by make_callback from a CallBack holds (cb_rref): its
+    // location changes whenever f is moved
+    template<typename CallBack>
+    detail::message_buffer& held_message(util::unique_function<void()>& f) noexcept
+    {
+        if (m_execution == callback_execution::immediate) return f.target<CallBack>()->m.m;
+        return f.target<cb_offload<CallBack>>()->cb.m.m;
+    }
+
+    static void defer_callback(impl_type* impl, util::unique_function<void()>&& f);
+    static void offload_callback(impl_type* impl, util::unique_function<void()>&& f);
+    static void complete_offloaded(impl_type* impl, shared_request_ptr&& req);
+
+    // post an operation whose completion is recorded in the completion queue: c holds the posted
+    // values, the room reserved for the record is given back if posting throws
+    template<typename Post>
+    void post_cq(std::size_t& scheduled, completion c, Post&& post)
+    {
+        if (!m_cq) throw std::runtime_error("oomph: completion queue not enabled");
+        m_cq->reserve();
+        ++scheduled;
+        try
+        {
+            post(cb_cq{m_cq.get(), &scheduled, c});
+        }
+        catch (...)
+        {
+            m_cq->unreserve();
+            --scheduled;
+            throw;
+        }
+    }
+
+    template<typename Request>
+    std::size_t test_some_impl(util::span<Request> reqs, util::span<std::size_t> indices,
+        bool wait);
+
     detail::message_buffer make_buffer_core(std::size_t size);
     detail::message_buffer make_buffer_core(void* ptr, std::size_t size);
 #if HWMALLOC_ENABLE_DEVICE
@@ -477,11 +876,27 @@ class communicator
         int device_id);
 #endif
 
+    // m_ptr may point into a message held by cb: it is read before cb is moved
     void send(detail::message_buffer::heap_ptr_impl const* m_ptr, std::size_t size, rank_type dst,
-        tag_type tag, util::unique_function<void()> cb, shared_request_ptr req);
+        tag_type tag, util::unique_function<void()>&& cb, shared_request_ptr req);
 
     void recv(detail::message_buffer::heap_ptr_impl* m_ptr, std::size_t size, rank_type src,
-        tag_type tag, util::unique_function<void()> cb, shared_request_ptr req);
+        tag_type tag, util::unique_function<void()>&& cb, shared_request_ptr req);
+
+    void send(detail::message_buffer::heap_ptr_impl const* m_ptr, std::size_t offset,
+        std::size_t size, rank_type dst, tag_type tag, util::unique_function<void()>&& cb,
+        shared_request_ptr req);
+
+    void recv(detail::message_buffer::heap_ptr_impl* m_ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag, util::unique_function<void()>&& cb, shared_request_ptr req);
+
+    // without callback: completion sets the ready flag of req (if any) and decrements scheduled
+    void send(detail::message_buffer::heap_ptr_impl const* m_ptr, std::size_t offset,
+        std::size_t size, rank_type dst, tag_type tag, std::size_t* scheduled,
+        shared_request_ptr req);
+
+    void recv(detail::message_buffer::heap_ptr_impl* m_ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag, std::size_t* scheduled, shared_request_ptr req);
 };
 
 } // namespace oomph
@@ -0,0 +1,129 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/util/span.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace oomph
+{
+// Errors of the transport layer are reported by exceptions, except for operations recorded in a
+// completion queue: their records carry the outcome.
+enum class completion_status : int
+{
+    success = 0,
+    cancelled, // the operation was cancelled before it matched a message
+    error      // the transport layer reported a failure, e.g. a truncated receive
+};
+
+enum class completion_kind : int
+{
+    send = 0,
+    recv
+};
+
+/** @brief record of a completed operation, as returned by communicator::poll_completions */
+struct completion
+{
+    void*             cookie; // user data given when the operation was posted
+    int               peer;   // destination or source rank
+    int               tag;
+    std::size_t       bytes;  // 0 unless status is success
+    completion_kind   kind;
+    completion_status status;
+};
+
+namespace detail
+{
+// outcome of an operation as observed by the transport layer, e.g. the source and length of a
+// receive from any source (only meaningful if status is success)
+struct transport_completion
+{
+    int               peer;
+    std::size_t       bytes;
+    completion_status status;
+};
+
+// Fixed-size ring of completion records, filled during progress and drained by the user. Room for
+// a record is reserved when an operation is posted, such that completing an operation never has
+// to wait for the ring to be drained.
+class completion_queue
+{
+  private:
+    std::vector<completion>     m_ring;
+    std::size_t                 m_head = 0;     // oldest record
+    std::size_t                 m_size = 0;     // number of records in the ring
+    std::size_t                 m_reserved = 0; // records in the ring plus outstanding operations
+    transport_completion const* m_reported = nullptr; // operation whose handler runs
+
+  public:
+    completion_queue(std::size_t capacity)
+    : m_ring(capacity)
+    {
+    }
+
+    std::size_t capacity() const noexcept { return m_ring.size(); }
+    std::size_t size() const noexcept { return m_size; }
+    std::size_t reserved() const noexcept { return m_reserved; }
+
+    void reserve()
+    {
+        if (m_reserved == capacity())
+            throw std::runtime_error("oomph: completion queue full, poll completions first");
+        ++m_reserved;
+    }
+
+    // give back the room reserved for an operation which could not be posted
+    void unreserve() noexcept { --m_reserved; }
+
+    // set by the transport layer while the completion handler of an operation runs: the record
+    // takes its status from it, and peer and bytes if successful, rather than the posted values;
+    // pushing the record resets it, which tells the transport layer that the outcome was recorded
+    void set_reported(transport_completion const* t) noexcept { m_reported = t; }
+    transport_completion const* reported() const noexcept { return m_reported; }
+
+    void push(completion c) noexcept
+    {
+        if (auto const t = std::exchange(m_reported, nullptr))
+        {
+            c.status = t->status;
+            if (c.status == completion_status::success)
+            {
+                c.peer = t->peer;
+                c.bytes = t->bytes;
+            }
+            else
+                c.bytes = 0;
+        }
+        auto i = m_head + m_size;
+        if (i >= capacity()) i -= capacity();
+        m_ring[i] = c;
+        ++m_size;
+    }
+
+    std::size_t pop(util::span<completion> out) noexcept
+    {
+        auto const n = std::min(out.size(), m_size);
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            out[k] = m_ring[m_head];
+            if (++m_head == capacity()) m_head = 0;
+        }
+        m_size -= n;
+        m_reserved -= n;
+        return n;
+    }
+};
+} // namespace detail
+} // namespace oomph
@@ -13,8 +13,10 @@
 #include <oomph/util/heap_pimpl.hpp>
 #include <oomph/message_buffer.hpp>
 #include <oomph/communicator.hpp>
+#include <oomph/memory.hpp>
 #include <hwmalloc/config.hpp>
 #include <hwmalloc/device.hpp>
+#include <chrono>
 
 namespace oomph
 {
@@ -80,6 +82,57 @@ class context
 
     communicator get_communicator();
 
+    /**
+     * @brief Drop cached registrations of user memory overlapping [ptr, ptr+size).
+     *
+     * If the registration cache is enabled (OOMPH_REGISTRATION_CACHE_SIZE), memory passed to
+     * make_buffer(ptr, size) stays registered after the message buffer is destroyed, such that
+     * wrapping it again is cheap. Where unmapping of memory cannot be detected by the transport
+     * layer, this function must then be called before such memory is freed.
+     */
+    void invalidate_registrations(void const* ptr, std::size_t size);
+
+    /**
+     * @brief Counters summed over all communicators of this context, including released ones. May
+     * be called from any thread. Set OOMPH_STATS_FILE to a file prefix to have them written
+     * periodically (every OOMPH_STATS_INTERVAL ms) to <prefix>.<rank>.txt.
+     */
+    communication_stats stats() const;
+
+    /**
+     * @brief Per peer latency histograms summed over all communicators of this context, indexed
+     * by rank. See also print_latency_report.
+     */
+    std::vector<peer_latency> latency() const;
+
+    /**
+     * @brief Memory held by this context and its communicators, with high-water marks. Request
+     * pools and queues are sampled by progress calls. May be called from any thread; also written
+     * to the OOMPH_STATS_FILE dumps.
+     */
+    memory_stats memory() const;
+
+    /**
+     * @brief Steady clock of this rank mapped to the one of rank 0, such that times taken on
+     * different ranks (and nodes) can be compared. Traces and the wait-state analysis use this
+     * clock. The mapping is measured when the context is created (OOMPH_CLOCK_SYNC_ROUNDS
+     * ping-pongs per rank, 0 disables it) and extrapolated with the drift between synchronizations.
+     */
+    std::chrono::nanoseconds global_time() const noexcept;
+
+    /**
+     * @brief Bound on the error of the offset of global_time() to the clock of rank 0, as measured
+     * by the last synchronization (half the shortest round trip per hop of the tree). It does not
+     * include the error of the drift extrapolation.
+     */
+    std::chrono::nanoseconds global_time_error() const noexcept;
+
+    /**
+     * @brief Measures the clock offsets again and updates the drift estimates. Collective: long
+     * running applications may call it periodically, e.g. every few minutes.
+     */
+    void synchronize_clocks();
+
   private:
     detail::message_buffer make_buffer_core(std::size_t size);
     detail::message_buffer make_buffer_core(void* ptr, std::size_t size);
@@ -0,0 +1,441 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || __cpp_impl_coroutine < 201902L
+#error "oomph: coroutine support requires C++20"
+#endif
+
+#include <oomph/communicator.hpp>
+#include <oomph/barrier.hpp>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Coroutine support: tasks awaiting send/recv requests and barriers, resumed by a per-communicator
+// scheduler on the thread progressing it.
+//
+//     oomph::coro::task<> exchange(oomph::communicator& comm, ...)
+//     {
+//         auto r = comm.recv(rmsg, src, tag);
+//         co_await comm.send(smsg, dst, tag);
+//         co_await std::move(r);
+//     }
+//
+//     oomph::coro::scheduler sched(comm);
+//     sched.spawn(exchange(comm, ...));
+//     sched.run();
+namespace oomph
+{
+namespace coro
+{
+class scheduler;
+
+namespace detail
+{
+// Thread-local free lists for coroutine frames, in size classes of 64 bytes. Frames which do not
+// fit the largest class are allocated from the heap directly. Memory is returned to the system
+// when the thread exits.
+class frame_pool
+{
+  private:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t num_classes = 64;
+
+    struct node
+    {
+        node* m_next;
+    };
+
+  private:
+    node* m_free[num_classes] = {};
+
+  public:
+    frame_pool() noexcept = default;
+    frame_pool(frame_pool const&) = delete;
+    frame_pool& operator=(frame_pool const&) = delete;
+
+    ~frame_pool()
+    {
+        for (auto n : m_free)
+        {
+            while (n) ::operator delete(std::exchange(n, n->m_next));
+        }
+    }
+
+    static frame_pool& get()
+    {
+        thread_local frame_pool pool;
+        return pool;
+    }
+
+    void* allocate(std::size_t size)
+    {
+        auto const c = (size + granularity - 1) / granularity;
+        if (c > num_classes) return ::operator new(size);
+        if (auto n = m_free[c - 1])
+        {
+            m_free[c - 1] = n->m_next;
+            return n;
+        }
+        return ::operator new(c * granularity);
+    }
+
+    void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        auto const c = (size + granularity - 1) / granularity;
+        if (c > num_classes) return ::operator delete(ptr);
+        auto n = static_cast<node*>(ptr);
+        n->m_next = m_free[c - 1];
+        m_free[c - 1] = n;
+    }
+};
+
+struct final_awaiter
+{
+    bool await_ready() const noexcept { return false; }
+    void await_resume() const noexcept {}
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept;
+};
+
+struct promise_base
+{
+    scheduler*              m_sched = nullptr;
+    std::coroutine_handle<> m_continuation; // awaiting task, if any
+    std::exception_ptr      m_exception;
+    bool                    m_detached = false; // owned by the scheduler
+
+    static void* operator new(std::size_t size) { return frame_pool::get().allocate(size); }
+
+    static void operator delete(void* ptr, std::size_t size) noexcept
+    {
+        frame_pool::get().deallocate(ptr, size);
+    }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter       final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+};
+
+template<typename T>
+struct promise_result
+{
+    std::optional<T> m_value;
+
+    template<typename U>
+    void return_value(U&& value)
+    {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    T get() { return std::move(*m_value); }
+};
+
+template<>
+struct promise_result<void>
+{
+    void return_void() const noexcept {}
+    void get() const noexcept {}
+};
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine.
+ *
+ * A task runs once it is awaited by another task, or once it has been handed to a scheduler with
+ * scheduler::spawn. Exceptions thrown by the task are rethrown to the awaiting task, or by
+ * scheduler::run for spawned tasks.
+ */
+template<typename T = void>
+class [[nodiscard]] task
+{
+  public:
+    struct promise_type
+    : detail::promise_base
+    , detail::promise_result<T>
+    {
+        task get_return_object() noexcept
+        {
+            return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+  private:
+    friend class scheduler;
+
+    struct awaiter
+    {
+        handle_type m_h;
+
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> caller) noexcept
+        {
+            m_h.promise().m_sched = caller.promise().m_sched;
+            m_h.promise().m_continuation = caller;
+            return m_h;
+        }
+
+        T await_resume()
+        {
+            auto& p = m_h.promise();
+            if (p.m_exception) std::rethrow_exception(p.m_exception);
+            return p.get();
+        }
+    };
+
+  private:
+    handle_type m_h;
+
+    explicit task(handle_type h) noexcept
+    : m_h{h}
+    {
+    }
+
+    handle_type release() noexcept { return std::exchange(m_h, nullptr); }
+
+  public:
+    task(task const&) = delete;
+    task& operator=(task const&) = delete;
+
+    task(task&& other) noexcept
+    : m_h{other.release()}
+    {
+    }
+
+    task& operator=(task&& other) noexcept
+    {
+        if (m_h) m_h.destroy();
+        m_h = other.release();
+        return *this;
+    }
+
+    ~task()
+    {
+        if (m_h) m_h.destroy();
+    }
+
+    awaiter operator co_await() && noexcept { return {m_h}; }
+};
+
+/**
+ * @brief Runs tasks communicating through one communicator.
+ *
+ * Tasks waiting for a request are resumed by progress() once the request has completed, on the
+ * calling thread and without rescanning the waiting tasks. The scheduler is thread compatible, like
+ * the communicator it drives. Remaining tasks are run to completion on destruction.
+ */
+class scheduler
+{
+  private:
+    template<typename Request>
+    friend class request_awaiter;
+    friend class barrier_awaiter;
+    friend struct detail::final_awaiter;
+
+    using handle = std::coroutine_handle<>;
+
+  private:
+    communicator&                               m_comm;
+    std::vector<handle>                         m_ready;
+    std::vector<handle>                         m_resuming;
+    std::vector<std::pair<MPI_Request, handle>> m_mpi_requests;
+    std::size_t                                 m_num_tasks = 0;
+    std::exception_ptr                          m_exception;
+
+  public:
+    explicit scheduler(communicator& comm)
+    : m_comm{comm}
+    {
+        m_ready.reserve(256);
+        m_resuming.reserve(256);
+    }
+
+    scheduler(scheduler const&) = delete;
+    scheduler& operator=(scheduler const&) = delete;
+
+    ~scheduler()
+    {
+        while (m_num_tasks > 0) progress();
+    }
+
+  public:
+    communicator& get_communicator() noexcept { return m_comm; }
+    std::size_t   num_tasks() const noexcept { return m_num_tasks; }
+
+    /** @brief take over a task, which starts running with the next call to progress() */
+    void spawn(task<>&& t)
+    {
+        auto h = t.release();
+        h.promise().m_sched = this;
+        h.promise().m_detached = true;
+        ++m_num_tasks;
+        m_ready.push_back(h);
+    }
+
+    /**
+     * @brief progress the communicator once, run its deferred callbacks and resume the tasks which
+     * can continue
+     */
+    void progress()
+    {
+        m_comm.progress();
+        m_comm.run_deferred_callbacks();
+        for (std::size_t i = 0; i < m_mpi_requests.size();)
+        {
+            int flag;
+            OOMPH_CHECK_MPI_RESULT(MPI_Test(&m_mpi_requests[i].first, &flag, MPI_STATUS_IGNORE));
+            if (flag)
+            {
+                m_ready.push_back(m_mpi_requests[i].second);
+                m_mpi_requests[i] = m_mpi_requests.back();
+                m_mpi_requests.pop_back();
+            }
+            else
+                ++i;
+        }
+        // tasks becoming ready while resuming are resumed by the next call
+        m_resuming.swap(m_ready);
+        for (auto h : m_resuming) h.resume();
+        m_resuming.clear();
+    }
+
+    /** @brief progress until all spawned tasks have finished; rethrows the first exception */
+    void run()
+    {
+        while (m_num_tasks > 0) progress();
+        if (m_exception) std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+
+  private:
+    void schedule(handle h) { m_ready.push_back(h); }
+
+    void wait(MPI_Request req, handle h) { m_mpi_requests.emplace_back(req, h); }
+
+    void task_done(std::exception_ptr e) noexcept
+    {
+        --m_num_tasks;
+        if (e && !m_exception) m_exception = std::move(e);
+    }
+};
+
+template<typename Promise>
+std::coroutine_handle<>
+detail::final_awaiter::await_suspend(std::coroutine_handle<Promise> h) noexcept
+{
+    auto& p = h.promise();
+    if (p.m_continuation) return p.m_continuation;
+    if (p.m_detached)
+    {
+        auto sched = p.m_sched;
+        auto e = std::move(p.m_exception);
+        h.destroy();
+        sched->task_done(std::move(e));
+    }
+    return std::noop_coroutine();
+}
+
+/** @brief awaits the completion of a send or receive request, see operator co_await below */
+template<typename Request>
+class request_awaiter : private oomph::detail::request_watch
+{
+  private:
+    Request                 m_req;
+    scheduler*              m_sched = nullptr;
+    std::coroutine_handle<> m_handle;
+
+  public:
+    explicit request_awaiter(Request&& req) noexcept
+    : oomph::detail::request_watch{&notify_fn}
+    , m_req{std::move(req)}
+    {
+    }
+
+    bool await_ready() const noexcept { return m_req.is_ready(); }
+
+    template<typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> h) noexcept
+    {
+        m_sched = h.promise().m_sched;
+        m_handle = h;
+        add(*m_req.m_data, 0);
+    }
+
+    void await_resume() const noexcept {}
+
+  private:
+    // called from within progress when the request completes
+    static void notify_fn(oomph::detail::request_watch& w, std::size_t) noexcept
+    {
+        auto& a = static_cast<request_awaiter&>(w);
+        a.m_sched->schedule(a.m_handle);
+    }
+};
+
+/** @brief awaits a barrier among the ranks of a communicator, see rank_barrier below */
+class barrier_awaiter
+{
+  private:
+    MPI_Comm m_comm;
+
+  public:
+    explicit barrier_awaiter(MPI_Comm comm) noexcept
+    : m_comm{comm}
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> h)
+    {
+        auto        sched = h.promise().m_sched;
+        MPI_Request req;
+        OOMPH_CHECK_MPI_RESULT(MPI_Ibarrier(m_comm, &req));
+        sched->wait(req, h);
+    }
+
+    void await_resume() const noexcept {}
+};
+
+// A task suspends until all ranks of comm have reached the barrier, like b.rank_barrier(comm):
+// co_await coro::rank_barrier(b, comm). Only barriers created for one thread can be awaited.
+inline barrier_awaiter
+rank_barrier(barrier const& b, communicator& comm)
+{
+    if (b.size() != 1) throw std::runtime_error("oomph: only rank barriers can be awaited");
+    return barrier_awaiter{comm.mpi_comm()};
+}
+
+} // namespace coro
+
+// A task suspends until the request is ready: co_await comm.recv(msg, src, tag);
+inline coro::request_awaiter<send_request>
+operator co_await(send_request&& req) noexcept
+{
+    return coro::request_awaiter<send_request>{std::move(req)};
+}
+
+inline coro::request_awaiter<recv_request>
+operator co_await(recv_request&& req) noexcept
+{
+    return coro::request_awaiter<recv_request>{std::move(req)};
+}
+
+} // namespace oomph
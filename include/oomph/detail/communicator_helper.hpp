@@ -36,6 +36,10 @@
     static_assert(std::is_same<arg0_t, message_buffer<TT> const&>::value,                          \
         "first callback argument type is not a const l-value reference to a message_buffer");
 
+#define OOMPH_CHECK_CALLBACK_MSG_VIEW                                                              \
+    static_assert(std::is_same<arg0_t, message_view<TT>>::value,                                   \
+        "first callback argument type is not a message_view");
+
 #define OOMPH_CHECK_CALLBACK(CALLBACK)                                                             \
     {                                                                                              \
         OOMPH_CHECK_CALLBACK_F(CALLBACK, rank_type)                                                \
@@ -71,3 +75,9 @@
         OOMPH_CHECK_CALLBACK_F(CALLBACK, std::vector<rank_type>)                                   \
         OOMPH_CHECK_CALLBACK_MSG_CONST_REF                                                         \
     }
+
+#define OOMPH_CHECK_CALLBACK_VIEW(CALLBACK)                                                        \
+    {                                                                                              \
+        OOMPH_CHECK_CALLBACK_F(CALLBACK, rank_type)                                                \
+        OOMPH_CHECK_CALLBACK_MSG_VIEW                                                              \
+    }
@@ -0,0 +1,188 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace oomph
+{
+namespace detail
+{
+using gather_index_type = std::int32_t;
+
+// generic kernels
+// ===============
+
+// dst[k*stride] = src[idx[k]]
+template<typename T>
+inline void
+gather_strided(T* dst, std::size_t stride, T const* src, gather_index_type const* idx,
+    std::size_t n) noexcept
+{
+    for (std::size_t k = 0; k < n; ++k) dst[k * stride] = src[idx[k]];
+}
+
+// dst[idx[k]] = src[k*stride]
+template<typename T>
+inline void
+scatter_strided(T* dst, gather_index_type const* idx, T const* src, std::size_t stride,
+    std::size_t n) noexcept
+{
+    for (std::size_t k = 0; k < n; ++k) dst[idx[k]] = src[k * stride];
+}
+
+// dst[dst_idx[k]] = src[src_idx[k]]
+template<typename T>
+inline void
+gather_scatter(T* dst, gather_index_type const* dst_idx, T const* src,
+    gather_index_type const* src_idx, std::size_t n) noexcept
+{
+    for (std::size_t k = 0; k < n; ++k) dst[dst_idx[k]] = src[src_idx[k]];
+}
+
+// hardware gather/scatter
+// =======================
+// The vector kernels only depend on the size of T: any trivially copyable 4 or 8 byte type is
+// moved as raw bits. Remainders are handled by the generic kernels.
+
+template<typename T>
+using has_vector_gather = std::integral_constant<bool,
+    std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>;
+
+#if defined(__AVX512F__)
+template<typename T>
+inline std::size_t
+gather_vec(T* dst, T const* src, gather_index_type const* idx, std::size_t n) noexcept
+{
+    std::size_t k = 0;
+    if constexpr (sizeof(T) == 8)
+    {
+        for (; k + 8 <= n; k += 8)
+        {
+            __m256i const vi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(idx + k));
+            __m512i const v = _mm512_i32gather_epi64(vi, src, 8);
+            _mm512_storeu_si512(dst + k, v);
+        }
+    }
+    else
+    {
+        for (; k + 16 <= n; k += 16)
+        {
+            __m512i const vi = _mm512_loadu_si512(idx + k);
+            __m512i const v = _mm512_i32gather_epi32(vi, src, 4);
+            _mm512_storeu_si512(dst + k, v);
+        }
+    }
+    return k;
+}
+
+template<typename T>
+inline std::size_t
+scatter_vec(T* dst, gather_index_type const* idx, T const* src, std::size_t n) noexcept
+{
+    std::size_t k = 0;
+    if constexpr (sizeof(T) == 8)
+    {
+        for (; k + 8 <= n; k += 8)
+        {
+            __m256i const vi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(idx + k));
+            __m512i const v = _mm512_loadu_si512(src + k);
+            _mm512_i32scatter_epi64(dst, vi, v, 8);
+        }
+    }
+    else
+    {
+        for (; k + 16 <= n; k += 16)
+        {
+            __m512i const vi = _mm512_loadu_si512(idx + k);
+            __m512i const v = _mm512_loadu_si512(src + k);
+            _mm512_i32scatter_epi32(dst, vi, v, 4);
+        }
+    }
+    return k;
+}
+#elif defined(__AVX2__)
+template<typename T>
+inline std::size_t
+gather_vec(T* dst, T const* src, gather_index_type const* idx, std::size_t n) noexcept
+{
+    std::size_t k = 0;
+    if constexpr (sizeof(T) == 8)
+    {
+        for (; k + 4 <= n; k += 4)
+        {
+            __m128i const vi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(idx + k));
+            __m256i const v =
+                _mm256_i32gather_epi64(reinterpret_cast<long long const*>(src), vi, 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), v);
+        }
+    }
+    else
+    {
+        for (; k + 8 <= n; k += 8)
+        {
+            __m256i const vi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(idx + k));
+            __m256i const v = _mm256_i32gather_epi32(reinterpret_cast<int const*>(src), vi, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), v);
+        }
+    }
+    return k;
+}
+
+// AVX2 has no scatter instruction
+template<typename T>
+inline std::size_t
+scatter_vec(T*, gather_index_type const*, T const*, std::size_t) noexcept
+{
+    return 0;
+}
+#else
+template<typename T>
+inline std::size_t
+gather_vec(T*, T const*, gather_index_type const*, std::size_t) noexcept
+{
+    return 0;
+}
+
+template<typename T>
+inline std::size_t
+scatter_vec(T*, gather_index_type const*, T const*, std::size_t) noexcept
+{
+    return 0;
+}
+#endif
+
+// dst[k] = src[idx[k]]
+template<typename T>
+inline void
+gather(T* dst, T const* src, gather_index_type const* idx, std::size_t n) noexcept
+{
+    std::size_t k = 0;
+    if constexpr (has_vector_gather<T>::value) k = gather_vec(dst, src, idx, n);
+    gather_strided(dst + k, 1, src, idx + k, n - k);
+}
+
+// dst[idx[k]] = src[k]
+template<typename T>
+inline void
+scatter(T* dst, gather_index_type const* idx, T const* src, std::size_t n) noexcept
+{
+    std::size_t k = 0;
+    if constexpr (has_vector_gather<T>::value) k = scatter_vec(dst, idx, src, n);
+    scatter_strided(dst, idx + k, src + k, 1, n - k);
+}
+
+} // namespace detail
+} // namespace oomph
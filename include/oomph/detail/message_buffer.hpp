@@ -10,8 +10,7 @@
 #pragma once
 
 #include <oomph/config.hpp>
-#include <oomph/util/pimpl.hpp>
-#include <oomph/util/heap_pimpl.hpp>
+#include <oomph/util/stack_pimpl.hpp>
 
 namespace oomph
 {
@@ -21,8 +20,9 @@ class message_buffer
 {
   public:
     class heap_ptr_impl;
-    //using pimpl = util::pimpl<heap_ptr_impl, 64, 8>;
-    using pimpl = util::heap_pimpl<heap_ptr_impl>;
+    // stored inline regardless of OOMPH_USE_FAST_PIMPL: creating and moving message buffers must
+    // not allocate
+    using pimpl = util::stack_pimpl<heap_ptr_impl, 64, 8>;
 
   public:
     void* m_ptr = nullptr;
@@ -32,9 +32,9 @@ class message_buffer
     message_buffer();
     template<typename VoidPtr>
     message_buffer(VoidPtr ptr);
-    message_buffer(message_buffer&&);
+    message_buffer(message_buffer&&) noexcept;
     ~message_buffer();
-    message_buffer& operator=(message_buffer&&);
+    message_buffer& operator=(message_buffer&&) noexcept;
 
     operator bool() const noexcept { return m_ptr; }
 
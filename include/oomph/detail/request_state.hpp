@@ -10,6 +10,7 @@
 #pragma once
 
 #include <memory>
+#include <utility>
 #include <boost/pool/pool.hpp>
 
 namespace oomph
@@ -19,41 +20,141 @@ class communicator_impl;
 
 namespace detail
 {
+// number of blocks in the first chunk of a request pool, every further chunk is twice as large
+inline constexpr std::size_t request_pool_start_size = 128;
+
+struct request_state;
+
+// Observer of the completion of requests: each request added is notified once with the index it
+// was registered with, and leaves the list of watched requests when it completes.
+struct request_watch
+{
+    void (*m_notify)(request_watch&, std::size_t index) noexcept;
+    request_state* m_first = nullptr; // requests being watched
+
+    void add(request_state& s, std::size_t index) noexcept;
+    // stop watching the requests which have not completed
+    void clear() noexcept;
+};
+
+// Collects the indices of completed requests for communicator::test_some and friends: a request
+// being watched reports its index on completion, such that the set need not be scanned again.
+// Indices beyond the capacity are dropped.
+struct request_index_watch : request_watch
+{
+    std::size_t* m_indices;
+    std::size_t  m_capacity;
+    std::size_t  m_count = 0;
+
+    request_index_watch(std::size_t* indices, std::size_t capacity) noexcept
+    : request_watch{&notify_fn}
+    , m_indices{indices}
+    , m_capacity{capacity}
+    {
+    }
+
+    request_index_watch(request_index_watch const&) = delete;
+    ~request_index_watch() { clear(); }
+
+    void notify(std::size_t index) noexcept
+    {
+        if (m_count < m_capacity) m_indices[m_count++] = index;
+    }
+
+    static void notify_fn(request_watch& w, std::size_t index) noexcept
+    {
+        static_cast<request_index_watch&>(w).notify(index);
+    }
+};
+
 struct request_state
 {
     communicator_impl* m_comm;
     std::size_t*       m_scheduled;
+    boost::pool<>*     m_pool;
     std::size_t        m_index = 0;
     bool               m_ready = false;
     void*              m_data = nullptr;
     std::size_t        m_ref_count = 0;
+    request_watch*     m_watch = nullptr;
+    std::size_t        m_watch_index = 0;
+    request_state*     m_watch_prev = nullptr; // other requests watched by m_watch
+    request_state*     m_watch_next = nullptr;
 
-    request_state(communicator_impl* comm, std::size_t* scheduled) noexcept
+    request_state(communicator_impl* comm, std::size_t* scheduled, boost::pool<>* pool) noexcept
     : m_comm{comm}
     , m_scheduled{scheduled}
+    , m_pool{pool}
     {
     }
+
+    ~request_state()
+    {
+        if (m_watch) unwatch();
+    }
+
+    void set_ready() noexcept
+    {
+        m_ready = true;
+        if (m_watch)
+        {
+            auto w = m_watch;
+            unwatch();
+            w->m_notify(*w, m_watch_index);
+        }
+    }
+
+    void unwatch() noexcept
+    {
+        if (m_watch_prev) m_watch_prev->m_watch_next = m_watch_next;
+        else
+            m_watch->m_first = m_watch_next;
+        if (m_watch_next) m_watch_next->m_watch_prev = m_watch_prev;
+        m_watch = nullptr;
+        m_watch_prev = nullptr;
+        m_watch_next = nullptr;
+    }
 };
 
+inline void
+request_watch::add(request_state& s, std::size_t index) noexcept
+{
+    s.m_watch = this;
+    s.m_watch_index = index;
+    s.m_watch_prev = nullptr;
+    s.m_watch_next = m_first;
+    if (m_first) m_first->m_watch_prev = &s;
+    m_first = &s;
+}
+
+inline void
+request_watch::clear() noexcept
+{
+    while (m_first) m_first->unwatch();
+}
+
 class shared_request_ptr
 {
   private:
     request_state* m_ptr = nullptr;
-    boost::pool<>* m_pool = nullptr;
 
   public:
     shared_request_ptr(boost::pool<>* pool, communicator_impl* comm, std::size_t* scheduled)
-    : m_pool{pool}
     {
-        m_ptr = new (m_pool->malloc()) request_state(comm, scheduled);
+        m_ptr = new (pool->malloc()) request_state(comm, scheduled, pool);
         m_ptr->m_ref_count = 1;
     }
 
+    // adopt a reference previously given up with release()
+    explicit shared_request_ptr(request_state* ptr) noexcept
+    : m_ptr{ptr}
+    {
+    }
+
     shared_request_ptr() = default;
 
     shared_request_ptr(shared_request_ptr&& other) noexcept
     : m_ptr{std::exchange(other.m_ptr, nullptr)}
-    , m_pool{other.m_pool}
     {
     }
 
@@ -61,13 +162,11 @@ class shared_request_ptr
     {
         destroy();
         m_ptr = std::exchange(other.m_ptr, nullptr);
-        m_pool = other.m_pool;
         return *this;
     }
 
     shared_request_ptr(shared_request_ptr const& other) noexcept
     : m_ptr{other.m_ptr}
-    , m_pool{other.m_pool}
     {
         if (m_ptr) ++m_ptr->m_ref_count;
     }
@@ -76,7 +175,6 @@ class shared_request_ptr
     {
         destroy();
         m_ptr = other.m_ptr;
-        m_pool = other.m_pool;
         if (m_ptr) ++m_ptr->m_ref_count;
         return *this;
     }
@@ -97,6 +195,9 @@ class shared_request_ptr
         m_ptr = nullptr;
     }
 
+    // give up ownership of the reference without decrementing the reference count
+    request_state* release() noexcept { return std::exchange(m_ptr, nullptr); }
+
   private:
     void destroy()
     {
@@ -104,8 +205,9 @@ class shared_request_ptr
         {
             if (--m_ptr->m_ref_count == 0)
             {
+                auto pool = m_ptr->m_pool;
                 m_ptr->~request_state();
-                m_pool->free(m_ptr);
+                pool->free(m_ptr);
             }
         }
     }
@@ -0,0 +1,242 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/message_buffer.hpp>
+#include <oomph/detail/gather_scatter.hpp>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <initializer_list>
+#include <cassert>
+
+namespace oomph
+{
+/**
+ * @brief Index list describing the part of a field exchanged with one peer, e.g. the send or
+ * receive list of a halo on an unstructured mesh.
+ *
+ * The order of the given indices defines the order of the elements within the message (the wire
+ * order), which must match the index list used for unpacking on the peer. In order to improve
+ * locality the indices are sorted once at construction while remembering the original message
+ * position of each index, so the wire order is preserved: packing gathers from the field with
+ * ascending addresses, and unpacking scatters into the field with ascending addresses. Hardware
+ * gather (AVX2, AVX-512) and scatter (AVX-512) instructions are used for 4 and 8 byte types when
+ * the code is compiled for a target that supports them.
+ *
+ * Multiple fields of the same type can be packed into one message, either interleaved
+ * (f0[i0] f1[i0] f0[i1] f1[i1] ...) or as struct of arrays (f0[i0] f0[i1] ... f1[i0] f1[i1] ...).
+ */
+class indexed_layout
+{
+  public:
+    using index_type = detail::gather_index_type;
+
+    enum class field_order
+    {
+        interleaved,
+        struct_of_arrays
+    };
+
+  private:
+    // number of elements staged on the stack when packing/unpacking out of order
+    static constexpr std::size_t block_size = 256;
+
+  private:
+    std::vector<index_type> m_indices;   // field indices in ascending order
+    std::vector<index_type> m_positions; // message position of each index (empty if in order)
+
+  public:
+    indexed_layout() = default;
+
+    indexed_layout(std::vector<index_type> indices)
+    {
+        const auto n = indices.size();
+        if (std::is_sorted(indices.begin(), indices.end()))
+        {
+            m_indices = std::move(indices);
+            return;
+        }
+        m_positions.resize(n);
+        std::iota(m_positions.begin(), m_positions.end(), index_type{0});
+        std::stable_sort(m_positions.begin(), m_positions.end(),
+            [&indices](index_type a, index_type b) { return indices[a] < indices[b]; });
+        m_indices.resize(n);
+        for (std::size_t k = 0; k < n; ++k) m_indices[k] = indices[m_positions[k]];
+    }
+
+    indexed_layout(indexed_layout const&) = default;
+    indexed_layout(indexed_layout&&) = default;
+    indexed_layout& operator=(indexed_layout const&) = default;
+    indexed_layout& operator=(indexed_layout&&) = default;
+
+  public:
+    /** @brief number of indices */
+    std::size_t size() const noexcept { return m_indices.size(); }
+
+    /** @brief number of message elements required for num_fields fields */
+    std::size_t message_size(std::size_t num_fields = 1) const noexcept
+    {
+        return size() * num_fields;
+    }
+
+    /** @brief whether the indices were given in ascending order */
+    bool in_order() const noexcept { return m_positions.empty(); }
+
+  public:
+    // pack
+    // ====
+
+    /** @brief pack one field into a message */
+    template<typename T>
+    void pack(message_buffer<T>& msg, T const* field) const
+    {
+        assert(msg.size() >= message_size());
+        pack(msg.data(), &field, 1, field_order::struct_of_arrays);
+    }
+
+    /** @brief pack several fields into one message */
+    template<typename T>
+    void pack(message_buffer<T>& msg, std::initializer_list<T const*> fields,
+        field_order order = field_order::interleaved) const
+    {
+        assert(msg.size() >= message_size(fields.size()));
+        pack(msg.data(), fields.begin(), fields.size(), order);
+    }
+
+    /** @brief pack num_fields fields into a contiguous buffer of message_size(num_fields) */
+    template<typename T>
+    void pack(T* buffer, T const* const* fields, std::size_t num_fields,
+        field_order order = field_order::interleaved) const
+    {
+        const auto n = size();
+        if (num_fields == 1 || order == field_order::struct_of_arrays)
+        {
+            for (std::size_t f = 0; f < num_fields; ++f) pack_field(buffer + f * n, fields[f]);
+        }
+        else if (in_order())
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                const auto i = m_indices[k];
+                for (std::size_t f = 0; f < num_fields; ++f)
+                    buffer[k * num_fields + f] = fields[f][i];
+            }
+        }
+        else
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                const auto i = m_indices[k];
+                const auto p = m_positions[k] * num_fields;
+                for (std::size_t f = 0; f < num_fields; ++f) buffer[p + f] = fields[f][i];
+            }
+        }
+    }
+
+    // unpack
+    // ======
+
+    /** @brief unpack a message into one field */
+    template<typename T>
+    void unpack(message_buffer<T> const& msg, T* field) const
+    {
+        assert(msg.size() >= message_size());
+        unpack(msg.data(), &field, 1, field_order::struct_of_arrays);
+    }
+
+    /** @brief unpack a message into several fields */
+    template<typename T>
+    void unpack(message_buffer<T> const& msg, std::initializer_list<T*> fields,
+        field_order order = field_order::interleaved) const
+    {
+        assert(msg.size() >= message_size(fields.size()));
+        unpack(msg.data(), fields.begin(), fields.size(), order);
+    }
+
+    /** @brief unpack a contiguous buffer of message_size(num_fields) into num_fields fields */
+    template<typename T>
+    void unpack(T const* buffer, T* const* fields, std::size_t num_fields,
+        field_order order = field_order::interleaved) const
+    {
+        const auto n = size();
+        if (num_fields == 1 || order == field_order::struct_of_arrays)
+        {
+            for (std::size_t f = 0; f < num_fields; ++f) unpack_field(buffer + f * n, fields[f]);
+        }
+        else if (in_order())
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                const auto i = m_indices[k];
+                for (std::size_t f = 0; f < num_fields; ++f)
+                    fields[f][i] = buffer[k * num_fields + f];
+            }
+        }
+        else
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                const auto i = m_indices[k];
+                const auto p = m_positions[k] * num_fields;
+                for (std::size_t f = 0; f < num_fields; ++f) fields[f][i] = buffer[p + f];
+            }
+        }
+    }
+
+  private:
+    template<typename T>
+    void pack_field(T* buffer, T const* field) const
+    {
+        const auto n = size();
+        if (in_order()) return detail::gather(buffer, field, m_indices.data(), n);
+        if constexpr (detail::has_vector_gather<T>::value)
+        {
+            // gather block-wise with ascending addresses into a staging area, then scatter the
+            // staged block to the message positions
+            alignas(64) T staged[block_size];
+            for (std::size_t b = 0; b < n; b += block_size)
+            {
+                const auto m = std::min(block_size, n - b);
+                detail::gather(staged, field, m_indices.data() + b, m);
+                detail::scatter(buffer, m_positions.data() + b, staged, m);
+            }
+        }
+        else
+        {
+            detail::gather_scatter(buffer, m_positions.data(), field, m_indices.data(), n);
+        }
+    }
+
+    template<typename T>
+    void unpack_field(T const* buffer, T* field) const
+    {
+        const auto n = size();
+        if (in_order()) return detail::scatter(field, m_indices.data(), buffer, n);
+        if constexpr (detail::has_vector_gather<T>::value)
+        {
+            // gather block-wise from the message positions into a staging area, then scatter the
+            // staged block into the field with ascending addresses
+            alignas(64) T staged[block_size];
+            for (std::size_t b = 0; b < n; b += block_size)
+            {
+                const auto m = std::min(block_size, n - b);
+                detail::gather(staged, buffer, m_positions.data() + b, m);
+                detail::scatter(field, m_indices.data() + b, staged, m);
+            }
+        }
+        else
+        {
+            detail::gather_scatter(field, m_indices.data(), buffer, m_positions.data(), n);
+        }
+    }
+};
+
+} // namespace oomph
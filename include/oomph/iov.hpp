@@ -0,0 +1,65 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/message_view.hpp>
+#include <cassert>
+
+namespace oomph
+{
+/**
+ * @brief A piece of a scatter/gather message: a range of elements within a message buffer.
+ *
+ * A list of iov elements is transferred as one logical message by communicator::send_iov and
+ * communicator::recv_iov, without packing the pieces into a contiguous buffer first. The message
+ * buffers must outlive the communication. Sizes and offsets are converted to bytes, such that
+ * pieces of buffers with different value types may be combined.
+ */
+class iov_element
+{
+  private:
+    friend class communicator;
+
+  private:
+    detail::message_buffer::heap_ptr_impl* m_ptr;
+    std::size_t                            m_offset; // in bytes
+    std::size_t                            m_size;   // in bytes
+
+  public:
+    template<typename T>
+    iov_element(message_buffer<T> const& msg, std::size_t offset, std::size_t count)
+    : m_ptr{const_cast<detail::message_buffer::heap_ptr_impl*>(msg.m.m_heap_ptr.get())}
+    , m_offset{offset * sizeof(T)}
+    , m_size{count * sizeof(T)}
+    {
+        assert(msg);
+        assert(offset + count <= msg.size());
+    }
+
+    template<typename T>
+    iov_element(message_buffer<T> const& msg)
+    : iov_element(msg, 0, msg.size())
+    {
+    }
+
+    template<typename T>
+    iov_element(message_view<T> const& v)
+    : m_ptr{v.m_heap_ptr}
+    , m_offset{v.m_offset}
+    , m_size{v.size() * sizeof(T)}
+    {
+        assert(v);
+    }
+
+    /** @brief size of the piece in bytes */
+    std::size_t size() const noexcept { return m_size; }
+};
+
+} // namespace oomph
@@ -0,0 +1,123 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace oomph
+{
+class context;
+
+// Log-linear histogram of durations in ns in the style of HdrHistogram: values below 2^sub_bits
+// are counted exactly, larger ones in 2^sub_bits buckets per power of 2, which bounds the relative
+// error by 2^-sub_bits. Values from 2^max_bits ns (about 78 hours) on share the last bucket.
+class latency_histogram
+{
+  public:
+    static constexpr unsigned    sub_bits = 4;
+    static constexpr unsigned    max_bits = 48;
+    static constexpr std::size_t num_buckets = (max_bits - sub_bits + 1) << sub_bits;
+
+  private:
+    std::vector<std::uint64_t> m_counts; // allocated with the first value
+    std::uint64_t              m_count = 0;
+    std::uint64_t              m_max = 0;
+
+  public:
+    static std::size_t bucket(std::uint64_t ns) noexcept
+    {
+        if (ns >> max_bits) ns = (std::uint64_t(1) << max_bits) - 1;
+        if (ns < (1u << sub_bits)) return ns;
+        unsigned const e = 63 - __builtin_clzll(ns);
+        return ((e - sub_bits + 1) << sub_bits) + ((ns >> (e - sub_bits)) & ((1u << sub_bits) - 1));
+    }
+
+    // smallest value counted in bucket i
+    static std::uint64_t lower_bound(std::size_t i) noexcept
+    {
+        if (i < (1u << sub_bits)) return i;
+        unsigned const e = (i >> sub_bits) + sub_bits - 1;
+        return ((std::uint64_t(1) << sub_bits) + (i & ((1u << sub_bits) - 1))) << (e - sub_bits);
+    }
+
+    void add(std::uint64_t ns, std::uint64_t n = 1)
+    {
+        if (m_counts.empty()) m_counts.resize(num_buckets, 0);
+        m_counts[bucket(ns)] += n;
+        m_count += n;
+        m_max = std::max(m_max, ns);
+    }
+
+    // merges bucket counts, e.g. read from another histogram
+    void add_bucket(std::size_t i, std::uint64_t n)
+    {
+        if (!n) return;
+        if (m_counts.empty()) m_counts.resize(num_buckets, 0);
+        m_counts[i] += n;
+        m_count += n;
+    }
+
+    void add_max(std::uint64_t ns) noexcept { m_max = std::max(m_max, ns); }
+
+    std::uint64_t count() const noexcept { return m_count; }
+    std::uint64_t max() const noexcept { return m_max; }
+    std::uint64_t bucket_count(std::size_t i) const noexcept
+    {
+        return m_counts.empty() ? 0 : m_counts[i];
+    }
+
+    // value below which a fraction q of the values lie, up to the bucket resolution (0 if empty)
+    std::uint64_t quantile(double q) const noexcept
+    {
+        if (!m_count) return 0;
+        auto const    rank = std::max<std::uint64_t>(1, std::uint64_t(q * m_count + 0.5));
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < num_buckets; ++i)
+        {
+            sum += m_counts[i];
+            if (sum >= rank)
+                return std::min(i + 1 < num_buckets ? lower_bound(i + 1) - 1 : m_max, m_max);
+        }
+        return m_max;
+    }
+
+    latency_histogram& operator+=(latency_histogram const& other)
+    {
+        for (std::size_t i = 0; i < num_buckets; ++i) add_bucket(i, other.bucket_count(i));
+        add_max(other.m_max);
+        return *this;
+    }
+};
+
+// latency from posting an operation until its completion is detected, for one peer
+struct peer_latency
+{
+    latency_histogram send;
+    latency_histogram recv;
+
+    peer_latency& operator+=(peer_latency const& other)
+    {
+        send += other.send;
+        recv += other.recv;
+        return *this;
+    }
+};
+
+/**
+ * @brief Gathers the latencies of all communicators of the context on the root rank and prints
+ * rank x peer matrices of the median, 99th percentile and maximum send and receive latency,
+ * followed by the slowest links. Collective over the context's MPI communicator.
+ */
+void print_latency_report(context const& ctxt, std::ostream& os, int root = 0);
+
+} // namespace oomph
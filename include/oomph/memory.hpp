@@ -0,0 +1,42 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace oomph
+{
+// current value and high-water mark since the context was created
+struct high_water
+{
+    std::uint64_t current = 0;
+    std::uint64_t peak = 0;
+};
+
+// Memory held by a context and its communicators, in bytes unless noted otherwise. Registered
+// memory covers the heap of message buffers as well as wrapped user memory.
+struct memory_stats
+{
+    std::vector<high_water> registered_host;   // indexed by NUMA node
+    std::vector<high_water> registered_device; // indexed by device id
+    high_water              rma;               // registered for remote memory access
+    high_water              addresses;         // transport addresses of the peers
+    high_water              request_pools;     // request states of the communicators
+    high_water              queues;            // request, callback and completion queues
+    high_water              total;             // all of the above
+    high_water              workers;           // number of UCX workers
+    high_water              endpoints;         // number of UCX endpoints
+
+    void print(std::ostream& os) const;
+};
+
+} // namespace oomph
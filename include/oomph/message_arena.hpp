@@ -0,0 +1,81 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/message_view.hpp>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace oomph
+{
+/**
+ * @brief Bump allocator carving message views out of one registered slab.
+ *
+ * Instead of allocating (and registering) one message buffer per halo region, all regions of an
+ * exchange are placed into a single contiguous slab. Views are aligned to cache lines. reset()
+ * makes the whole slab available again, invalidating all views handed out before; it must only be
+ * called once the communication on those views has completed. Views stay valid when the arena is
+ * moved.
+ */
+class message_arena
+{
+  public:
+    static constexpr std::size_t alignment = 64;
+
+  private:
+    // behind a stable address: views refer to the message buffer of the slab
+    std::unique_ptr<message_buffer<char>> m_slab;
+    std::size_t                           m_used = 0;
+
+  public:
+    message_arena() = default;
+
+    /** @brief allocate a slab of capacity bytes from a context or communicator */
+    template<typename Factory>
+    message_arena(Factory& factory, std::size_t capacity)
+    : m_slab{std::make_unique<message_buffer<char>>(factory.template make_buffer<char>(capacity))}
+    {
+    }
+
+    message_arena(message_arena const&) = delete;
+    message_arena(message_arena&&) = default;
+    message_arena& operator=(message_arena const&) = delete;
+    message_arena& operator=(message_arena&&) = default;
+
+  public:
+    std::size_t capacity() const noexcept { return m_slab ? m_slab->size() : 0; }
+    std::size_t used() const noexcept { return m_used; }
+
+    /** @brief slab size needed for views of the given element counts of type T */
+    template<typename T>
+    static std::size_t required_capacity(std::size_t count, std::size_t num_views = 1) noexcept
+    {
+        const auto aligned = (count * sizeof(T) + alignment - 1) / alignment * alignment;
+        // the slab itself may be less aligned than a cache line
+        return aligned * num_views + alignment;
+    }
+
+    template<typename T>
+    message_view<T> make_view(std::size_t count)
+    {
+        if (!m_slab) throw std::runtime_error("oomph: message arena exhausted");
+        const auto base = reinterpret_cast<std::uintptr_t>(m_slab->data());
+        const auto first = (base + m_used + alignment - 1) / alignment * alignment - base;
+        const auto last = first + count * sizeof(T);
+        if (last > capacity()) throw std::runtime_error("oomph: message arena exhausted");
+        m_used = last;
+        return {m_slab->m, first, count};
+    }
+
+    void reset() noexcept { m_used = 0; }
+};
+
+} // namespace oomph
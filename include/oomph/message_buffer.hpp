@@ -23,6 +23,10 @@ class message_buffer
   private:
     friend class context;
     friend class communicator;
+    friend class iov_element;
+    friend class message_arena;
+    template<typename U>
+    friend class message_view;
 
   private:
     detail::message_buffer m;
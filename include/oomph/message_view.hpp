@@ -0,0 +1,84 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/message_buffer.hpp>
+#include <cassert>
+
+namespace oomph
+{
+class message_arena;
+
+/**
+ * @brief Non-owning view onto a range of elements of a message buffer.
+ *
+ * Views can be sent and received like message buffers and only transfer the viewed range. A view
+ * refers to the message buffer it was created from and is invalidated when that buffer is moved or
+ * destroyed.
+ */
+template<typename T>
+class message_view
+{
+  public:
+    using value_type = T;
+
+  private:
+    friend class communicator;
+    friend class iov_element;
+    friend class message_arena;
+
+  private:
+    detail::message_buffer::heap_ptr_impl* m_heap_ptr = nullptr;
+    T*                                     m_data = nullptr;
+    std::size_t                            m_offset = 0; // in bytes
+    std::size_t                            m_size = 0;
+
+  private:
+    message_view(detail::message_buffer& m, std::size_t byte_offset, std::size_t size_)
+    : m_heap_ptr{m.m_heap_ptr.get()}
+    , m_data{(T*)((char*)m.m_ptr + byte_offset)}
+    , m_offset{byte_offset}
+    , m_size{size_}
+    {
+    }
+
+  public:
+    message_view() = default;
+
+    message_view(message_buffer<T>& msg, std::size_t offset, std::size_t count)
+    : message_view(msg.m, offset * sizeof(T), count)
+    {
+        assert(msg);
+        assert(offset + count <= msg.size());
+    }
+
+    message_view(message_buffer<T>& msg)
+    : message_view(msg, 0, msg.size())
+    {
+    }
+
+    message_view(message_view const&) = default;
+    message_view& operator=(message_view const&) = default;
+
+  public:
+    operator bool() const noexcept { return m_data; }
+
+    std::size_t size() const noexcept { return m_size; }
+
+    T*       data() const noexcept { return m_data; }
+    T*       begin() const noexcept { return data(); }
+    T*       end() const noexcept { return data() + size(); }
+    T const* cbegin() const noexcept { return data(); }
+    T const* cend() const noexcept { return data() + size(); }
+
+    T& operator[](std::size_t i) const noexcept { return *(data() + i); }
+};
+
+} // namespace oomph
@@ -14,6 +14,12 @@
 
 namespace oomph
 {
+namespace coro
+{
+template<typename Request>
+class request_awaiter;
+} // namespace coro
+
 class send_request
 {
   private:
@@ -21,6 +27,8 @@ class send_request
     using shared_request_ptr = detail::shared_request_ptr;
     friend class communicator;
     friend class communicator_impl;
+    template<typename Request>
+    friend class coro::request_awaiter;
 
     shared_request_ptr m_data;
 
@@ -53,6 +61,8 @@ class recv_request
     using shared_request_ptr = detail::shared_request_ptr;
     friend class communicator;
     friend class communicator_impl;
+    template<typename Request>
+    friend class coro::request_awaiter;
 
     shared_request_ptr m_data;
 
@@ -0,0 +1,280 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/util/unique_function.hpp>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace oomph
+{
+class communicator;
+class communicator_impl;
+
+namespace detail
+{
+// Completion state of a shared_request. Readiness and the list of continuations are kept in one
+// atomic pointer: it holds the (lock-free) stack of pending continuations until the state is
+// completed, after which it points to the state itself. Completion is a release operation and
+// readiness is checked with acquire semantics, so data written before completion (e.g. a received
+// message) is visible to every thread which observes the request as ready.
+class shared_request_state
+{
+  public:
+    using source = std::pair<communicator_impl*, std::thread::id>; // communicator and its owner
+
+  private:
+    struct continuation
+    {
+        util::unique_function<void()> m_f;
+        continuation*                 m_next;
+    };
+
+  private:
+    std::atomic<continuation*> m_continuations{nullptr};
+    std::atomic<std::size_t>   m_ref_count{1};
+
+  public:
+    std::atomic<std::size_t>  m_pending{0}; // outstanding children of a when_all
+    communicator_impl* const  m_comm;       // communicator completing this request (may be null)
+    std::thread::id const     m_owner;      // thread owning m_comm
+    std::vector<source> const m_sources;    // communicators of the children, if more than one
+
+  public:
+    shared_request_state(communicator_impl* comm, std::thread::id owner) noexcept
+    : m_comm{comm}
+    , m_owner{owner}
+    {
+    }
+
+    shared_request_state(std::vector<source>&& sources) noexcept
+    : m_comm{nullptr}
+    , m_sources{std::move(sources)}
+    {
+    }
+
+    shared_request_state(shared_request_state const&) = delete;
+    shared_request_state& operator=(shared_request_state const&) = delete;
+
+    ~shared_request_state()
+    {
+        // continuations of requests which were never completed are dropped
+        auto c = m_continuations.load(std::memory_order_relaxed);
+        while (c && c != done())
+        {
+            auto next = c->m_next;
+            delete c;
+            c = next;
+        }
+    }
+
+  public:
+    void add_ref() noexcept { m_ref_count.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() noexcept
+    {
+        if (m_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    bool is_ready() const noexcept
+    {
+        return m_continuations.load(std::memory_order_acquire) == done();
+    }
+
+    // complete the state and run the continuations in the order they were added; completing an
+    // already completed state has no effect
+    void set_ready()
+    {
+        auto c = m_continuations.exchange(done(), std::memory_order_acq_rel);
+        if (c == done()) return;
+        continuation* r = nullptr;
+        while (c)
+        {
+            auto next = c->m_next;
+            c->m_next = r;
+            r = c;
+            c = next;
+        }
+        while (r)
+        {
+            auto next = r->m_next;
+            r->m_f();
+            delete r;
+            r = next;
+        }
+    }
+
+    // f is invoked by the thread completing the state, or immediately if it is ready already
+    void add_continuation(util::unique_function<void()>&& f)
+    {
+        auto head = m_continuations.load(std::memory_order_acquire);
+        if (head != done())
+        {
+            auto c = new continuation{std::move(f), head};
+            while (c->m_next != done())
+            {
+                if (m_continuations.compare_exchange_weak(c->m_next, c, std::memory_order_acq_rel,
+                        std::memory_order_acquire))
+                    return;
+            }
+            // completed in the meantime
+            f = std::move(c->m_f);
+            delete c;
+        }
+        f();
+    }
+
+  private:
+    continuation* done() const noexcept
+    {
+        // never a valid continuation: marks the state as ready
+        return reinterpret_cast<continuation*>(const_cast<shared_request_state*>(this));
+    }
+};
+} // namespace detail
+
+/**
+ * @brief Request which may be shared between threads.
+ *
+ * Shared requests are returned by the communicator's send_shared/recv_shared functions. They are
+ * reference counted and can be copied, tested and waited on from any thread. They are completed by
+ * the thread which progresses the issuing communicator: waiting on the owning thread progresses
+ * the communicator, while other threads merely observe the completion. Once a request is observed
+ * as ready, the message contents are visible to the observing thread.
+ *
+ * Requests can be composed without polling: then() attaches a continuation, and when_all() and
+ * when_any() return requests which are completed by the completion of their children.
+ */
+class shared_request
+{
+  private:
+    friend class communicator;
+    friend shared_request when_all(std::vector<shared_request> const&);
+    friend shared_request when_any(std::vector<shared_request> const&);
+
+    using state_type = detail::shared_request_state;
+
+  private:
+    state_type* m = nullptr;
+
+  private:
+    shared_request(communicator_impl* comm, std::thread::id owner)
+    : m{new state_type(comm, owner)}
+    {
+    }
+
+    shared_request(std::vector<state_type::source>&& sources)
+    : m{new state_type(std::move(sources))}
+    {
+    }
+
+    // new request completed by the same communicators as this one
+    shared_request make_sibling() const
+    {
+        if (!m) return {nullptr, std::thread::id{}};
+        if (!m->m_sources.empty()) return {std::vector<state_type::source>(m->m_sources)};
+        return {m->m_comm, m->m_owner};
+    }
+
+    // progress the communicators completing this request which are owned by the calling thread
+    // (and back off once if backoff_count is given), returns false if there are none
+    bool progress(std::size_t* backoff_count) const;
+
+    // new request completed by the communicators of all of reqs
+    static shared_request make_parent(std::vector<shared_request> const& reqs);
+    static shared_request make_when_all(std::vector<shared_request> const& reqs);
+    static shared_request make_when_any(std::vector<shared_request> const& reqs);
+
+  public:
+    shared_request() = default;
+
+    shared_request(shared_request const& other) noexcept
+    : m{other.m}
+    {
+        if (m) m->add_ref();
+    }
+
+    shared_request(shared_request&& other) noexcept
+    : m{std::exchange(other.m, nullptr)}
+    {
+    }
+
+    shared_request& operator=(shared_request const& other) noexcept
+    {
+        if (other.m) other.m->add_ref();
+        if (m) m->release();
+        m = other.m;
+        return *this;
+    }
+
+    shared_request& operator=(shared_request&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m) m->release();
+            m = std::exchange(other.m, nullptr);
+        }
+        return *this;
+    }
+
+    ~shared_request()
+    {
+        if (m) m->release();
+    }
+
+  public:
+    bool is_ready() const noexcept { return !m || m->is_ready(); }
+    bool test();
+    void wait();
+
+    /**
+     * @brief attach a continuation
+     *
+     * f is invoked with no arguments by the thread completing this request, or immediately if the
+     * request is ready already. The returned request is ready once f has returned.
+     */
+    template<typename F>
+    shared_request then(F&& f)
+    {
+        auto r = make_sibling();
+        if (!m)
+        {
+            f();
+            r.m->set_ready();
+            return r;
+        }
+        m->add_continuation(
+            [r, f = std::forward<F>(f)]() mutable
+            {
+                f();
+                r.m->set_ready();
+            });
+        return r;
+    }
+};
+
+/** @brief request which is ready once all of the requests are ready */
+inline shared_request
+when_all(std::vector<shared_request> const& reqs)
+{
+    return shared_request::make_when_all(reqs);
+}
+
+/** @brief request which is ready once any of the requests is ready (or if reqs is empty) */
+inline shared_request
+when_any(std::vector<shared_request> const& reqs)
+{
+    return shared_request::make_when_any(reqs);
+}
+
+} // namespace oomph
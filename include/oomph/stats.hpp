@@ -0,0 +1,105 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace oomph
+{
+// messages and bytes posted to or from one peer, and the wait states of the receives from it
+// sampled with OOMPH_WAIT_ANALYSIS
+struct peer_stats
+{
+    std::uint64_t messages_sent = 0;
+    std::uint64_t bytes_sent = 0;
+    std::uint64_t messages_received = 0;
+    std::uint64_t bytes_received = 0;
+    std::uint64_t wait_samples = 0;
+    std::uint64_t late_sender_ns = 0;   // receive posted before the send
+    std::uint64_t late_receiver_ns = 0; // receive posted after the send
+    std::uint64_t transfer_ns = 0;      // from the later of both posts until completion
+
+    peer_stats& operator+=(peer_stats const& other) noexcept
+    {
+        messages_sent += other.messages_sent;
+        bytes_sent += other.bytes_sent;
+        messages_received += other.messages_received;
+        bytes_received += other.bytes_received;
+        wait_samples += other.wait_samples;
+        late_sender_ns += other.late_sender_ns;
+        late_receiver_ns += other.late_receiver_ns;
+        transfer_ns += other.transfer_ns;
+        return *this;
+    }
+};
+
+// Snapshot of the counters of a communicator, or the sum over the communicators of a context.
+// Messages are counted when they are posted; receives from any_source only count towards the
+// totals.
+struct communication_stats
+{
+    // bucket i counts callbacks which took [2^(i-1), 2^i) ns, the last bucket everything longer
+    static constexpr std::size_t num_buckets = 40;
+
+    std::uint64_t messages_sent = 0;
+    std::uint64_t bytes_sent = 0;
+    std::uint64_t messages_received = 0;
+    std::uint64_t bytes_received = 0;
+    std::uint64_t max_sends_in_flight = 0; // high-water marks
+    std::uint64_t max_recvs_in_flight = 0; //
+    std::uint64_t progress_calls = 0;
+    std::uint64_t idle_progress_calls = 0; // progress calls which completed nothing
+    std::uint64_t callbacks = 0;           // callbacks run by the owning thread
+    std::uint64_t callback_ns = 0;         // with OOMPH_TIMING, as the histogram
+    std::uint64_t lock_waits = 0;          // contended acquisitions of the transport lock
+    std::uint64_t lock_wait_ns = 0;
+    std::uint64_t cancellations = 0;
+    std::uint64_t wait_unmatched = 0; // wait analysis samples out of step, see peer_stats
+
+    std::array<std::uint64_t, num_buckets> callback_histogram{};
+    std::vector<peer_stats>                peers; // indexed by rank
+
+    double idle_progress_fraction() const noexcept
+    {
+        return progress_calls ? double(idle_progress_calls) / double(progress_calls) : 0.0;
+    }
+
+    communication_stats& operator+=(communication_stats const& other)
+    {
+        messages_sent += other.messages_sent;
+        bytes_sent += other.bytes_sent;
+        messages_received += other.messages_received;
+        bytes_received += other.bytes_received;
+        max_sends_in_flight = std::max(max_sends_in_flight, other.max_sends_in_flight);
+        max_recvs_in_flight = std::max(max_recvs_in_flight, other.max_recvs_in_flight);
+        progress_calls += other.progress_calls;
+        idle_progress_calls += other.idle_progress_calls;
+        callbacks += other.callbacks;
+        callback_ns += other.callback_ns;
+        lock_waits += other.lock_waits;
+        lock_wait_ns += other.lock_wait_ns;
+        cancellations += other.cancellations;
+        wait_unmatched += other.wait_unmatched;
+        for (std::size_t i = 0; i < num_buckets; ++i)
+            callback_histogram[i] += other.callback_histogram[i];
+        if (peers.size() < other.peers.size()) peers.resize(other.peers.size());
+        for (std::size_t i = 0; i < other.peers.size(); ++i) peers[i] += other.peers[i];
+        return *this;
+    }
+
+    // human readable report, peers without traffic are omitted
+    void print(std::ostream& os) const;
+};
+
+} // namespace oomph
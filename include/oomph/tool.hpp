@@ -0,0 +1,103 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <mpi.h>
+#include <cstddef>
+#include <cstdint>
+
+// Interface for profilers and other tools which observe the communication of oomph. A tool fills
+// in a hooks table and attaches it, either by calling attach_tool or by building a shared library
+// which exports
+//
+//     extern "C" void oomph_tool_init(oomph::tool::hooks* h);
+//
+// and naming it in the environment variable OOMPH_TOOL: the library is loaded when the first
+// context is created and oomph_tool_init may fill in the table passed to it. Without a tool, every
+// hook costs a single predictable branch.
+namespace oomph
+{
+namespace tool
+{
+enum class operation_kind : int
+{
+    send,
+    recv
+};
+
+// Contexts and communicators are identified by opaque handles which are unique while they exist.
+struct context_info
+{
+    void const* context;
+    MPI_Comm    mpi_comm;
+    int         rank;
+    int         size;
+    bool        thread_safe;
+};
+
+struct operation_info
+{
+    void const*    communicator;
+    operation_kind kind;
+    int            peer; // communicator::any_source for receives from any rank
+    int            tag;
+    std::size_t    size; // in bytes
+};
+
+// Completions are reported by the thread owning the communicator when they are detected, which is
+// not necessarily in the order of posting. Receives from any rank report a peer of -1.
+struct completion_info
+{
+    void const*    communicator;
+    operation_kind kind;
+    int            peer;
+    std::uint64_t  latency_ns; // since posting, 0 if the tool was attached after posting
+};
+
+// Setup and teardown of a context are divided into phases (e.g. "rank_topology", "rma_window",
+// "address_exchange", "endpoint_close"), which depend on the transport layer. Each is reported when
+// it ends, the setup phases before context_created. The name is a string literal.
+struct phase_info
+{
+    void const*   context;
+    char const*   name;
+    std::uint64_t duration_ns;
+};
+
+// Table of hooks, each of which may be null. Every hook receives user_data as first argument. The
+// hooks of a communicator are called by the thread using it, the others by the thread creating or
+// destroying the context.
+struct hooks
+{
+    void (*context_created)(void* user_data, context_info const& info) = nullptr;
+    void (*context_destroyed)(void* user_data, void const* context) = nullptr;
+    void (*communicator_created)(
+        void* user_data, void const* context, void const* communicator) = nullptr;
+    void (*communicator_destroyed)(void* user_data, void const* communicator) = nullptr;
+    void (*posted)(void* user_data, operation_info const& op) = nullptr;
+    void (*completed)(void* user_data, completion_info const& c) = nullptr;
+    void (*cancelled)(void* user_data, void const* communicator) = nullptr;
+    // completed counts the operations and callbacks completed by this progress call
+    void (*progressed)(void* user_data, void const* communicator, std::size_t completed) = nullptr;
+    void (*phase)(void* user_data, phase_info const& p) = nullptr;
+    void* user_data = nullptr;
+};
+
+/**
+ * @brief Attaches a tool, replacing the current one. The table is copied. Tools may be attached
+ * and detached at any time, but other threads may still invoke the hooks of the previous table
+ * for a short while.
+ */
+void attach_tool(hooks const& h);
+
+void detach_tool();
+
+} // namespace tool
+} // namespace oomph
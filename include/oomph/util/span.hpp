@@ -0,0 +1,88 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace oomph
+{
+namespace util
+{
+// non-owning view of a contiguous range of elements (subset of C++20 std::span)
+template<typename T>
+class span
+{
+  public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = std::size_t;
+    using pointer = T*;
+    using reference = T&;
+    using iterator = T*;
+
+  private:
+    T*          m_data = nullptr;
+    std::size_t m_size = 0;
+
+  public:
+    constexpr span() noexcept = default;
+
+    constexpr span(T* data, std::size_t size) noexcept
+    : m_data{data}
+    , m_size{size}
+    {
+    }
+
+    template<std::size_t N>
+    constexpr span(T (&arr)[N]) noexcept
+    : m_data{arr}
+    , m_size{N}
+    {
+    }
+
+    // any contiguous container with data() and size(), e.g. std::vector or std::array
+    template<typename Container,
+        typename = std::enable_if_t<
+            !std::is_same<std::remove_cv_t<std::remove_reference_t<Container>>, span>::value &&
+            std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>>
+    constexpr span(Container&& c) noexcept(noexcept(c.data()) && noexcept(c.size()))
+    : m_data{c.data()}
+    , m_size{static_cast<std::size_t>(c.size())}
+    {
+    }
+
+    constexpr span(span const&) noexcept = default;
+    constexpr span& operator=(span const&) noexcept = default;
+
+  public:
+    constexpr T*          data() const noexcept { return m_data; }
+    constexpr std::size_t size() const noexcept { return m_size; }
+    constexpr bool        empty() const noexcept { return m_size == 0; }
+    constexpr T*          begin() const noexcept { return m_data; }
+    constexpr T*          end() const noexcept { return m_data + m_size; }
+
+    constexpr T& operator[](std::size_t i) const noexcept
+    {
+        assert(i < m_size);
+        return m_data[i];
+    }
+
+    constexpr span subspan(std::size_t offset, std::size_t count) const noexcept
+    {
+        assert(offset + count <= m_size);
+        return {m_data + offset, count};
+    }
+};
+
+} // namespace util
+} // namespace oomph
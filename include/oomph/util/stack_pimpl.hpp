@@ -38,6 +38,9 @@ class stack_pimpl
     T&       operator*() noexcept { return *m.get(); }
     T const& operator*() const noexcept { return *m.get(); }
 
+    T*       get() noexcept { return m.get(); }
+    T const* get() const noexcept { return m.get(); }
+
     //T release() { return m.release(); }
 };
 
@@ -9,9 +9,12 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <typeinfo>
 #include <type_traits>
+#include <utility>
 
 namespace oomph
 {
@@ -25,7 +28,8 @@ namespace detail
 template<typename R, typename... Args>
 struct unique_function
 {
-    virtual R invoke(Args&&... args) = 0;
+    virtual R                invoke(Args&&... args) = 0;
+    virtual unique_function* move_to(void* buffer) noexcept = 0;
     virtual ~unique_function(){};
 };
 
@@ -41,6 +45,11 @@ struct unique_function_impl : unique_function<R, Args...>
     }
 
     virtual R invoke(Args&&... args) final override { return func(std::forward<Args>(args)...); }
+
+    virtual unique_function<R, Args...>* move_to(void* buffer) noexcept final override
+    {
+        return ::new (buffer) unique_function_impl(std::move(func));
+    }
 };
 
 // specialization for void function
@@ -56,29 +65,56 @@ struct unique_function_impl<Func, void, Args...> : unique_function<void, Args...
     }
 
     virtual void invoke(Args&&... args) final override { func(std::forward<Args>(args)...); }
+
+    virtual unique_function<void, Args...>* move_to(void* buffer) noexcept final override
+    {
+        return ::new (buffer) unique_function_impl(std::move(func));
+    }
 };
 
 } // namespace detail
 
+// Move-only type-erased function. Function objects of up to buffer_size bytes which are nothrow
+// move constructible are stored inline, such that the usual completion callbacks (which hold a
+// request and possibly a message buffer) do not allocate. Larger ones are stored on the heap.
 template<typename R, typename... Args>
 class unique_function<R(Args...)>
 {
+  public:
+    static constexpr std::size_t buffer_size = 144;
+
   private: // members
     using interface_t = detail::unique_function<R, Args...>;
-    using u_ptr_t = std::unique_ptr<interface_t>;
     template<typename F>
     using result_t = std::result_of_t<F&(Args...)>;
     template<typename F>
     using concrete_t = detail::unique_function_impl<std::decay_t<F>, R, Args...>;
+    using buffer_t = std::aligned_storage_t<buffer_size, alignof(std::max_align_t)>;
+    template<typename F>
+    using fits_buffer = std::integral_constant<bool,
+        sizeof(concrete_t<F>) <= buffer_size &&
+            alignof(concrete_t<F>) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<std::decay_t<F>>::value>;
 
-    u_ptr_t impl;
+    interface_t* m_ptr = nullptr;
+    buffer_t     m_buffer;
 
   public: // ctors
-    unique_function() = default;
+    unique_function() noexcept = default;
     unique_function(unique_function const&) = delete;
     unique_function& operator=(unique_function const&) = delete;
-    unique_function(unique_function&& other) = default;
-    unique_function& operator=(unique_function&& other) = default;
+
+    unique_function(unique_function&& other) noexcept { take(other); }
+
+    unique_function& operator=(unique_function&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
 
     template<typename F,
         // F can be invoked with Args and return type can be converted to R
@@ -86,14 +122,53 @@ class unique_function<R(Args...)>
         // F is not a unique_function
         std::enable_if_t<!std::is_same<std::decay_t<F>, unique_function>::value, int>* = nullptr>
     unique_function(F&& f)
-    : impl{std::make_unique<concrete_t<F>>(std::forward<F>(f))}
     {
+        if constexpr (fits_buffer<F>::value)
+            m_ptr = ::new (&m_buffer) concrete_t<F>(std::forward<F>(f));
+        else
+            m_ptr = new concrete_t<F>(std::forward<F>(f));
     }
 
+    ~unique_function() { reset(); }
+
   public: // member functions
-    R operator()(Args... args) const { return impl->invoke(std::forward<Args>(args)...); }
+    R operator()(Args... args) const { return m_ptr->invoke(std::forward<Args>(args)...); }
 
-    interface_t* release() noexcept { return impl.release(); }
+    explicit operator bool() const noexcept { return m_ptr; }
+
+    // the stored function object, which must have been constructed from an F
+    template<typename F>
+    std::decay_t<F>* target() noexcept
+    {
+        return m_ptr ? &static_cast<concrete_t<F>*>(m_ptr)->func : nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (!m_ptr) return;
+        if (is_inline()) m_ptr->~interface_t();
+        else
+            delete m_ptr;
+        m_ptr = nullptr;
+    }
+
+  private:
+    bool is_inline() const noexcept
+    {
+        return static_cast<void const*>(m_ptr) == static_cast<void const*>(&m_buffer);
+    }
+
+    void take(unique_function& other) noexcept
+    {
+        if (!other.m_ptr) return;
+        if (other.is_inline())
+        {
+            m_ptr = other.m_ptr->move_to(&m_buffer);
+            other.reset();
+        }
+        else
+            m_ptr = std::exchange(other.m_ptr, nullptr);
+    }
 };
 
 } // namespace util
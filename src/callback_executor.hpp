@@ -0,0 +1,91 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/communicator.hpp>
+#include "./thread_pool.hpp"
+#include "./memory_accounting.hpp"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace oomph
+{
+// Per-communicator state for callbacks which are not invoked immediately: deferred callbacks are
+// run by the owning thread on demand, while callbacks run by the thread pool hand their requests
+// back to the owning thread, which completes them during progress.
+class callback_executor
+{
+  public:
+    using function_type = util::unique_function<void()>;
+    using shared_request_ptr = communicator::shared_request_ptr;
+
+  private:
+    charged_vector<function_type>      m_deferred;
+    charged_vector<function_type>      m_running;
+    std::mutex                         m_mutex;
+    charged_vector<shared_request_ptr> m_completed; // protected by m_mutex
+    charged_vector<shared_request_ptr> m_completing;
+    std::atomic<bool>                  m_has_completed{false};
+
+  public:
+    // the capacity of the queues is charged through the allocator a
+    callback_executor(charged_allocator<char> a = {})
+    : m_deferred(a)
+    , m_running(a)
+    , m_completed(a)
+    , m_completing(a)
+    {
+    }
+
+    void defer(function_type&& f) { m_deferred.push_back(std::move(f)); }
+
+    // callbacks deferred while running are run by the next call
+    template<typename Invoke>
+    std::size_t run_deferred(Invoke&& invoke)
+    {
+        if (m_deferred.empty()) return 0;
+        m_running.swap(m_deferred);
+        for (auto& f : m_running) invoke(f);
+        auto const n = m_running.size();
+        m_running.clear();
+        return n;
+    }
+
+    // called by a pool thread once the callback has returned
+    void complete(shared_request_ptr&& req)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_completed.push_back(std::move(req));
+        m_has_completed.store(true, std::memory_order_release);
+    }
+
+    // called by the owning thread, returns the number of completed requests
+    std::size_t progress()
+    {
+        if (!m_has_completed.load(std::memory_order_acquire)) return 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_completing.swap(m_completed);
+            m_has_completed.store(false, std::memory_order_relaxed);
+        }
+        for (auto& req : m_completing)
+        {
+            req->set_ready();
+            --(*(req->m_scheduled));
+        }
+        auto const n = m_completing.size();
+        m_completing.clear();
+        return n;
+    }
+};
+
+} // namespace oomph
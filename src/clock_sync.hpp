@@ -0,0 +1,148 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/util/mpi_error.hpp>
+#include <oomph/util/mpi_comm_holder.hpp>
+#include "./env.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace oomph
+{
+// Maps the local steady clock to the one of rank 0 of a communicator. The offset is measured
+// NTP-style along a binary tree rooted at rank 0: each rank exchanges OOMPH_CLOCK_SYNC_ROUNDS
+// (default 8) ping-pongs with its parent, keeps the one with the shortest round trip and adds the
+// offset of the parent to rank 0. The offset to the parent is known within half of that round
+// trip, which adds up along the path to rank 0. Successive synchronizations also estimate the
+// drift, which is extrapolated in between.
+class clock_sync
+{
+  private:
+    static constexpr int tag_ping = 1;
+    static constexpr int tag_pong = 2;
+    static constexpr int tag_offset = 3;
+
+    struct model
+    {
+        std::int64_t m_ref = 0;    // local time of the measurement
+        std::int64_t m_offset = 0; // at m_ref
+        double       m_drift = 0;  // change of the offset per ns
+        std::int64_t m_error = 0;  // bound on the error of m_offset
+    };
+
+    util::mpi_comm_holder m_comm;
+    int const             m_rounds;
+    // readers use the current model while the other one is updated
+    model            m_models[2];
+    std::atomic<int> m_current{0};
+    bool             m_synchronized = false;
+
+  public:
+    // collective
+    clock_sync(MPI_Comm comm)
+    : m_comm{comm}
+    , m_rounds{(int)env_size("OOMPH_CLOCK_SYNC_ROUNDS", 8)}
+    {
+        synchronize();
+    }
+
+    clock_sync(clock_sync const&) = delete;
+    clock_sync& operator=(clock_sync const&) = delete;
+
+    static std::int64_t local_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // offset to the clock of rank 0 at local time t
+    std::int64_t offset(std::int64_t t) const noexcept
+    {
+        auto const& m = m_models[m_current.load(std::memory_order_acquire)];
+        return m.m_offset + (std::int64_t)(m.m_drift * double(t - m.m_ref));
+    }
+
+    std::int64_t global_ns(std::int64_t t) const noexcept { return t + offset(t); }
+    std::int64_t global_ns() const noexcept { return global_ns(local_ns()); }
+
+    // bound on the error of the offset at the last synchronization (0 if there was none)
+    std::int64_t error_ns() const noexcept
+    {
+        return m_models[m_current.load(std::memory_order_acquire)].m_error;
+    }
+
+    // collective: measures the offset again and updates the drift estimate
+    void synchronize()
+    {
+        if (m_rounds <= 0) return;
+        MPI_Comm const comm = m_comm.get();
+        int            rank, size;
+        OOMPH_CHECK_MPI_RESULT(MPI_Comm_rank(comm, &rank));
+        OOMPH_CHECK_MPI_RESULT(MPI_Comm_size(comm, &size));
+
+        std::int64_t offset[2] = {0, 0}; // offset to rank 0 and its error bound
+        std::int64_t ref = local_ns();
+        if (rank > 0)
+        {
+            int const    parent = (rank - 1) / 2;
+            std::int64_t best_rtt = std::numeric_limits<std::int64_t>::max();
+            std::int64_t to_parent = 0;
+            for (int i = 0; i < m_rounds; ++i)
+            {
+                std::int64_t remote;
+                auto const   t0 = local_ns();
+                OOMPH_CHECK_MPI_RESULT(MPI_Send(nullptr, 0, MPI_BYTE, parent, tag_ping, comm));
+                OOMPH_CHECK_MPI_RESULT(
+                    MPI_Recv(&remote, 1, MPI_INT64_T, parent, tag_pong, comm, MPI_STATUS_IGNORE));
+                auto const t1 = local_ns();
+                if (t1 - t0 < best_rtt)
+                {
+                    best_rtt = t1 - t0;
+                    ref = t0 + (t1 - t0) / 2;
+                    to_parent = remote - ref;
+                }
+            }
+            OOMPH_CHECK_MPI_RESULT(
+                MPI_Recv(offset, 2, MPI_INT64_T, parent, tag_offset, comm, MPI_STATUS_IGNORE));
+            offset[0] += to_parent;
+            offset[1] += (best_rtt + 1) / 2;
+        }
+        for (int child = 2 * rank + 1; child <= 2 * rank + 2 && child < size; ++child)
+        {
+            for (int i = 0; i < m_rounds; ++i)
+            {
+                OOMPH_CHECK_MPI_RESULT(
+                    MPI_Recv(nullptr, 0, MPI_BYTE, child, tag_ping, comm, MPI_STATUS_IGNORE));
+                auto const now = local_ns();
+                OOMPH_CHECK_MPI_RESULT(MPI_Send(&now, 1, MPI_INT64_T, child, tag_pong, comm));
+            }
+            OOMPH_CHECK_MPI_RESULT(MPI_Send(offset, 2, MPI_INT64_T, child, tag_offset, comm));
+        }
+
+        auto const  current = m_current.load(std::memory_order_relaxed);
+        auto const& last = m_models[current];
+        auto&       next = m_models[1 - current];
+        next.m_ref = ref;
+        next.m_offset = offset[0];
+        next.m_drift = (m_synchronized && ref > last.m_ref)
+                           ? double(offset[0] - last.m_offset) / double(ref - last.m_ref)
+                           : 0.0;
+        next.m_error = offset[1];
+        m_current.store(1 - current, std::memory_order_release);
+        m_synchronized = true;
+    }
+};
+
+} // namespace oomph
@@ -11,6 +11,13 @@
 #pragma once
 
 #include "./context_base.hpp"
+#include "./callback_executor.hpp"
+#include "./stats_counters.hpp"
+#include "./trace_format.hpp"
+#include "./tool_hooks.hpp"
+#include "./wait_analysis.hpp"
+#include "./recorder.hpp"
+#include <sched.h>
 
 namespace oomph
 {
@@ -19,13 +26,66 @@ class communicator_base
 {
   public:
     using rank_type = communicator::rank_type;
+    using tag_type = communicator::tag_type;
+    using time_point = latency_recorder::clock_type::time_point;
+
+    // records progress_end on destruction if progress_begin was recorded
+    struct trace_progress_scope
+    {
+#if OOMPH_ENABLE_TRACING
+        trace_ring* m_ring;
+        ~trace_progress_scope()
+        {
+            if (m_ring) m_ring->push(trace_event::progress_end, 0);
+        }
+#endif
+    };
 
   protected:
     context_base* m_context;
+    bool const    m_timing; // latencies and callbacks are timed
+#if OOMPH_ENABLE_TRACING
+    trace_ring* m_trace = nullptr;
+#endif
+    std::unique_ptr<wait_analysis> m_wait;             // null unless enabled
+    record_stream*                 m_record = nullptr; // owned by the recorder of the context
+    boost::pool<>*                 m_request_pool = nullptr; // owned by the communicator
+    std::size_t                    m_request_pool_next = 0;  // next chunk size when last charged
+    detail::completion_queue*      m_cq = nullptr; // owned by the communicator, if enabled
+    memory_charge                  m_request_pool_memory;
+    memory_charge                  m_cq_memory;
+
+  public:
+    callback_executor      m_executor;
+    communication_counters m_stats;
 
     communicator_base(context_base* ctxt)
     : m_context(ctxt)
+    , m_timing{ctxt->timing()}
+    , m_request_pool_memory{ctxt->get_memory().charge_request_pool()}
+    , m_cq_memory{ctxt->get_memory().charge_queues()}
+    , m_executor{ctxt->get_memory().queue_allocator()}
+    , m_stats(ctxt->size())
     {
+        m_context->register_counters(&m_stats);
+#if OOMPH_ENABLE_TRACING
+        if (auto t = m_context->get_tracer()) m_trace = t->make_ring();
+#endif
+        if (auto c = m_context->get_wait_channel())
+            m_wait = std::make_unique<wait_analysis>(*c, m_context->clock());
+        if (auto r = m_context->get_recorder()) m_record = r->make_stream();
+        if (auto const t = tool::attached(); t && t->communicator_created)
+            t->communicator_created(t->user_data, m_context, this);
+    }
+
+    ~communicator_base()
+    {
+        if (auto const t = tool::attached(); t && t->communicator_destroyed)
+            t->communicator_destroyed(t->user_data, this);
+#if OOMPH_ENABLE_TRACING
+        if (m_trace) m_context->get_tracer()->release(m_trace);
+#endif
+        m_context->deregister_counters(&m_stats);
     }
 
   public:
@@ -35,5 +95,256 @@ class communicator_base
     rank_topology const& topology() const noexcept { return m_context->topology(); }
     void release() { m_context->deregister_communicator(static_cast<Communicator*>(this)); }
     bool is_local(rank_type rank) const noexcept { return topology().is_local(rank); }
+    thread_pool& callback_pool() { return m_context->callback_pool(); }
+
+    // Bookkeeping of posted and completed operations: statistics, latency and tool hooks. Only the
+    // thread owning the communicator may call these.
+
+    void on_send_post(rank_type dst, tag_type tag, std::size_t size, std::size_t in_flight)
+    {
+        charge_request_pool();
+        m_stats.post_send(dst, size, in_flight);
+        if (m_wait) m_wait->post_send(dst, tag);
+        if (auto const t = tool::attached(); t && t->posted)
+            t->posted(t->user_data,
+                tool::operation_info{this, tool::operation_kind::send, dst, tag, size});
+    }
+
+    // returns a non-zero slot if the receive is sampled for wait analysis: its completion must
+    // then be reported through on_sampled_recv_completion
+    std::uint32_t on_recv_post(rank_type src, tag_type tag, std::size_t size, std::size_t in_flight)
+    {
+        charge_request_pool();
+        m_stats.post_recv(src, size, in_flight);
+        if (auto const t = tool::attached(); t && t->posted)
+            t->posted(t->user_data,
+                tool::operation_info{this, tool::operation_kind::recv, src, tag, size});
+        return m_wait ? m_wait->post_recv(src, tag) : 0;
+    }
+
+    // Post time of an operation, passed back to on_send_completion or on_recv_completion: the clock
+    // is only read if latencies are recorded (OOMPH_TIMING) or a tool observes completions.
+    time_point post_time() const noexcept
+    {
+        if (m_timing) return latency_recorder::clock_type::now();
+        if (auto const t = tool::attached(); t && t->completed)
+            return latency_recorder::clock_type::now();
+        return {};
+    }
+
+    void on_sampled_recv_completion(std::uint32_t slot) { m_wait->complete_recv(slot, m_stats); }
+
+    void on_send_completion(rank_type dst, time_point post) noexcept
+    {
+        on_completion(tool::operation_kind::send, m_stats.m_send_latency, dst, post);
+    }
+
+    void on_recv_completion(rank_type src, time_point post) noexcept
+    {
+        on_completion(tool::operation_kind::recv, m_stats.m_recv_latency, src, post);
+    }
+
+    void on_cancel() noexcept
+    {
+        m_stats.cancellation();
+        if (auto const t = tool::attached(); t && t->cancelled) t->cancelled(t->user_data, this);
+    }
+
+    // n: number of operations and callbacks completed by the progress call
+    void on_progress(std::size_t n)
+    {
+        m_stats.progress(n > 0);
+        if (m_wait) m_wait->progress(m_stats);
+        if (auto const t = tool::attached(); t && t->progressed)
+            t->progressed(t->user_data, this, n);
+    }
+
+    // The request pool of the communicator is charged when it has allocated a chunk for the
+    // request of the operation being posted. The completion queue does not grow.
+    void set_request_pool(boost::pool<>* p) noexcept { m_request_pool = p; }
+
+    void set_completion_queue(detail::completion_queue* q) noexcept
+    {
+        m_cq = q;
+        m_cq_memory.resize(q->capacity() * sizeof(completion));
+    }
+
+  private:
+    void charge_request_pool() noexcept
+    {
+        if (!m_request_pool || m_request_pool->get_next_size() == m_request_pool_next) return;
+        m_request_pool_next = m_request_pool->get_next_size();
+        m_request_pool_memory.resize(pool_bytes(*m_request_pool));
+    }
+
+  public:
+
+    // whether completions of receives need to be reported with their outcome, see below
+    bool report_completions() const noexcept { return m_cq; }
+
+    // Recording hooks, see recorder: record_post returns a non-zero operation index if recording,
+    // whose completion must then be reported through on_recorded_completion.
+
+    std::uint32_t record_post(record_kind k, rank_type peer, tag_type tag, std::size_t size)
+    {
+        return m_record ? m_record->post(k, peer, tag, size) : 0;
+    }
+
+    void on_recorded_completion(std::uint32_t op) { m_record->complete(op); }
+
+    // excludes the time spent in progress from the recorded gaps
+    struct record_progress_scope
+    {
+        record_stream* m_stream;
+        ~record_progress_scope()
+        {
+            if (m_stream) m_stream->end_progress();
+        }
+    };
+
+    record_progress_scope record_progress() noexcept
+    {
+        if (m_record) m_record->begin_progress();
+        return {m_record};
+    }
+
+  private:
+    void on_completion(tool::operation_kind k, latency_recorder& latency, rank_type peer,
+        time_point post) noexcept
+    {
+        auto const t = tool::attached();
+        bool const hook = t && t->completed;
+        if (!m_timing && !hook) return;
+        // not timed if the tool was attached after posting
+        auto const ns = post == time_point{} ? 0 : communication_counters::elapsed_ns(post);
+        if (m_timing) latency.record(peer, ns);
+        if (hook) t->completed(t->user_data, tool::completion_info{this, k, peer, ns});
+    }
+
+  public:
+    // called by blocking waits after each progress call: every progress_spin calls, the core is
+    // yielded to other processes or threads sharing it, see tuning
+    void backoff(std::size_t& n) noexcept
+    {
+        auto const spin = m_context->get_tuning().m_progress_spin;
+        if (spin && ++n == spin)
+        {
+            n = 0;
+            sched_yield();
+        }
+    }
+
+    // reports the outcome of an operation (or none) to the completion queue while its completion
+    // handler runs, handlers run by nested progress calls report their own
+    struct report_scope
+    {
+        detail::completion_queue*           m_cq;
+        detail::transport_completion const* m_outer;
+
+        report_scope(detail::completion_queue* q, detail::transport_completion const* t) noexcept
+        : m_cq{q}
+        , m_outer{q ? q->reported() : nullptr}
+        {
+            if (m_cq) m_cq->set_reported(t);
+        }
+
+        ~report_scope()
+        {
+            if (m_cq) m_cq->set_reported(m_outer);
+        }
+    };
+
+    // invokes a completion handler, counting it if it is the user callback (and timing it with
+    // OOMPH_TIMING); if the handler records
+    // the completion in the completion queue, peer, bytes and status are taken from t if given.
+    // Returns false if t was given but not recorded, i.e. the handler is not the one of an
+    // operation posted to the completion queue.
+    template<typename F>
+    bool run_completion_handler(F& f, detail::transport_completion const* t = nullptr)
+    {
+        report_scope const r{m_cq, t};
+        if (!m_stats.m_time_completion_handlers) f();
+        else if (!m_timing)
+        {
+            f();
+            m_stats.callback();
+        }
+        else
+        {
+            auto const start = communication_counters::clock_type::now();
+            f();
+            m_stats.callback(communication_counters::elapsed_ns(start));
+        }
+        return !t || (m_cq && m_cq->reported() != t);
+    }
+
+    std::size_t run_deferred()
+    {
+        return m_executor.run_deferred(
+            [this](callback_executor::function_type& f)
+            {
+                if (!m_timing)
+                {
+                    f();
+                    m_stats.callback();
+                    return;
+                }
+                auto const start = communication_counters::clock_type::now();
+                f();
+                m_stats.callback(communication_counters::elapsed_ns(start));
+            });
+    }
+
+    // locks m, recording the time spent waiting if the lock is contended
+    template<typename Mutex>
+    void lock(Mutex& m)
+    {
+        if (m.try_lock()) return;
+        trace(trace_event::lock_wait_begin);
+        auto const start = communication_counters::clock_type::now();
+        m.lock();
+        m_stats.lock_wait(communication_counters::elapsed_ns(start));
+        trace(trace_event::lock_wait_end);
+    }
+
+  public:
+    // Tracing hooks: no-ops unless OOMPH_ENABLE_TRACING is set and the tracer is enabled at run
+    // time. Only the thread owning the communicator may call them.
+
+    // returns a non-zero message id if the posted message is sampled for tracing
+    std::uint32_t trace_post(
+        [[maybe_unused]] trace_event e, [[maybe_unused]] rank_type peer,
+        [[maybe_unused]] tag_type tag, [[maybe_unused]] std::size_t size) noexcept
+    {
+#if OOMPH_ENABLE_TRACING
+        if (!m_trace) return 0;
+        auto const id = m_trace->sample_message();
+        if (id) m_trace->push(e, id, peer, tag, size);
+        return id;
+#else
+        return 0;
+#endif
+    }
+
+    void trace([[maybe_unused]] trace_event e, [[maybe_unused]] std::uint32_t id = 0) noexcept
+    {
+#if OOMPH_ENABLE_TRACING
+        if (m_trace) m_trace->push(e, id);
+#endif
+    }
+
+    trace_progress_scope trace_progress() noexcept
+    {
+#if OOMPH_ENABLE_TRACING
+        if (m_trace && m_trace->sample_progress())
+        {
+            m_trace->push(trace_event::progress_begin, 0);
+            return {m_trace};
+        }
+        return {nullptr};
+#else
+        return {};
+#endif
+    }
 };
 } // namespace oomph
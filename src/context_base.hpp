@@ -10,11 +10,27 @@
  */
 #pragma once
 
+#include <oomph/config.hpp>
 #include <oomph/context.hpp>
 #include "./mpi_comm.hpp"
 #include "./unique_ptr_set.hpp"
 #include "./rank_topology.hpp"
+#include "./thread_pool.hpp"
+#include "./env.hpp"
+#include "./stats_counters.hpp"
+#include "./tool_hooks.hpp"
+#include "./wait_analysis.hpp"
+#include "./clock_sync.hpp"
+#include "./recorder.hpp"
+#include "./tuning.hpp"
+#include "./memory_accounting.hpp"
+#if OOMPH_ENABLE_TRACING
+#include "./tracer.hpp"
+#endif
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
 
 namespace oomph
 {
@@ -26,14 +42,50 @@ class context_base
   protected:
     mpi_comm                          m_mpi_comm;
     bool const                        m_thread_safe;
+    bool const                        m_timing; // OOMPH_TIMING, read once
     rank_topology const               m_rank_topology;
+    clock_sync                        m_clock;
+    tuning const                      m_tuning;
+    memory_accounting                 m_memory; // outlives everything holding memory
+#if OOMPH_ENABLE_TRACING
+    std::unique_ptr<tracer>           m_tracer; // outlives the communicators
+#endif
+    std::unique_ptr<wait_channel>     m_wait_channel; // null unless OOMPH_WAIT_ANALYSIS is set
+    std::unique_ptr<recorder>         m_recorder;     // outlives the communicators
+    mutable std::mutex                m_stats_mutex;
+    std::set<communication_counters*> m_counters;      // of the live communicators
+    communication_stats               m_retired_stats; // of the released communicators
+    std::vector<peer_latency>         m_retired_latency;
     unique_ptr_set<communicator_impl> m_comms_set;
+    std::once_flag                    m_callback_pool_flag;
+    std::unique_ptr<thread_pool>      m_callback_pool; // created on first use
+    std::unique_ptr<stats_dump>       m_stats_dump; // stopped before anything else
+
+  protected:
+    // see tool::hooks::phase
+    tool::phase_timer phase(char const* name) const { return {this, name}; }
+
+    template<typename F>
+    auto timed_phase(char const* name, F&& f) const
+    {
+        return tool::timed_phase(this, name, std::forward<F>(f));
+    }
 
   public:
-    context_base(MPI_Comm comm, bool thread_safe)
-    : m_mpi_comm{comm}
+    // backend: name of the transport layer, used to identify tuning profiles
+    context_base(MPI_Comm comm, bool thread_safe, char const* backend)
+    : m_mpi_comm{(tool::detail::load_from_env(), comm)} // the tool observes the setup phases
     , m_thread_safe{thread_safe}
-    , m_rank_topology(comm)
+    , m_timing{env_size("OOMPH_TIMING", 0) != 0}
+    , m_rank_topology{timed_phase("rank_topology", [comm]() { return rank_topology(comm); })}
+    , m_clock{timed_phase("clock_sync", [comm]() { return clock_sync(comm); })}
+    , m_tuning{timed_phase("tuning",
+          [this, comm, backend]() { return tuning::from_env(comm, m_rank_topology, backend); })}
+#if OOMPH_ENABLE_TRACING
+    , m_tracer{tracer::from_env(m_mpi_comm.rank())}
+#endif
+    , m_wait_channel{wait_channel::from_env(comm)}
+    , m_recorder{recorder::from_env(m_mpi_comm.rank(), m_mpi_comm.size())}
     {
         int mpi_thread_safety;
         OOMPH_CHECK_MPI_RESULT(MPI_Query_thread(&mpi_thread_safety));
@@ -41,6 +93,24 @@ class context_base
             throw std::runtime_error("oomph: MPI is not thread safe!");
         else if (!m_thread_safe && !(mpi_thread_safety == MPI_THREAD_SINGLE))
             std::cerr << "oomph warning: MPI thread safety is higher than required" << std::endl;
+#if OOMPH_ENABLE_TRACING
+        if (m_tracer) m_tracer->set_clock_offset(m_clock.offset(m_tracer->time_base()));
+#endif
+        m_stats_dump = stats_dump::from_env(rank(),
+            [this](std::ostream& os)
+            {
+                stats().print(os);
+                memory().print(os);
+            });
+        if (auto const t = tool::attached(); t && t->context_created)
+            t->context_created(
+                t->user_data, tool::context_info{this, comm, rank(), size(), m_thread_safe});
+    }
+
+    ~context_base()
+    {
+        if (auto const t = tool::attached(); t && t->context_destroyed)
+            t->context_destroyed(t->user_data, this);
     }
 
   public:
@@ -50,6 +120,74 @@ class context_base
     MPI_Comm             get_comm() const noexcept { return m_mpi_comm; }
 
     void deregister_communicator(communicator_impl* c) { m_comms_set.remove(c); }
+
+#if OOMPH_ENABLE_TRACING
+    tracer* get_tracer() noexcept { return m_tracer.get(); }
+#endif
+
+    clock_sync const& clock() const noexcept { return m_clock; }
+    tuning const&     get_tuning() const noexcept { return m_tuning; }
+
+    // whether the communicators time their operations and callbacks, see communicator_base
+    bool timing() const noexcept { return m_timing; }
+
+    // collective
+    void synchronize_clocks()
+    {
+        m_clock.synchronize();
+#if OOMPH_ENABLE_TRACING
+        if (m_tracer) m_tracer->set_clock_offset(m_clock.offset(m_tracer->time_base()));
+#endif
+    }
+
+    wait_channel const* get_wait_channel() const noexcept { return m_wait_channel.get(); }
+
+    recorder* get_recorder() noexcept { return m_recorder.get(); }
+
+    memory_accounting& get_memory() noexcept { return m_memory; }
+    memory_stats       memory() const { return m_memory.read(); }
+
+    void register_counters(communication_counters* c)
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        m_counters.insert(c);
+    }
+
+    // the counters of released communicators are kept in the context statistics
+    void deregister_counters(communication_counters* c)
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        c->read(m_retired_stats);
+        c->read(m_retired_latency);
+        m_counters.erase(c);
+    }
+
+    communication_stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        communication_stats         s = m_retired_stats;
+        for (auto c : m_counters) c->read(s);
+        return s;
+    }
+
+    std::vector<peer_latency> latency() const
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        std::vector<peer_latency>   l = m_retired_latency;
+        for (auto c : m_counters) c->read(l);
+        l.resize(size());
+        return l;
+    }
+
+    // thread pool shared by all communicators for running callbacks, see callback_execution
+    thread_pool& callback_pool()
+    {
+        std::call_once(m_callback_pool_flag,
+            [this]() {
+                m_callback_pool = std::make_unique<thread_pool>(m_tuning.m_callback_threads);
+            });
+        return *m_callback_pool;
+    }
 };
 
 } // namespace oomph
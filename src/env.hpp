@@ -0,0 +1,48 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <cstdlib>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace oomph
+{
+// read a size from the environment, accepting an optional K, M or G suffix (powers of 1024)
+inline std::size_t
+env_size(char const* name, std::size_t default_value)
+{
+    char const* str = std::getenv(name);
+    if (!str || !*str) return default_value;
+    char*       end;
+    std::size_t value = std::strtoull(str, &end, 10);
+    bool        valid = (end != str);
+    switch (*end)
+    {
+    case 'g':
+    case 'G': value <<= 10; [[fallthrough]];
+    case 'm':
+    case 'M': value <<= 10; [[fallthrough]];
+    case 'k':
+    case 'K':
+        value <<= 10;
+        ++end;
+        break;
+    default: break;
+    }
+    if (!valid || *end)
+        throw std::runtime_error(
+            std::string("oomph: invalid value for environment variable ") + name + ": " + str);
+    return value;
+}
+
+} // namespace oomph
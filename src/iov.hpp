@@ -0,0 +1,30 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace oomph
+{
+// backend view of an iov_element: heap pointer of the message buffer and a byte range within it
+template<typename Pointer>
+struct iov_piece
+{
+    Pointer*    m_ptr;
+    std::size_t m_offset;
+    std::size_t m_size;
+};
+
+template<typename Pointer>
+using iov_vector = std::vector<iov_piece<Pointer>>;
+
+} // namespace oomph
@@ -0,0 +1,261 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/memory.hpp>
+#include <oomph/detail/request_state.hpp>
+#include <hwmalloc/config.hpp>
+#if HWMALLOC_ENABLE_DEVICE
+#include <hwmalloc/device.hpp>
+#endif
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace oomph
+{
+// memory allocated by a pool created with detail::request_pool_start_size
+inline std::size_t
+pool_bytes(boost::pool<> const& p) noexcept
+{
+    return (p.get_next_size() - detail::request_pool_start_size) * p.get_requested_size();
+}
+
+// amount with high-water mark, updated concurrently
+class memory_counter
+{
+  private:
+    std::atomic<std::uint64_t> m_current{0};
+    std::atomic<std::uint64_t> m_peak{0};
+
+  public:
+    void add(std::uint64_t n) noexcept
+    {
+        auto const c = m_current.fetch_add(n, std::memory_order_relaxed) + n;
+        auto       p = m_peak.load(std::memory_order_relaxed);
+        while (c > p && !m_peak.compare_exchange_weak(p, c, std::memory_order_relaxed)) {}
+    }
+
+    void sub(std::uint64_t n) noexcept { m_current.fetch_sub(n, std::memory_order_relaxed); }
+
+    high_water read() const noexcept
+    {
+        return {m_current.load(std::memory_order_relaxed), m_peak.load(std::memory_order_relaxed)};
+    }
+};
+
+// Amount charged to a counter, and to the total unless it is a count, for as long as the charge
+// lives. Held by the objects owning the memory and moved along with them.
+class memory_charge
+{
+  private:
+    memory_counter* m_counter = nullptr;
+    memory_counter* m_total = nullptr;
+    std::uint64_t   m_amount = 0;
+
+  public:
+    memory_charge() noexcept = default;
+
+    memory_charge(memory_counter& counter, memory_counter* total, std::uint64_t n = 0) noexcept
+    : m_counter{&counter}
+    , m_total{total}
+    {
+        resize(n);
+    }
+
+    memory_charge(memory_charge&& other) noexcept
+    : m_counter{std::exchange(other.m_counter, nullptr)}
+    , m_total{std::exchange(other.m_total, nullptr)}
+    , m_amount{std::exchange(other.m_amount, 0)}
+    {
+    }
+
+    memory_charge& operator=(memory_charge&& other) noexcept
+    {
+        resize(0);
+        m_counter = std::exchange(other.m_counter, nullptr);
+        m_total = std::exchange(other.m_total, nullptr);
+        m_amount = std::exchange(other.m_amount, 0);
+        return *this;
+    }
+
+    ~memory_charge() { resize(0); }
+
+    std::uint64_t amount() const noexcept { return m_amount; }
+
+    void resize(std::uint64_t n) noexcept
+    {
+        if (!m_counter || n == m_amount) return;
+        if (n > m_amount)
+        {
+            m_counter->add(n - m_amount);
+            if (m_total) m_total->add(n - m_amount);
+        }
+        else
+        {
+            m_counter->sub(m_amount - n);
+            if (m_total) m_total->sub(m_amount - n);
+        }
+        m_amount = n;
+    }
+};
+
+// Allocator charging what it allocates to a counter and the total, such that the memory of a
+// container is accounted for when it reallocates only. Default constructed, it charges nothing.
+template<typename T>
+class charged_allocator
+{
+  public:
+    using value_type = T;
+
+    memory_counter* m_counter = nullptr;
+    memory_counter* m_total = nullptr;
+
+  public:
+    charged_allocator() noexcept = default;
+
+    charged_allocator(memory_counter& counter, memory_counter* total) noexcept
+    : m_counter{&counter}
+    , m_total{total}
+    {
+    }
+
+    template<typename U>
+    charged_allocator(charged_allocator<U> const& other) noexcept
+    : m_counter{other.m_counter}
+    , m_total{other.m_total}
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        auto const p = std::allocator<T>{}.allocate(n);
+        if (m_counter)
+        {
+            m_counter->add(n * sizeof(T));
+            if (m_total) m_total->add(n * sizeof(T));
+        }
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (m_counter)
+        {
+            m_counter->sub(n * sizeof(T));
+            if (m_total) m_total->sub(n * sizeof(T));
+        }
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(charged_allocator<U> const& other) const noexcept
+    {
+        return m_counter == other.m_counter;
+    }
+
+    template<typename U>
+    bool operator!=(charged_allocator<U> const& other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+
+template<typename T>
+using charged_vector = std::vector<T, charged_allocator<T>>;
+
+// Memory held by a context and its communicators. Registered memory is attributed to the NUMA node
+// of its first page, or to the current device.
+class memory_accounting
+{
+  public:
+    static constexpr std::size_t max_nodes = 64;   // further nodes are counted as the last one
+    static constexpr std::size_t max_devices = 64; // further devices are counted as the last one
+
+  private:
+    std::array<memory_counter, max_nodes>   m_host;
+    std::array<memory_counter, max_devices> m_device;
+    memory_counter                          m_rma;
+    memory_counter                          m_addresses;
+    memory_counter                          m_request_pools;
+    memory_counter                          m_queues;
+    memory_counter                          m_total;
+    memory_counter                          m_workers;
+    memory_counter                          m_endpoints;
+
+  public:
+    memory_charge charge_host(void const* ptr, std::size_t size) noexcept
+    {
+        return {m_host[std::min(numa_node(ptr), max_nodes - 1)], &m_total, size};
+    }
+
+    memory_charge charge_device(std::size_t size) noexcept
+    {
+        std::size_t id = 0;
+#if HWMALLOC_ENABLE_DEVICE
+        id = std::max(hwmalloc::get_device_id(), 0);
+#endif
+        return {m_device[std::min(id, max_devices - 1)], &m_total, size};
+    }
+
+    memory_charge charge_rma(std::size_t size) noexcept { return {m_rma, &m_total, size}; }
+    memory_charge charge_addresses(std::size_t size) noexcept
+    {
+        return {m_addresses, &m_total, size};
+    }
+    memory_charge charge_request_pool() noexcept { return {m_request_pools, &m_total}; }
+    memory_charge charge_queues() noexcept { return {m_queues, &m_total}; }
+    charged_allocator<char> queue_allocator() noexcept { return {m_queues, &m_total}; }
+    memory_charge charge_workers(std::size_t n) noexcept { return {m_workers, nullptr, n}; }
+    memory_charge charge_endpoints() noexcept { return {m_endpoints, nullptr}; }
+
+    memory_stats read() const
+    {
+        memory_stats s;
+        s.registered_host = read(m_host);
+        s.registered_device = read(m_device);
+        s.rma = m_rma.read();
+        s.addresses = m_addresses.read();
+        s.request_pools = m_request_pools.read();
+        s.queues = m_queues.read();
+        s.total = m_total.read();
+        s.workers = m_workers.read();
+        s.endpoints = m_endpoints.read();
+        return s;
+    }
+
+  private:
+    // nodes or devices up to the last one which was ever charged
+    template<std::size_t N>
+    static std::vector<high_water> read(std::array<memory_counter, N> const& counters)
+    {
+        std::vector<high_water> v;
+        for (auto const& c : counters) v.push_back(c.read());
+        while (!v.empty() && v.back().peak == 0) v.pop_back();
+        return v;
+    }
+
+    static std::size_t numa_node(void const* ptr) noexcept
+    {
+        // get_mempolicy(MPOL_F_NODE | MPOL_F_ADDR) returns the node of the page at ptr
+        int node = 0;
+        if (syscall(SYS_get_mempolicy, &node, nullptr, 0, ptr, 3) != 0 || node < 0) return 0;
+        return node;
+    }
+};
+
+} // namespace oomph
@@ -12,6 +12,8 @@
 
 #include <oomph/communicator.hpp>
 #include "./request.hpp"
+#include "../stats_counters.hpp"
+#include "../memory_accounting.hpp"
 #include <vector>
 #include <algorithm>
 
@@ -23,17 +25,22 @@ class callback_queue
     using cb_type = util::unique_function<void()>;
     using handle_type = detail::request_state;
     using handle_ptr = communicator::shared_request_ptr;
+    using time_point = latency_recorder::clock_type::time_point;
 
     struct element_type
     {
         mpi_request m_request;
         cb_type     m_cb;
         handle_ptr  m_handle;
+        int         m_peer;
+        time_point  m_post;
 
-        element_type(mpi_request req, cb_type&& cb, handle_ptr&& h)
+        element_type(mpi_request req, cb_type&& cb, handle_ptr&& h, int peer, time_point post)
         : m_request{req}
         , m_cb{std::move(cb)}
         , m_handle{std::move(h)}
+        , m_peer{peer}
+        , m_post{post}
         {
         }
         element_type(element_type const&) = delete;
@@ -42,32 +49,44 @@ class callback_queue
         element_type& operator=(element_type&& other) = default;
     };
 
-    using queue_type = std::vector<element_type>;
+    using queue_type = charged_vector<element_type>;
 
   private: // members
-    queue_type               m_queue;
-    queue_type               m_ready_queue;
-    bool                     in_progress = false;
-    std::vector<MPI_Request> reqs;
-    std::vector<int>         indices;
+    queue_type                  m_queue;
+    queue_type                  m_ready_queue;
+    bool                        in_progress = false;
+    charged_vector<MPI_Request> reqs;
+    charged_vector<int>         indices;
+    charged_vector<MPI_Status>  statuses;
 
   public: // ctors
-    callback_queue()
+    // the capacity of the queue is charged through the allocator a
+    callback_queue(charged_allocator<char> a = {})
+    : m_queue(a)
+    , m_ready_queue(a)
+    , reqs(a)
+    , indices(a)
+    , statuses(a)
     {
         m_queue.reserve(256);
         m_ready_queue.reserve(256);
     }
 
   public: // member functions
-    void enqueue(mpi_request const& req, cb_type&& cb, handle_ptr&& h)
+    void enqueue(mpi_request const& req, cb_type&& cb, handle_ptr&& h, int peer, time_point post)
     {
-        m_queue.push_back(element_type{req, std::move(cb), std::move(h)});
-        m_queue.back().m_handle->m_index = m_queue.size() - 1;
+        // operations without request (e.g. shared requests) pass an empty handle
+        if (h) h->m_index = m_queue.size();
+        m_queue.push_back(element_type{req, std::move(cb), std::move(h), peer, post});
     }
 
     auto size() const noexcept { return m_queue.size(); }
 
-    int progress()
+    // completions are reported with the peer and post time of the operation, then the
+    // completion handlers are run through invoke, together with the status of the operation if
+    // with_status is set (null otherwise)
+    template<typename OnCompletion, typename Invoke>
+    int progress(OnCompletion&& on_completion, Invoke&& invoke, bool with_status = false)
     {
         if (in_progress) return 0;
         in_progress = true;
@@ -85,13 +104,15 @@ class callback_queue
         reqs.resize(0);
         reqs.reserve(qs);
         indices.resize(qs + 1);
+        if (with_status) statuses.resize(qs);
 
         std::transform(m_queue.begin(), m_queue.end(), std::back_inserter(reqs),
             [](auto& e) { return e.m_request.m_req; });
 
         int outcount;
         OOMPH_CHECK_MPI_RESULT(
-            MPI_Testsome(qs, reqs.data(), &outcount, indices.data(), MPI_STATUSES_IGNORE));
+            MPI_Testsome(qs, reqs.data(), &outcount, indices.data(),
+                with_status ? statuses.data() : MPI_STATUSES_IGNORE));
 
         if (outcount == 0)
         {
@@ -108,12 +129,13 @@ class callback_queue
             auto& e = m_queue[i];
             if ((int)i == indices[k])
             {
+                on_completion(e.m_peer, e.m_post);
                 m_ready_queue.push_back(std::move(e));
                 ++k;
             }
             else if (i > j)
             {
-                e.m_handle->m_index = j;
+                if (e.m_handle) e.m_handle->m_index = j;
                 m_queue[j] = std::move(e);
                 ++j;
             }
@@ -126,7 +148,8 @@ class callback_queue
         m_queue.erase(m_queue.end() - m_ready_queue.size(), m_queue.end());
 
         int completed = m_ready_queue.size();
-        for (auto& e : m_ready_queue) e.m_cb();
+        for (int i = 0; i < completed; ++i)
+            invoke(m_ready_queue[i].m_cb, with_status ? &statuses[i] : nullptr);
 
         in_progress = false;
         return completed;
@@ -139,7 +162,7 @@ class callback_queue
             if (index + 1 < m_queue.size())
             {
                 m_queue[index] = std::move(m_queue.back());
-                m_queue[index].m_handle->m_index = index;
+                if (m_queue[index].m_handle) m_queue[index].m_handle->m_index = index;
             }
             m_queue.pop_back();
             return true;
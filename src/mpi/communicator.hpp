@@ -14,9 +14,14 @@
 #include <oomph/communicator.hpp>
 #include "./request.hpp"
 #include "./callback_queue.hpp"
+#include "./request_queue.hpp"
+#include "./datatype_cache.hpp"
 #include "./context.hpp"
 #include "../communicator_base.hpp"
 #include "../device_guard.hpp"
+#include "../iov.hpp"
+#include <algorithm>
+#include <limits>
 
 namespace oomph
 {
@@ -26,62 +31,213 @@ class communicator_impl : public communicator_base<communicator_impl>
     using tag_type = communicator::tag_type;
 
   public:
-    context_impl*  m_context;
-    callback_queue m_send_callbacks;
-    callback_queue m_recv_callbacks;
+    using iov_type = iov_vector<context_impl::heap_type::pointer>;
+
+  public:
+    context_impl*              m_context;
+    request_queue              m_send_requests;
+    request_queue              m_recv_requests;
+    callback_queue             m_send_callbacks;
+    callback_queue             m_recv_callbacks;
+    datatype_cache             m_datatypes;
+    datatype_cache::shape_type m_iov_shape;
 
     communicator_impl(context_impl* ctxt)
     : communicator_base(ctxt)
     , m_context(ctxt)
+    , m_send_requests(ctxt->get_memory().queue_allocator())
+    , m_recv_requests(ctxt->get_memory().queue_allocator())
+    , m_send_callbacks(ctxt->get_memory().queue_allocator())
+    , m_recv_callbacks(ctxt->get_memory().queue_allocator())
     {
     }
 
     auto& get_heap() noexcept { return m_context->get_heap(); }
+    auto& get_registration_cache() noexcept { return m_context->get_registration_cache(); }
 
-    mpi_request send(
-        context_impl::heap_type::pointer const& ptr, std::size_t size, rank_type dst, tag_type tag)
+    mpi_request send(context_impl::heap_type::pointer const& ptr, std::size_t offset,
+        std::size_t size, rank_type dst, tag_type tag)
     {
         MPI_Request        r;
         const_device_guard dg(ptr);
-        OOMPH_CHECK_MPI_RESULT(MPI_Isend(dg.data(), size, MPI_BYTE, dst, tag, mpi_comm(), &r));
+        OOMPH_CHECK_MPI_RESULT(MPI_Isend(static_cast<char const*>(dg.data()) + offset, size,
+            MPI_BYTE, dst, tag, mpi_comm(), &r));
         return {r};
     }
 
-    mpi_request recv(
-        context_impl::heap_type::pointer& ptr, std::size_t size, rank_type src, tag_type tag)
+    mpi_request recv(context_impl::heap_type::pointer& ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag)
     {
         MPI_Request  r;
         device_guard dg(ptr);
-        OOMPH_CHECK_MPI_RESULT(MPI_Irecv(dg.data(), size, MPI_BYTE, src, tag, mpi_comm(), &r));
+        OOMPH_CHECK_MPI_RESULT(MPI_Irecv(static_cast<char*>(dg.data()) + offset, size, MPI_BYTE,
+            src, tag, mpi_comm(), &r));
         return {r};
     }
 
-    void send(context_impl::heap_type::pointer const& ptr, std::size_t size, rank_type dst,
-        tag_type tag, util::unique_function<void()>&& cb, communicator::shared_request_ptr&& h)
+    void send(context_impl::heap_type::pointer const& ptr, std::size_t offset, std::size_t size,
+        rank_type dst, tag_type tag, util::unique_function<void()>&& cb,
+        communicator::shared_request_ptr&& h)
     {
-        auto req = send(ptr, size, dst, tag);
-        if (req.is_ready()) cb();
+        auto const post = post_time();
+        auto       req = send(ptr, offset, size, dst, tag);
+        if (req.is_ready())
+        {
+            on_send_completion(dst, post);
+            run_completion_handler(cb);
+        }
         else
-            m_send_callbacks.enqueue(req, std::move(cb), std::move(h));
+            m_send_callbacks.enqueue(req, std::move(cb), std::move(h), dst, post);
     }
 
-    void recv(context_impl::heap_type::pointer& ptr, std::size_t size, rank_type src, tag_type tag,
+    void recv(context_impl::heap_type::pointer& ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag, util::unique_function<void()>&& cb,
+        communicator::shared_request_ptr&& h)
+    {
+        auto const post = post_time();
+        auto       req = recv(ptr, offset, size, src, tag);
+        MPI_Status status;
+        if (req.is_ready(&status))
+        {
+            on_recv_completion(src, post);
+            run_recv_handler(cb, &status);
+        }
+        else
+            m_recv_callbacks.enqueue(req, std::move(cb), std::move(h), src, post);
+    }
+
+    void send(context_impl::heap_type::pointer const& ptr, std::size_t offset, std::size_t size,
+        rank_type dst, tag_type tag, std::size_t* scheduled, communicator::shared_request_ptr&& h)
+    {
+        auto const post = post_time();
+        auto       req = send(ptr, offset, size, dst, tag);
+        if (req.is_ready())
+        {
+            on_send_completion(dst, post);
+            request_queue::complete(scheduled, h.get());
+        }
+        else
+            m_send_requests.enqueue(req, scheduled, std::move(h), dst, post);
+    }
+
+    void recv(context_impl::heap_type::pointer& ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag, std::size_t* scheduled, communicator::shared_request_ptr&& h)
+    {
+        auto const post = post_time();
+        auto       req = recv(ptr, offset, size, src, tag);
+        if (req.is_ready())
+        {
+            on_recv_completion(src, post);
+            request_queue::complete(scheduled, h.get());
+        }
+        else
+            m_recv_requests.enqueue(req, scheduled, std::move(h), src, post);
+    }
+
+    // returns the address of the first piece and a datatype describing all pieces relative to it
+    std::pair<void*, MPI_Datatype> iov_datatype(iov_type const& iov)
+    {
+        m_iov_shape.clear();
+        void*    base = nullptr;
+        MPI_Aint base_addr = 0;
+        for (auto const& p : iov)
+        {
+            device_guard dg(*p.m_ptr);
+            auto const   ptr = static_cast<char*>(dg.data()) + p.m_offset;
+            MPI_Aint     addr;
+            OOMPH_CHECK_MPI_RESULT(MPI_Get_address(ptr, &addr));
+            if (!base)
+            {
+                base = ptr;
+                base_addr = addr;
+            }
+            // block lengths are ints: larger pieces are split
+            auto        disp = MPI_Aint_diff(addr, base_addr);
+            std::size_t size = p.m_size;
+            do
+            {
+                int const n = (int)std::min<std::size_t>(size, std::numeric_limits<int>::max());
+                m_iov_shape.emplace_back(disp, n);
+                disp += n;
+                size -= n;
+            } while (size > 0);
+        }
+        return {base, m_datatypes.get(m_iov_shape)};
+    }
+
+    void send_iov(iov_type const& iov, rank_type dst, tag_type tag,
+        util::unique_function<void()>&& cb, communicator::shared_request_ptr&& h)
+    {
+        auto const  post = post_time();
+        auto const  t = iov_datatype(iov);
+        mpi_request req;
+        OOMPH_CHECK_MPI_RESULT(MPI_Isend(t.first, 1, t.second, dst, tag, mpi_comm(), &req.m_req));
+        if (req.is_ready())
+        {
+            on_send_completion(dst, post);
+            run_completion_handler(cb);
+        }
+        else
+            m_send_callbacks.enqueue(req, std::move(cb), std::move(h), dst, post);
+    }
+
+    void recv_iov(iov_type const& iov, rank_type src, tag_type tag,
         util::unique_function<void()>&& cb, communicator::shared_request_ptr&& h)
     {
-        auto req = recv(ptr, size, src, tag);
-        if (req.is_ready()) cb();
+        auto const  post = post_time();
+        auto const  t = iov_datatype(iov);
+        mpi_request req;
+        OOMPH_CHECK_MPI_RESULT(MPI_Irecv(t.first, 1, t.second, src, tag, mpi_comm(), &req.m_req));
+        if (req.is_ready())
+        {
+            on_recv_completion(src, post);
+            run_completion_handler(cb);
+        }
         else
-            m_recv_callbacks.enqueue(req, std::move(cb), std::move(h));
+            m_recv_callbacks.enqueue(req, std::move(cb), std::move(h), src, post);
+    }
+
+    // runs the completion handler of a receive, reporting its source, length and outcome if
+    // needed
+    void run_recv_handler(util::unique_function<void()>& cb, MPI_Status const* status)
+    {
+        if (!status || !report_completions())
+        {
+            run_completion_handler(cb);
+            return;
+        }
+        int cancelled;
+        OOMPH_CHECK_MPI_RESULT(MPI_Test_cancelled(status, &cancelled));
+        int count = 0;
+        if (!cancelled) OOMPH_CHECK_MPI_RESULT(MPI_Get_count(status, MPI_BYTE, &count));
+        detail::transport_completion const t{status->MPI_SOURCE, (std::size_t)count,
+            cancelled ? completion_status::cancelled : completion_status::success};
+        run_completion_handler(cb, &t);
     }
 
     void progress()
     {
-        m_send_callbacks.progress();
-        m_recv_callbacks.progress();
+        [[maybe_unused]] auto const t = trace_progress();
+        [[maybe_unused]] auto const r = record_progress();
+        auto const invoke = [this](callback_queue::cb_type& cb, MPI_Status const*)
+        { run_completion_handler(cb); };
+        auto const invoke_recv = [this](callback_queue::cb_type& cb, MPI_Status const* status)
+        { run_recv_handler(cb, status); };
+        auto const sent = [this](rank_type dst, time_point post) { on_send_completion(dst, post); };
+        auto const received = [this](rank_type src, time_point post)
+        { on_recv_completion(src, post); };
+        std::size_t n = m_send_requests.progress(sent);
+        n += m_recv_requests.progress(received);
+        n += m_send_callbacks.progress(sent, invoke);
+        n += m_recv_callbacks.progress(received, invoke_recv, report_completions());
+        n += m_executor.progress();
+        on_progress(n);
     }
 
     bool cancel_recv_cb(recv_request const& req)
     {
+        if (m_recv_requests.contains(req.m_data.get()))
+            return m_recv_requests.cancel(req.m_data->m_index);
         return m_recv_callbacks.cancel(req.m_data->m_index);
     }
 };
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "../context_base.hpp"
+#include "../registration_cache.hpp"
 #include "./rma_context.hpp"
 
 namespace oomph
@@ -20,27 +21,32 @@ class context_impl : public context_base
     using region_type = region;
     using device_region_type = region;
     using heap_type = hwmalloc::heap<context_impl>;
+    using registration_cache_type = registration_cache<heap_type>;
     using rank_type = communicator::rank_type;
     using tag_type = communicator::tag_type;
 
   private:
-    heap_type   m_heap;
-    rma_context m_rma_context;
+    heap_type               m_heap;
+    registration_cache_type m_registration_cache;
+    rma_context             m_rma_context;
 
   public:
     context_impl(MPI_Comm comm, bool thread_safe)
-    : context_base(comm, thread_safe)
-    , m_heap{this}
-    , m_rma_context{m_mpi_comm}
+    : context_base(comm, thread_safe, "mpi")
+    , m_heap{timed_phase("heap", [this]() { return heap_type{this}; })}
+    , m_registration_cache{m_heap}
+    , m_rma_context{
+          timed_phase("rma_window", [this]() { return rma_context(m_mpi_comm, m_memory); })}
     {
     }
 
     context_impl(context_impl const&) = delete;
     context_impl(context_impl&&) = delete;
 
-    region make_region(void* ptr) const { return {ptr}; }
+    region make_region(void* ptr, memory_charge&& charge) { return {ptr, std::move(charge)}; }
 
     auto& get_heap() noexcept { return m_heap; }
+    auto& get_registration_cache() noexcept { return m_registration_cache; }
 
     auto  get_window() const noexcept { return m_rma_context.get_window(); }
     auto& get_rma_heap() noexcept { return m_rma_context.get_heap(); }
@@ -51,17 +57,17 @@ class context_impl : public context_base
 
 template<>
 region
-register_memory<context_impl>(context_impl& c, void* ptr, std::size_t)
+register_memory<context_impl>(context_impl& c, void* ptr, std::size_t size)
 {
-    return c.make_region(ptr);
+    return c.make_region(ptr, c.get_memory().charge_host(ptr, size));
 }
 
 #if HWMALLOC_ENABLE_DEVICE
 template<>
 region
-register_device_memory<context_impl>(context_impl& c, void* ptr, std::size_t)
+register_device_memory<context_impl>(context_impl& c, void* ptr, std::size_t size)
 {
-    return c.make_region(ptr);
+    return c.make_region(ptr, c.get_memory().charge_device(size));
 }
 #endif
 
@@ -0,0 +1,76 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/util/mpi_error.hpp>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace oomph
+{
+// Cache of committed hindexed byte datatypes, keyed by the shape of an iov message: the list of
+// (displacement, length) pairs relative to the first piece. Halo exchanges repeat the same shapes
+// every iteration, hence the type is built and committed only once. When the cache is full it is
+// flushed entirely; freeing a datatype which is still in use by a pending operation is allowed.
+class datatype_cache
+{
+  public:
+    using shape_type = std::vector<std::pair<MPI_Aint, int>>;
+
+    static constexpr std::size_t max_size = 256;
+
+  private:
+    std::map<shape_type, MPI_Datatype> m_types;
+
+  public:
+    datatype_cache() = default;
+    datatype_cache(datatype_cache const&) = delete;
+    datatype_cache& operator=(datatype_cache const&) = delete;
+    ~datatype_cache()
+    {
+        for (auto& kvp : m_types) OOMPH_CHECK_MPI_RESULT_NOEXCEPT(MPI_Type_free(&kvp.second));
+    }
+
+  public:
+    std::size_t size() const noexcept { return m_types.size(); }
+
+    MPI_Datatype get(shape_type const& shape)
+    {
+        auto it = m_types.find(shape);
+        if (it != m_types.end()) return it->second;
+        if (m_types.size() >= max_size) clear();
+
+        std::vector<MPI_Aint> displacements;
+        std::vector<int>      lengths;
+        displacements.reserve(shape.size());
+        lengths.reserve(shape.size());
+        for (auto const& p : shape)
+        {
+            displacements.push_back(p.first);
+            lengths.push_back(p.second);
+        }
+        MPI_Datatype t;
+        OOMPH_CHECK_MPI_RESULT(MPI_Type_create_hindexed(
+            (int)shape.size(), lengths.data(), displacements.data(), MPI_BYTE, &t));
+        OOMPH_CHECK_MPI_RESULT(MPI_Type_commit(&t));
+        m_types.emplace(shape, t);
+        return t;
+    }
+
+    void clear()
+    {
+        for (auto& kvp : m_types) OOMPH_CHECK_MPI_RESULT(MPI_Type_free(&kvp.second));
+        m_types.clear();
+    }
+};
+
+} // namespace oomph
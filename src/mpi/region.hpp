@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include "../memory_accounting.hpp"
 #include "./handle.hpp"
 
 namespace oomph
@@ -19,11 +20,13 @@ class region
     using handle_type = handle;
 
   private:
-    void* m_ptr;
+    void*         m_ptr;
+    memory_charge m_charge;
 
   public:
-    region(void* ptr)
+    region(void* ptr, memory_charge&& charge)
     : m_ptr{ptr}
+    , m_charge{std::move(charge)}
     {
     }
 
@@ -31,6 +34,7 @@ class region
 
     region(region&& r) noexcept
     : m_ptr{std::exchange(r.m_ptr, nullptr)}
+    , m_charge{std::move(r.m_charge)}
     {
     }
 
@@ -47,15 +51,17 @@ class rma_region
     using handle_type = handle;
 
   private:
-    MPI_Comm m_comm;
-    MPI_Win  m_win;
-    void*    m_ptr;
+    MPI_Comm      m_comm;
+    MPI_Win       m_win;
+    void*         m_ptr;
+    memory_charge m_charge;
 
   public:
-    rma_region(MPI_Comm comm, MPI_Win win, void* ptr, std::size_t size)
+    rma_region(MPI_Comm comm, MPI_Win win, void* ptr, std::size_t size, memory_charge&& charge)
     : m_comm{comm}
     , m_win{win}
     , m_ptr{ptr}
+    , m_charge{std::move(charge)}
     {
         OOMPH_CHECK_MPI_RESULT(MPI_Win_attach(m_win, ptr, size));
     }
@@ -66,6 +72,7 @@ class rma_region
     : m_comm{r.m_comm}
     , m_win{r.m_win}
     , m_ptr{std::exchange(r.m_ptr, nullptr)}
+    , m_charge{std::move(r.m_charge)}
     {
     }
 
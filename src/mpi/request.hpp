@@ -18,10 +18,10 @@ struct mpi_request
 {
     MPI_Request m_req;
 
-    bool is_ready()
+    bool is_ready(MPI_Status* status = MPI_STATUS_IGNORE)
     {
         int flag;
-        OOMPH_CHECK_MPI_RESULT(MPI_Test(&m_req, &flag, MPI_STATUS_IGNORE));
+        OOMPH_CHECK_MPI_RESULT(MPI_Test(&m_req, &flag, status));
         return flag;
     }
 
@@ -0,0 +1,134 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/communicator.hpp>
+#include "./request.hpp"
+#include "../stats_counters.hpp"
+#include "../memory_accounting.hpp"
+#include <vector>
+
+namespace oomph
+{
+// Queue of operations without callback. On completion, the ready flag of the request is set (if
+// the operation has a request at all) and the counter of scheduled operations is decremented. The
+// MPI requests are stored contiguously, such that they can be passed to MPI_Testsome as they are.
+// Completions are also reported with the peer and post time of the operation.
+class request_queue
+{
+  public: // member types
+    using handle_ptr = communicator::shared_request_ptr;
+    using time_point = latency_recorder::clock_type::time_point;
+
+    struct element_type
+    {
+        std::size_t* m_scheduled;
+        handle_ptr   m_handle; // empty for detached operations
+        int          m_peer;
+        time_point   m_post;
+    };
+
+  private: // members
+    charged_vector<MPI_Request>  m_reqs;
+    charged_vector<element_type> m_elements;
+    charged_vector<int>          m_indices;
+
+  public: // ctors
+    // the capacity of the queue is charged through the allocator a
+    request_queue(charged_allocator<char> a = {})
+    : m_reqs(a)
+    , m_elements(a)
+    , m_indices(a)
+    {
+        m_reqs.reserve(256);
+        m_elements.reserve(256);
+        m_indices.reserve(256);
+    }
+
+  public: // member functions
+    static void complete(std::size_t* scheduled, detail::request_state* h) noexcept
+    {
+        if (h) h->set_ready();
+        --(*scheduled);
+    }
+
+    void enqueue(mpi_request const& req, std::size_t* scheduled, handle_ptr&& h, int peer,
+        time_point post)
+    {
+        if (h) h->m_index = m_reqs.size();
+        m_reqs.push_back(req.m_req);
+        m_elements.push_back(element_type{scheduled, std::move(h), peer, post});
+    }
+
+    auto size() const noexcept { return m_reqs.size(); }
+
+    // true if the request h is in the queue
+    bool contains(detail::request_state const* h) const noexcept
+    {
+        return h->m_index < size() && m_elements[h->m_index].m_handle.get() == h;
+    }
+
+    template<typename OnCompletion>
+    int progress(OnCompletion&& on_completion)
+    {
+        const auto qs = size();
+        if (qs == 0) return 0;
+
+        m_indices.resize(qs);
+        int outcount;
+        OOMPH_CHECK_MPI_RESULT(
+            MPI_Testsome(qs, m_reqs.data(), &outcount, m_indices.data(), MPI_STATUSES_IGNORE));
+        if (outcount == 0 || outcount == MPI_UNDEFINED) return 0;
+
+        for (int k = 0; k < outcount; ++k)
+        {
+            auto const& e = m_elements[m_indices[k]];
+            on_completion(e.m_peer, e.m_post);
+            complete(e.m_scheduled, e.m_handle.get());
+        }
+
+        // completed requests have been set to MPI_REQUEST_NULL: compact the queue
+        std::size_t j = 0;
+        for (std::size_t i = 0; i < qs; ++i)
+        {
+            if (m_reqs[i] == MPI_REQUEST_NULL) continue;
+            if (i > j)
+            {
+                m_reqs[j] = m_reqs[i];
+                m_elements[j] = std::move(m_elements[i]);
+                if (m_elements[j].m_handle) m_elements[j].m_handle->m_index = j;
+            }
+            ++j;
+        }
+        m_reqs.resize(j);
+        m_elements.erase(m_elements.begin() + j, m_elements.end());
+        return outcount;
+    }
+
+    // returns true if the operation was cancelled, otherwise it is completed
+    bool cancel(std::size_t index)
+    {
+        mpi_request r{m_reqs[index]};
+        bool const  cancelled = r.cancel();
+        if (!cancelled) complete(m_elements[index].m_scheduled, m_elements[index].m_handle.get());
+        if (index + 1 < size())
+        {
+            m_reqs[index] = m_reqs.back();
+            m_elements[index] = std::move(m_elements.back());
+            if (m_elements[index].m_handle) m_elements[index].m_handle->m_index = index;
+        }
+        m_reqs.pop_back();
+        m_elements.pop_back();
+        return cancelled;
+    }
+};
+
+} // namespace oomph
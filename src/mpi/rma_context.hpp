@@ -34,13 +34,15 @@ class rma_context
 
   private:
     MPI_Comm                    m_mpi_comm;
+    memory_accounting*          m_memory;
     mpi_win_holder              m_win;
     heap_type                   m_heap;
     std::unique_ptr<lock_cache> m_lock_cache;
 
   public:
-    rma_context(MPI_Comm comm)
+    rma_context(MPI_Comm comm, memory_accounting& memory)
     : m_mpi_comm{comm}
+    , m_memory{&memory}
     , m_heap{this}
     {
         MPI_Info info;
@@ -56,7 +58,7 @@ class rma_context
 
     rma_region make_region(void* ptr, std::size_t size) const
     {
-        return {m_mpi_comm, m_win.m, ptr, size};
+        return {m_mpi_comm, m_win.m, ptr, size, m_memory->charge_rma(size)};
     }
 
     auto  get_window() const noexcept { return m_win.m; }
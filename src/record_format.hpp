@@ -0,0 +1,72 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of recordings: a file header, followed by the records of the recorded
+// communicators in chunks, each preceded by a chunk header naming its stream, in the order they
+// were written, and finally one stream header per communicator, at the offset given by the file
+// header. Shared by the recorder and bench_replay.
+
+namespace oomph
+{
+enum class record_kind : std::uint8_t
+{
+    send,    // send posted
+    recv,    // receive posted
+    complete // completion of a posted operation observed by the communicator
+};
+
+struct record_entry
+{
+    std::uint64_t m_gap_ns; // time since the previous record, outside of progress
+    std::uint64_t m_bytes;  // message size for posts
+    std::int32_t  m_peer;   // peer rank for posts, -1 for receives from any rank
+    std::int32_t  m_tag;    // tag for posts
+    std::uint32_t m_op;     // operation index in the stream, starting at 1
+    record_kind   m_kind;
+    std::uint8_t  m_reserved[3];
+};
+static_assert(sizeof(record_entry) == 32, "unexpected record size");
+
+struct record_chunk_header
+{
+    std::uint32_t m_stream; // index of the communicator, in order of creation
+    std::uint32_t m_num_records;
+    std::uint64_t m_reserved;
+};
+static_assert(sizeof(record_chunk_header) == 16, "unexpected chunk header size");
+
+struct record_stream_header
+{
+    std::uint64_t m_num_records;
+    std::uint64_t m_num_ops;
+    std::uint64_t m_elapsed_ns; // from creation of the communicator to its last record
+    std::uint64_t m_reserved;
+};
+static_assert(sizeof(record_stream_header) == 32, "unexpected stream header size");
+
+struct record_file_header
+{
+    static constexpr char          magic[8] = {'O', 'O', 'M', 'P', 'H', 'R', 'E', 'C'};
+    static constexpr std::uint32_t current_version = 2;
+
+    char          m_magic[8];
+    std::uint32_t m_version;
+    std::int32_t  m_rank;
+    std::int32_t  m_size;        // number of ranks
+    std::uint32_t m_num_streams;    // one per communicator, in order of creation
+    std::uint64_t m_streams_offset; // of the stream headers, after all chunks
+};
+static_assert(sizeof(record_file_header) == 32, "unexpected record file header size");
+
+} // namespace oomph
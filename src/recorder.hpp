@@ -0,0 +1,212 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include "./record_format.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace oomph
+{
+// Output file of a recording, to which the streams of all communicators append chunks of records
+// as they fill up. The file header is completed when the file is closed.
+class record_file
+{
+  private:
+    std::ofstream      m_os;
+    record_file_header m_header;
+    std::mutex         m_mutex;
+
+  public:
+    record_file(std::string const& path, int rank, int size)
+    : m_os(path, std::ios::binary)
+    {
+        std::memcpy(m_header.m_magic, record_file_header::magic, sizeof(m_header.m_magic));
+        m_header.m_version = record_file_header::current_version;
+        m_header.m_rank = rank;
+        m_header.m_size = size;
+        m_header.m_num_streams = 0;
+        m_header.m_streams_offset = 0;
+        m_os.write(reinterpret_cast<char const*>(&m_header), sizeof(m_header));
+    }
+
+    record_file(record_file const&) = delete;
+    record_file& operator=(record_file const&) = delete;
+
+    // may be called by any thread
+    void write_chunk(std::uint32_t stream, std::vector<record_entry> const& records)
+    {
+        record_chunk_header const   h{stream, static_cast<std::uint32_t>(records.size()), 0};
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_os.write(reinterpret_cast<char const*>(&h), sizeof(h));
+        m_os.write(reinterpret_cast<char const*>(records.data()),
+            records.size() * sizeof(record_entry));
+    }
+
+    // appends the stream headers and completes the file header, returns false on failure
+    bool close(std::vector<record_stream_header> const& streams)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_header.m_num_streams = streams.size();
+        m_header.m_streams_offset = m_os.tellp();
+        m_os.write(reinterpret_cast<char const*>(streams.data()),
+            streams.size() * sizeof(record_stream_header));
+        m_os.seekp(0);
+        m_os.write(reinterpret_cast<char const*>(&m_header), sizeof(m_header));
+        m_os.close();
+        return !m_os.fail();
+    }
+};
+
+// Operations of one communicator in the order observed by its owning thread, written to the file
+// in chunks of chunk_size records. Gaps exclude the time spent in progress, such that they
+// approximate the computation of the application between two records. Only the thread owning the
+// communicator may use it.
+class record_stream
+{
+  public:
+    static constexpr std::size_t chunk_size = 4096; // 128 KB
+
+  private:
+    record_file&              m_file;
+    std::uint32_t const       m_index;
+    std::vector<record_entry> m_records; // not written yet
+    std::uint64_t             m_num_records = 0;
+    std::uint32_t             m_num_ops = 0;
+    std::uint64_t const       m_start = now();
+    std::uint64_t             m_last = m_start;
+    std::uint64_t             m_in_progress = 0; // time spent in progress since the last record
+    std::uint64_t             m_progress_begin = 0; // non-zero while progressing
+
+  public:
+    record_stream(record_file& file, std::uint32_t index)
+    : m_file{file}
+    , m_index{index}
+    {
+        m_records.reserve(chunk_size);
+    }
+
+    static std::uint64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // returns the index of the operation, to be passed to complete
+    std::uint32_t post(record_kind k, int peer, int tag, std::size_t size)
+    {
+        auto const op = ++m_num_ops;
+        push(k, op, peer, tag, size);
+        return op;
+    }
+
+    void complete(std::uint32_t op) { push(record_kind::complete, op, 0, 0, 0); }
+
+    void begin_progress() noexcept { m_progress_begin = now(); }
+
+    void end_progress() noexcept
+    {
+        m_in_progress += now() - m_progress_begin;
+        m_progress_begin = 0;
+    }
+
+    // writes the remaining records
+    void flush()
+    {
+        if (m_records.empty()) return;
+        m_file.write_chunk(m_index, m_records);
+        m_records.clear();
+    }
+
+    record_stream_header header() const noexcept
+    {
+        return {m_num_records, m_num_ops, m_last - m_start, 0};
+    }
+
+  private:
+    void push(record_kind k, std::uint32_t op, int peer, int tag, std::size_t size)
+    {
+        auto const t = now();
+        auto       busy = m_in_progress;
+        if (m_progress_begin)
+        {
+            busy += t - m_progress_begin;
+            m_progress_begin = t;
+        }
+        auto const elapsed = t - m_last;
+        record_entry r{elapsed > busy ? elapsed - busy : 0, size, peer, tag, op, k, {}};
+        m_records.push_back(r);
+        ++m_num_records;
+        m_last = t;
+        m_in_progress = 0;
+        if (m_records.size() == chunk_size) flush();
+    }
+};
+
+// Recording of the operations of all communicators of a context, enabled with OOMPH_RECORD set to
+// a file prefix: each rank writes <prefix>.<rank>.rec while recording, and completes it when the
+// context is destroyed. Recordings are replayed with bench_replay.
+class recorder
+{
+  private:
+    std::int32_t const                          m_rank;
+    record_file                                 m_file;
+    std::mutex                                  m_mutex;
+    std::vector<std::unique_ptr<record_stream>> m_streams; // protected by m_mutex
+
+  public:
+    static std::unique_ptr<recorder> from_env(int rank, int size)
+    {
+        char const* prefix = std::getenv("OOMPH_RECORD");
+        if (!prefix || !*prefix) return {};
+        return std::make_unique<recorder>(
+            std::string(prefix) + "." + std::to_string(rank) + ".rec", rank, size);
+    }
+
+    recorder(std::string const& path, int rank, int size)
+    : m_rank{rank}
+    , m_file{path, rank, size}
+    {
+    }
+
+    recorder(recorder const&) = delete;
+    recorder& operator=(recorder const&) = delete;
+
+    ~recorder()
+    {
+        std::vector<record_stream_header> headers;
+        for (auto const& s : m_streams)
+        {
+            s->flush();
+            headers.push_back(s->header());
+        }
+        if (!m_file.close(headers))
+            std::cerr << "oomph warning: failed to write recording of rank " << m_rank << std::endl;
+    }
+
+    // streams are kept until the recording is completed
+    record_stream* make_stream()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streams.push_back(std::make_unique<record_stream>(m_file, m_streams.size()));
+        return m_streams.back().get();
+    }
+};
+
+} // namespace oomph
@@ -0,0 +1,285 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include "./env.hpp"
+#include <boost/lockfree/queue.hpp>
+#include <boost/intrusive/list.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace oomph
+{
+// Cache of user memory registrations, indexed by address range.
+//
+// Wrapping the same application array repeatedly (context::make_buffer(ptr, size)) returns a view
+// onto the registration made the first time: any range contained in a cached registration is a
+// hit. Registrations which are not referenced by a message buffer are kept in LRU order and
+// deregistered once the registered memory exceeds the capacity, which is read from
+// OOMPH_REGISTRATION_CACHE_SIZE (bytes, K/M/G suffixes allowed). The cache is disabled by default:
+// registrations outlive the message buffers, which is only safe if freed memory is invalidated.
+//
+// A miss overlapping unused registrations replaces them by one registration of the union. If an
+// overlapping registration is still in use, or the range exceeds the capacity, the memory is
+// registered without caching, as without the cache.
+//
+// Registrations must be invalidated when the memory is unmapped. invalidate() does so immediately,
+// while defer_invalidate() may be called from memory event hooks: it neither locks nor allocates
+// and the ranges are processed at the next access to the cache.
+template<typename Heap>
+class registration_cache
+{
+  public:
+    using pointer = typename Heap::pointer;
+
+
+    struct entry : public boost::intrusive::list_base_hook<>
+    {
+        registration_cache* m_cache;
+        std::uintptr_t      m_begin;
+        std::uintptr_t      m_end;
+        pointer             m_ptr;
+        std::size_t         m_use_count = 0;
+        bool                m_valid = true;
+
+        entry(registration_cache* cache, std::uintptr_t b, std::uintptr_t e, pointer ptr)
+        : m_cache{cache}
+        , m_begin{b}
+        , m_end{e}
+        , m_ptr{ptr}
+        {
+        }
+
+        void release() { m_cache->release(this); }
+    };
+
+    // registration of a range: m_entry is null if the registration is not cached
+    struct handle
+    {
+        pointer     m_ptr;
+        std::size_t m_offset;
+        entry*      m_entry;
+    };
+
+    struct statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t invalidations = 0;
+    };
+
+  private:
+    struct range
+    {
+        std::uintptr_t m_begin;
+        std::uintptr_t m_end;
+    };
+
+    using range_queue = boost::lockfree::queue<range, boost::lockfree::capacity<1024>>;
+    using lru_list = boost::intrusive::list<entry>;
+
+  private:
+    Heap&                            m_heap;
+    std::size_t                      m_capacity;
+    std::size_t                      m_size = 0; // registered bytes held by the cache
+    std::map<std::uintptr_t, entry*> m_entries;  // valid entries keyed by begin address
+    lru_list                         m_lru;      // unused entries, least recently used first
+    std::mutex                       m_mutex;
+    statistics                       m_stats;
+    // deferred invalidations
+    range_queue                 m_pending;
+    std::atomic<bool>           m_has_pending{false};
+    std::atomic<bool>           m_pending_overflow{false};
+    std::atomic<std::uintptr_t> m_lo{UINTPTR_MAX}; // bounds of all cached ranges
+    std::atomic<std::uintptr_t> m_hi{0};
+
+  public:
+    registration_cache(Heap& heap)
+    : m_heap{heap}
+    , m_capacity{env_size("OOMPH_REGISTRATION_CACHE_SIZE", 0)}
+    {
+    }
+
+    registration_cache(registration_cache const&) = delete;
+    registration_cache& operator=(registration_cache const&) = delete;
+
+    ~registration_cache()
+    {
+        m_lru.clear();
+        for (auto& kvp : m_entries) destroy(kvp.second);
+    }
+
+  public:
+    bool        enabled() const noexcept { return m_capacity > 0; }
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    // before first use, e.g. if unmapped memory cannot be detected
+    void disable() noexcept { m_capacity = 0; }
+
+    statistics stats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    handle get(void* ptr, std::size_t size)
+    {
+        if (!enabled() || size > m_capacity)
+            return {m_heap.register_user_allocation(ptr, size), 0, nullptr};
+
+        auto const                  b = reinterpret_cast<std::uintptr_t>(ptr);
+        auto const                  e = b + size;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        process_pending();
+
+        // hit: the last entry starting at or before b covers [b, e)
+        auto it = m_entries.upper_bound(b);
+        if (it != m_entries.begin())
+        {
+            auto x = std::prev(it)->second;
+            if (x->m_end >= e)
+            {
+                ++m_stats.hits;
+                acquire(x);
+                return {x->m_ptr, b - x->m_begin, x};
+            }
+        }
+        ++m_stats.misses;
+
+        // miss: merge with all overlapping entries if none of them is in use
+        auto first = it;
+        if (first != m_entries.begin() && std::prev(first)->second->m_end > b) --first;
+        auto last = first;
+        auto new_b = b;
+        auto new_e = e;
+        for (; last != m_entries.end() && last->first < e; ++last)
+        {
+            auto x = last->second;
+            if (x->m_use_count > 0) return {m_heap.register_user_allocation(ptr, size), 0, nullptr};
+            new_b = std::min(new_b, x->m_begin);
+            new_e = std::max(new_e, x->m_end);
+        }
+        if (new_e - new_b > m_capacity)
+            return {m_heap.register_user_allocation(ptr, size), 0, nullptr};
+        for (auto i = first; i != last; ++i)
+        {
+            m_lru.erase(m_lru.iterator_to(*i->second));
+            m_size -= i->second->m_end - i->second->m_begin;
+            destroy(i->second);
+        }
+        m_entries.erase(first, last);
+
+        auto x = new entry{this, new_b, new_e,
+            m_heap.register_user_allocation(reinterpret_cast<void*>(new_b), new_e - new_b)};
+        m_entries.emplace(new_b, x);
+        m_size += new_e - new_b;
+        m_lo = std::min(m_lo.load(), new_b);
+        m_hi = std::max(m_hi.load(), new_e);
+        x->m_use_count = 1;
+        evict();
+        return {x->m_ptr, b - new_b, x};
+    }
+
+    void release(entry* x)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--x->m_use_count > 0) return;
+        if (!x->m_valid) return destroy(x);
+        m_lru.push_back(*x);
+        evict();
+    }
+
+    // drop all registrations overlapping [ptr, ptr+size)
+    void invalidate(void const* ptr, std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        process_pending();
+        auto const b = reinterpret_cast<std::uintptr_t>(ptr);
+        invalidate_range(b, b + size);
+    }
+
+    // record [ptr, ptr+size) for invalidation: lock and allocation free
+    void defer_invalidate(void const* ptr, std::size_t size) noexcept
+    {
+        auto const b = reinterpret_cast<std::uintptr_t>(ptr);
+        auto const e = b + size;
+        // quick rejection of unrelated ranges
+        if (e <= m_lo.load(std::memory_order_relaxed) || b >= m_hi.load(std::memory_order_relaxed))
+            return;
+        if (!m_pending.bounded_push(range{b, e})) m_pending_overflow = true;
+        m_has_pending.store(true, std::memory_order_release);
+    }
+
+  private:
+    void acquire(entry* x)
+    {
+        if (x->m_use_count++ == 0) m_lru.erase(m_lru.iterator_to(*x));
+    }
+
+    void destroy(entry* x)
+    {
+        x->m_ptr.release();
+        delete x;
+    }
+
+    void evict()
+    {
+        while (m_size > m_capacity && !m_lru.empty())
+        {
+            auto x = &m_lru.front();
+            m_lru.pop_front();
+            m_entries.erase(x->m_begin);
+            m_size -= x->m_end - x->m_begin;
+            ++m_stats.evictions;
+            destroy(x);
+        }
+    }
+
+    void invalidate_range(std::uintptr_t b, std::uintptr_t e)
+    {
+        auto it = m_entries.upper_bound(b);
+        if (it != m_entries.begin() && std::prev(it)->second->m_end > b) --it;
+        while (it != m_entries.end() && it->first < e)
+        {
+            auto x = it->second;
+            it = m_entries.erase(it);
+            m_size -= x->m_end - x->m_begin;
+            ++m_stats.invalidations;
+            // entries in use are destroyed when the last message buffer is released
+            if (x->m_use_count > 0) x->m_valid = false;
+            else
+            {
+                m_lru.erase(m_lru.iterator_to(*x));
+                destroy(x);
+            }
+        }
+        if (m_entries.empty())
+        {
+            m_lo = UINTPTR_MAX;
+            m_hi = 0;
+        }
+    }
+
+    void process_pending()
+    {
+        if (!m_has_pending.load(std::memory_order_acquire)) return;
+        m_has_pending.store(false, std::memory_order_relaxed);
+        range r;
+        while (m_pending.pop(r)) invalidate_range(r.m_begin, r.m_end);
+        if (m_pending_overflow.exchange(false)) invalidate_range(0, UINTPTR_MAX);
+    }
+};
+
+} // namespace oomph
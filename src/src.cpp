@@ -13,6 +13,10 @@
 #endif
 #include <oomph/util/heap_pimpl.hpp>
 #include <oomph/util/stack_pimpl.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <string>
 
 namespace oomph
 {
@@ -35,7 +39,240 @@ context::~context() = default;
 communicator
 context::get_communicator()
 {
-    return {m->get_communicator()};
+    communicator c{m->get_communicator()};
+    c.m_impl->set_request_pool(c.m_pool.get());
+    return c;
+}
+
+communication_stats
+context::stats() const
+{
+    return m->stats();
+}
+
+std::vector<peer_latency>
+context::latency() const
+{
+    return m->latency();
+}
+
+memory_stats
+context::memory() const
+{
+    return m->memory();
+}
+
+std::chrono::nanoseconds
+context::global_time() const noexcept
+{
+    return std::chrono::nanoseconds(m->clock().global_ns());
+}
+
+std::chrono::nanoseconds
+context::global_time_error() const noexcept
+{
+    return std::chrono::nanoseconds(m->clock().error_ns());
+}
+
+void
+context::synchronize_clocks()
+{
+    m->synchronize_clocks();
+}
+
+void
+context::invalidate_registrations(void const* ptr, std::size_t size)
+{
+    m->get_registration_cache().invalidate(ptr, size);
+}
+
+///////////////////////////////
+// communication_stats       //
+///////////////////////////////
+
+void
+communication_stats::print(std::ostream& os) const
+{
+    auto const flags = os.flags();
+    auto const precision = os.precision();
+    os << "messages sent:       " << messages_sent << " (" << bytes_sent << " bytes)\n"
+       << "messages received:   " << messages_received << " (" << bytes_received << " bytes)\n"
+       << "max in flight:       " << max_sends_in_flight << " sends, " << max_recvs_in_flight
+       << " receives\n"
+       << "progress calls:      " << progress_calls << " (" << std::fixed << std::setprecision(1)
+       << 100 * idle_progress_fraction() << "% idle)\n"
+       << "callbacks:           " << callbacks << " (" << callback_ns / 1000 << " us)\n"
+       << "lock waits:          " << lock_waits << " (" << lock_wait_ns / 1000 << " us)\n"
+       << "cancellations:       " << cancellations << "\n";
+    os.flags(flags);
+    os.precision(precision);
+    if (callbacks)
+    {
+        os << "callback time histogram (lower bucket bounds):\n";
+        for (std::size_t i = 0; i < num_buckets; ++i)
+            if (callback_histogram[i])
+                os << "  " << std::setw(14) << (i ? (1ull << (i - 1)) : 0ull)
+                   << " ns: " << callback_histogram[i] << "\n";
+    }
+    bool header = false;
+    for (std::size_t r = 0; r < peers.size(); ++r)
+    {
+        auto const& p = peers[r];
+        if (!p.messages_sent && !p.messages_received) continue;
+        if (!header)
+        {
+            os << "  peer   messages sent      bytes sent   messages recv      bytes recv\n";
+            header = true;
+        }
+        os << std::setw(6) << r << std::setw(16) << p.messages_sent << std::setw(16)
+           << p.bytes_sent << std::setw(16) << p.messages_received << std::setw(16)
+           << p.bytes_received << "\n";
+    }
+    if (wait_unmatched) os << "wait unmatched:      " << wait_unmatched << "\n";
+    header = false;
+    for (std::size_t r = 0; r < peers.size(); ++r)
+    {
+        auto const& p = peers[r];
+        if (!p.wait_samples) continue;
+        if (!header)
+        {
+            os << "  peer    wait samples  late sender us  late receiver us     transfer us\n";
+            header = true;
+        }
+        os << std::setw(6) << r << std::setw(16) << p.wait_samples << std::setw(16)
+           << p.late_sender_ns / 1000 << std::setw(18) << p.late_receiver_ns / 1000
+           << std::setw(16) << p.transfer_ns / 1000 << "\n";
+    }
+}
+
+///////////////////////////////
+// memory_stats              //
+///////////////////////////////
+
+void
+memory_stats::print(std::ostream& os) const
+{
+    auto const line = [&os](char const* name, high_water const& x)
+    { os << name << x.current << " bytes (peak " << x.peak << ")\n"; };
+    auto const indexed = [&os, &line](std::string const& name, high_water const& x)
+    {
+        os << std::left << std::setw(21) << name << std::right;
+        line("", x);
+    };
+    for (std::size_t i = 0; i < registered_host.size(); ++i)
+        indexed("registered node " + std::to_string(i) + ":", registered_host[i]);
+    for (std::size_t i = 0; i < registered_device.size(); ++i)
+        indexed("registered device " + std::to_string(i) + ":", registered_device[i]);
+    line("rma heap:            ", rma);
+    line("addresses:           ", addresses);
+    line("request pools:       ", request_pools);
+    line("queues:              ", queues);
+    line("memory total:        ", total);
+    if (workers.peak)
+        os << "workers:             " << workers.current << " (peak " << workers.peak << ")\n"
+           << "endpoints:           " << endpoints.current << " (peak " << endpoints.peak
+           << ")\n";
+}
+
+///////////////////////////////
+// latency report            //
+///////////////////////////////
+
+namespace
+{
+// per peer and direction: number of operations, p50, p99 and max in us
+constexpr int latency_fields = 4;
+
+void
+gather_latency_fields(latency_histogram const& h, double* f)
+{
+    f[0] = (double)h.count();
+    f[1] = h.quantile(0.5) / 1000.0;
+    f[2] = h.quantile(0.99) / 1000.0;
+    f[3] = h.max() / 1000.0;
+}
+} // namespace
+
+void
+print_latency_report(context const& ctxt, std::ostream& os, int root)
+{
+    MPI_Comm comm = ctxt.mpi_comm();
+    int      rank, size;
+    OOMPH_CHECK_MPI_RESULT(MPI_Comm_rank(comm, &rank));
+    OOMPH_CHECK_MPI_RESULT(MPI_Comm_size(comm, &size));
+    auto const          latency = ctxt.latency();
+    int const           row = 2 * latency_fields * size;
+    std::vector<double> local(row);
+    for (int p = 0; p < size; ++p)
+    {
+        gather_latency_fields(latency[p].send, &local[2 * latency_fields * p]);
+        gather_latency_fields(latency[p].recv, &local[2 * latency_fields * p + latency_fields]);
+    }
+    std::vector<double> all(rank == root ? (std::size_t)row * size : 0);
+    OOMPH_CHECK_MPI_RESULT(
+        MPI_Gather(local.data(), row, MPI_DOUBLE, all.data(), row, MPI_DOUBLE, root, comm));
+    if (rank != root) return;
+
+    // field f of direction d (0: send, 1: recv) from rank r to peer p
+    auto const at = [&](int r, int p, int d, int f) {
+        return all[(std::size_t)r * row + 2 * latency_fields * p + d * latency_fields + f];
+    };
+
+    auto const flags = os.flags();
+    auto const precision = os.precision();
+    os << std::fixed << std::setprecision(1);
+    char const* directions[] = {"send", "recv"};
+    char const* metrics[] = {"p50", "p99", "max"};
+    for (int d = 0; d < 2; ++d)
+        for (int f = 1; f < latency_fields; ++f)
+        {
+            os << directions[d] << " latency " << metrics[f - 1]
+               << " [us] (row: rank, column: peer)\n      ";
+            for (int p = 0; p < size; ++p) os << std::setw(10) << p;
+            os << "\n";
+            for (int r = 0; r < size; ++r)
+            {
+                os << std::setw(6) << r;
+                for (int p = 0; p < size; ++p)
+                {
+                    if (at(r, p, d, 0) > 0) os << std::setw(10) << at(r, p, d, f);
+                    else
+                        os << std::setw(10) << "-";
+                }
+                os << "\n";
+            }
+        }
+
+    // links ordered by p99, marked when slower than 4x the median p99 of their direction (receives
+    // include the time until the message was sent)
+    struct link
+    {
+        int    r, p;
+        double p99;
+    };
+    for (int d = 0; d < 2; ++d)
+    {
+        std::vector<link> links;
+        for (int r = 0; r < size; ++r)
+            for (int p = 0; p < size; ++p)
+                if (at(r, p, d, 0) > 0) links.push_back(link{r, p, at(r, p, d, 2)});
+        if (links.empty()) continue;
+        std::sort(links.begin(), links.end(),
+            [](link const& a, link const& b) { return a.p99 > b.p99; });
+        double const median = links[links.size() / 2].p99;
+        os << "slowest " << directions[d] << " links (median p99 " << median << " us):\n";
+        for (std::size_t i = 0; i < std::min<std::size_t>(links.size(), 10); ++i)
+        {
+            auto const& l = links[i];
+            os << std::setw(6) << l.r << (d ? " <- " : " -> ") << std::setw(6) << l.p << "  p50 "
+               << std::setw(10) << at(l.r, l.p, d, 1) << "  p99 " << std::setw(10) << l.p99
+               << "  max " << std::setw(10) << at(l.r, l.p, d, 3) << "  ("
+               << (std::uint64_t)at(l.r, l.p, d, 0) << " ops)"
+               << (l.p99 > 4 * median ? "  *" : "") << "\n";
+        }
+    }
+    os.flags(flags);
+    os.precision(precision);
 }
 
 ///////////////////////////////
@@ -81,6 +318,162 @@ communicator::progress()
     m_impl->progress();
 }
 
+communication_stats
+communicator::stats() const
+{
+    communication_stats s;
+    m_impl->m_stats.read(s);
+    return s;
+}
+
+std::vector<peer_latency>
+communicator::latency() const
+{
+    std::vector<peer_latency> l;
+    m_impl->m_stats.read(l);
+    l.resize(size());
+    return l;
+}
+
+void
+communicator::set_callback_execution(callback_execution e) noexcept
+{
+    m_execution = e;
+    m_impl->m_stats.m_time_completion_handlers = (e == callback_execution::immediate);
+}
+
+std::size_t
+communicator::run_deferred_callbacks()
+{
+    return m_impl->run_deferred();
+}
+
+void
+communicator::wait_all()
+{
+    std::size_t n = 0;
+    while (!is_ready())
+    {
+        progress();
+        run_deferred_callbacks();
+        m_impl->backoff(n);
+    }
+}
+
+void
+communicator::defer_callback(impl_type* impl, util::unique_function<void()>&& f)
+{
+    impl->m_executor.defer(std::move(f));
+}
+
+void
+communicator::offload_callback(impl_type* impl, util::unique_function<void()>&& f)
+{
+    impl->callback_pool().submit(std::move(f));
+}
+
+void
+communicator::complete_offloaded(impl_type* impl, shared_request_ptr&& req)
+{
+    impl->m_executor.complete(std::move(req));
+}
+
+template<typename Request>
+std::size_t
+communicator::test_some_impl(util::span<Request> reqs, util::span<std::size_t> indices, bool wait)
+{
+    if (indices.empty()) return 0;
+
+    // requests which are ready already are reported right away, the others report their index
+    // when they complete during progress; those still pending are let go when watch goes out of
+    // scope, also if a callback throws
+    detail::request_index_watch watch{indices.data(), indices.size()};
+    for (std::size_t i = 0; i < reqs.size(); ++i)
+    {
+        auto& d = reqs[i].m_data;
+        if (!d) continue;
+        assert(d->m_comm == m_impl);
+        if (d->m_ready) watch.notify(i);
+        else
+            watch.add(*d, i);
+    }
+    if (watch.m_count == 0 && !watch.m_first) return 0;
+
+    if (watch.m_count == 0)
+    {
+        progress();
+        run_deferred_callbacks();
+        std::size_t n = 0;
+        while (wait && watch.m_count == 0)
+        {
+            m_impl->backoff(n);
+            progress();
+            run_deferred_callbacks();
+        }
+    }
+
+    watch.clear();
+    for (std::size_t k = 0; k < watch.m_count; ++k) reqs[indices[k]].m_data.reset();
+    return watch.m_count;
+}
+
+std::size_t
+communicator::test_some(util::span<send_request> reqs, util::span<std::size_t> indices)
+{
+    return test_some_impl(reqs, indices, false);
+}
+
+std::size_t
+communicator::test_some(util::span<recv_request> reqs, util::span<std::size_t> indices)
+{
+    return test_some_impl(reqs, indices, false);
+}
+
+std::size_t
+communicator::wait_some(util::span<send_request> reqs, util::span<std::size_t> indices)
+{
+    return test_some_impl(reqs, indices, true);
+}
+
+std::size_t
+communicator::wait_some(util::span<recv_request> reqs, util::span<std::size_t> indices)
+{
+    return test_some_impl(reqs, indices, true);
+}
+
+std::size_t
+communicator::wait_any(util::span<send_request> reqs)
+{
+    std::size_t index;
+    return test_some_impl(reqs, {&index, 1}, true) ? index : reqs.size();
+}
+
+std::size_t
+communicator::wait_any(util::span<recv_request> reqs)
+{
+    std::size_t index;
+    return test_some_impl(reqs, {&index, 1}, true) ? index : reqs.size();
+}
+
+void
+communicator::enable_completion_queue(std::size_t capacity)
+{
+    if (capacity == 0)
+        throw std::runtime_error("oomph: completion queue capacity must be positive");
+    if (m_cq && m_cq->reserved() > 0)
+        throw std::runtime_error("oomph: completion queue in use, cannot be resized");
+    m_cq = std::make_unique<detail::completion_queue>(capacity);
+    m_impl->set_completion_queue(m_cq.get());
+}
+
+std::size_t
+communicator::poll_completions(util::span<completion> out)
+{
+    if (!m_cq) throw std::runtime_error("oomph: completion queue not enabled");
+    progress();
+    return m_cq->pop(out);
+}
+
 ///////////////////////////////
 // message_buffer            //
 ///////////////////////////////
@@ -88,12 +481,22 @@ communicator::progress()
 namespace detail
 {
 using heap_ptr = typename context_impl::heap_type::pointer;
+using registration_handle = typename context_impl::registration_cache_type::handle;
+using registration_entry = typename context_impl::registration_cache_type::entry;
 
 class message_buffer::heap_ptr_impl
 {
   public:
-    heap_ptr m;
-    void     release() { m.release(); }
+    heap_ptr            m;
+    std::size_t         m_offset = 0;       // byte offset within a cached registration
+    registration_entry* m_entry = nullptr; // cached registration, if any
+
+    void release()
+    {
+        if (m_entry) m_entry->release();
+        else
+            m.release();
+    }
 };
 
 message_buffer::message_buffer() = default;
@@ -105,7 +508,14 @@ message_buffer::message_buffer(typename context_impl::heap_type::pointer ptr)
 {
 }
 
-message_buffer::message_buffer(message_buffer&& other)
+template<>
+message_buffer::message_buffer(registration_handle h)
+: m_ptr{static_cast<char*>(h.m_ptr.get()) + h.m_offset}
+, m_heap_ptr(h.m_ptr, h.m_offset, h.m_entry)
+{
+}
+
+message_buffer::message_buffer(message_buffer&& other) noexcept
 : m_ptr{std::exchange(other.m_ptr, nullptr)}
 , m_heap_ptr{std::move(other.m_heap_ptr)}
 {
@@ -117,7 +527,7 @@ message_buffer::~message_buffer()
 }
 
 message_buffer&
-message_buffer::operator=(message_buffer&& other)
+message_buffer::operator=(message_buffer&& other) noexcept
 {
     if (m_ptr) m_heap_ptr->release();
     m_ptr = std::exchange(other.m_ptr, nullptr);
@@ -176,18 +586,208 @@ message_buffer::clear()
 // communicator              //
 ///////////////////////////////
 
+namespace
+{
+// completion handler of a message sampled for tracing
+struct traced_callback
+{
+    communicator_impl*            m_comm;
+    std::uint32_t                 m_id;
+    util::unique_function<void()> m_cb;
+
+    void operator()()
+    {
+        m_comm->trace(trace_event::complete, m_id);
+        m_comm->trace(trace_event::callback_begin, m_id);
+        m_cb();
+        m_comm->trace(trace_event::callback_end, m_id);
+    }
+};
+
+// completion of a message without callback sampled for tracing (m_id != 0), wait analysis or
+// recorded (m_op != 0): the message is posted with this callback instead of a plain completion
+struct sampled_completion
+{
+    communicator_impl*               m_comm;
+    std::uint32_t                    m_id;
+    std::uint32_t                    m_op;
+    std::size_t*                     m_scheduled;
+    communicator::shared_request_ptr m_req;
+
+    void operator()()
+    {
+        if (m_op) m_comm->on_recorded_completion(m_op);
+        if (m_id) m_comm->trace(trace_event::complete, m_id);
+        if (m_req) m_req->set_ready();
+        --(*m_scheduled);
+    }
+};
+
+// completion handler of a receive sampled for wait analysis
+struct waited_callback
+{
+    communicator_impl*            m_comm;
+    std::uint32_t                 m_slot;
+    util::unique_function<void()> m_cb;
+
+    void operator()()
+    {
+        m_comm->on_sampled_recv_completion(m_slot);
+        m_cb();
+    }
+};
+
+// completion handler of a recorded operation, see recorder
+struct recorded_callback
+{
+    communicator_impl*            m_comm;
+    std::uint32_t                 m_op;
+    util::unique_function<void()> m_cb;
+
+    void operator()()
+    {
+        m_comm->on_recorded_completion(m_op);
+        m_cb();
+    }
+};
+} // namespace
+
 void
 communicator::send(detail::message_buffer::heap_ptr_impl const* m_ptr, std::size_t size,
-    rank_type dst, tag_type tag, util::unique_function<void()> cb, shared_request_ptr req)
+    rank_type dst, tag_type tag, util::unique_function<void()>&& cb, shared_request_ptr req)
 {
-    m_impl->send(m_ptr->m, size, dst, tag, std::move(cb), std::move(req));
+    send(m_ptr, 0, size, dst, tag, std::move(cb), std::move(req));
+}
+
+void
+communicator::send(detail::message_buffer::heap_ptr_impl const* m_ptr, std::size_t offset,
+    std::size_t size, rank_type dst, tag_type tag, util::unique_function<void()>&& cb,
+    shared_request_ptr req)
+{
+    // copied before cb is moved: the message may be held by cb
+    auto const ptr = m_ptr->m;
+    offset += m_ptr->m_offset;
+    m_impl->on_send_post(dst, tag, size, m_schedule->scheduled_sends);
+    auto const id = m_impl->trace_post(trace_event::post_send, dst, tag, size);
+    auto const op = m_impl->record_post(record_kind::send, dst, tag, size);
+    if (id) cb = traced_callback{m_impl, id, std::move(cb)};
+    if (op) cb = recorded_callback{m_impl, op, std::move(cb)};
+    m_impl->send(ptr, offset, size, dst, tag, std::move(cb), std::move(req));
+    if (id) m_impl->trace(trace_event::inject, id);
 }
 
 void
 communicator::recv(detail::message_buffer::heap_ptr_impl* m_ptr, std::size_t size, rank_type src,
-    tag_type tag, util::unique_function<void()> cb, shared_request_ptr req)
+    tag_type tag, util::unique_function<void()>&& cb, shared_request_ptr req)
+{
+    recv(m_ptr, 0, size, src, tag, std::move(cb), std::move(req));
+}
+
+void
+communicator::recv(detail::message_buffer::heap_ptr_impl* m_ptr, std::size_t offset,
+    std::size_t size, rank_type src, tag_type tag, util::unique_function<void()>&& cb,
+    shared_request_ptr req)
+{
+    // copied before cb is moved: the message may be held by cb
+    auto ptr = m_ptr->m;
+    offset += m_ptr->m_offset;
+    auto const slot = m_impl->on_recv_post(src, tag, size, m_schedule->scheduled_recvs);
+    auto const id = m_impl->trace_post(trace_event::post_recv, src, tag, size);
+    auto const op = m_impl->record_post(record_kind::recv, src, tag, size);
+    if (id) cb = traced_callback{m_impl, id, std::move(cb)};
+    if (slot) cb = waited_callback{m_impl, slot, std::move(cb)};
+    if (op) cb = recorded_callback{m_impl, op, std::move(cb)};
+    m_impl->recv(ptr, offset, size, src, tag, std::move(cb), std::move(req));
+    if (id) m_impl->trace(trace_event::inject, id);
+}
+
+void
+communicator::send(detail::message_buffer::heap_ptr_impl const* m_ptr, std::size_t offset,
+    std::size_t size, rank_type dst, tag_type tag, std::size_t* scheduled, shared_request_ptr req)
+{
+    m_impl->on_send_post(dst, tag, size, m_schedule->scheduled_sends);
+    auto const id = m_impl->trace_post(trace_event::post_send, dst, tag, size);
+    auto const op = m_impl->record_post(record_kind::send, dst, tag, size);
+    if (id || op)
+    {
+        m_impl->send(m_ptr->m, m_ptr->m_offset + offset, size, dst, tag,
+            sampled_completion{m_impl, id, op, scheduled, req}, std::move(req));
+        if (id) m_impl->trace(trace_event::inject, id);
+        return;
+    }
+    m_impl->send(m_ptr->m, m_ptr->m_offset + offset, size, dst, tag, scheduled, std::move(req));
+}
+
+void
+communicator::recv(detail::message_buffer::heap_ptr_impl* m_ptr, std::size_t offset,
+    std::size_t size, rank_type src, tag_type tag, std::size_t* scheduled, shared_request_ptr req)
+{
+    auto const slot = m_impl->on_recv_post(src, tag, size, m_schedule->scheduled_recvs);
+    auto const id = m_impl->trace_post(trace_event::post_recv, src, tag, size);
+    auto const op = m_impl->record_post(record_kind::recv, src, tag, size);
+    if (id || slot || op)
+    {
+        util::unique_function<void()> cb = sampled_completion{m_impl, id, op, scheduled, req};
+        if (slot) cb = waited_callback{m_impl, slot, std::move(cb)};
+        m_impl->recv(m_ptr->m, m_ptr->m_offset + offset, size, src, tag, std::move(cb),
+            std::move(req));
+        if (id) m_impl->trace(trace_event::inject, id);
+        return;
+    }
+    m_impl->recv(m_ptr->m, m_ptr->m_offset + offset, size, src, tag, scheduled, std::move(req));
+}
+
+recv_request
+communicator::recv_iov(std::vector<iov_element> const& iov, rank_type src, tag_type tag)
+{
+    communicator_impl::iov_type pieces;
+    pieces.reserve(iov.size());
+    std::size_t size = 0;
+    for (auto const& e : iov)
+    {
+        pieces.push_back({&e.m_ptr->m, e.m_ptr->m_offset + e.m_offset, e.m_size});
+        size += e.m_size;
+    }
+
+    auto& scheduled = m_schedule->scheduled_recvs;
+    ++scheduled;
+    recv_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
+    util::unique_function<void()> cb = cb_none{r.m_data};
+    auto const slot = m_impl->on_recv_post(src, tag, size, m_schedule->scheduled_recvs);
+    auto const id = m_impl->trace_post(trace_event::post_recv, src, tag, size);
+    auto const op = m_impl->record_post(record_kind::recv, src, tag, size);
+    if (id) cb = traced_callback{m_impl, id, std::move(cb)};
+    if (slot) cb = waited_callback{m_impl, slot, std::move(cb)};
+    if (op) cb = recorded_callback{m_impl, op, std::move(cb)};
+    m_impl->recv_iov(pieces, src, tag, std::move(cb), shared_request_ptr(r.m_data));
+    if (id) m_impl->trace(trace_event::inject, id);
+    return r;
+}
+
+send_request
+communicator::send_iov(std::vector<iov_element> const& iov, rank_type dst, tag_type tag)
 {
-    m_impl->recv(m_ptr->m, size, src, tag, std::move(cb), std::move(req));
+    communicator_impl::iov_type pieces;
+    pieces.reserve(iov.size());
+    std::size_t size = 0;
+    for (auto const& e : iov)
+    {
+        pieces.push_back({&e.m_ptr->m, e.m_ptr->m_offset + e.m_offset, e.m_size});
+        size += e.m_size;
+    }
+
+    auto& scheduled = m_schedule->scheduled_sends;
+    ++scheduled;
+    send_request r(shared_request_ptr(m_pool.get(), m_impl, &scheduled));
+    util::unique_function<void()> cb = cb_none{r.m_data};
+    m_impl->on_send_post(dst, tag, size, m_schedule->scheduled_sends);
+    auto const id = m_impl->trace_post(trace_event::post_send, dst, tag, size);
+    auto const op = m_impl->record_post(record_kind::send, dst, tag, size);
+    if (id) cb = traced_callback{m_impl, id, std::move(cb)};
+    if (op) cb = recorded_callback{m_impl, op, std::move(cb)};
+    m_impl->send_iov(pieces, dst, tag, std::move(cb), shared_request_ptr(r.m_data));
+    if (id) m_impl->trace(trace_event::inject, id);
+    return r;
 }
 
 ///////////////////////////////
@@ -203,7 +803,7 @@ context::make_buffer_core(std::size_t size)
 detail::message_buffer
 context::make_buffer_core(void* ptr, std::size_t size)
 {
-    return m->get_heap().register_user_allocation(ptr, size);
+    return m->get_registration_cache().get(ptr, size);
 }
 
 #if HWMALLOC_ENABLE_DEVICE
@@ -235,7 +835,7 @@ communicator::make_buffer_core(std::size_t size)
 detail::message_buffer
 communicator::make_buffer_core(void* ptr, std::size_t size)
 {
-    return m_impl->get_heap().register_user_allocation(ptr, size);
+    return m_impl->get_registration_cache().get(ptr, size);
 }
 
 #if HWMALLOC_ENABLE_DEVICE
@@ -268,6 +868,7 @@ send_request::test()
     if (!m_data) return true;
     if (m_data->m_ready) return true;
     m_data->m_comm->progress();
+    m_data->m_comm->run_deferred();
     return is_ready();
 }
 
@@ -275,7 +876,13 @@ void
 send_request::wait()
 {
     if (!m_data) return;
-    while (!m_data->m_ready) m_data->m_comm->progress();
+    std::size_t n = 0;
+    while (!m_data->m_ready)
+    {
+        m_data->m_comm->progress();
+        m_data->m_comm->run_deferred();
+        m_data->m_comm->backoff(n);
+    }
 }
 
 bool
@@ -284,6 +891,7 @@ recv_request::test()
     if (!m_data) return true;
     if (m_data->m_ready) return true;
     m_data->m_comm->progress();
+    m_data->m_comm->run_deferred();
     return is_ready();
 }
 
@@ -291,7 +899,13 @@ void
 recv_request::wait()
 {
     if (!m_data) return;
-    while (!m_data->m_ready) m_data->m_comm->progress();
+    std::size_t n = 0;
+    while (!m_data->m_ready)
+    {
+        m_data->m_comm->progress();
+        m_data->m_comm->run_deferred();
+        m_data->m_comm->backoff(n);
+    }
 }
 
 bool
@@ -302,12 +916,112 @@ recv_request::cancel()
     const auto res = m_data->m_comm->cancel_recv_cb(*this);
     if (res)
     {
+        m_data->m_comm->on_cancel();
         --(*(m_data->m_scheduled));
         m_data.reset();
     }
     return res;
 }
 
+/////////////////////////////////
+//// shared_request            //
+/////////////////////////////////
+
+bool
+shared_request::progress(std::size_t* backoff_count) const
+{
+    // only the owning thread may progress a communicator
+    auto const tid = std::this_thread::get_id();
+    if (m->m_comm)
+    {
+        if (m->m_owner != tid) return false;
+        m->m_comm->progress();
+        if (backoff_count) m->m_comm->backoff(*backoff_count);
+        return true;
+    }
+    communicator_impl* first = nullptr;
+    for (auto const& s : m->m_sources)
+    {
+        if (s.second != tid) continue;
+        s.first->progress();
+        if (!first) first = s.first;
+    }
+    if (first && backoff_count) first->backoff(*backoff_count);
+    return first;
+}
+
+bool
+shared_request::test()
+{
+    if (is_ready()) return true;
+    progress(nullptr);
+    return is_ready();
+}
+
+void
+shared_request::wait()
+{
+    if (!m) return;
+    // threads owning none of the communicators wait for their owners to progress them
+    std::size_t n = 0;
+    while (!m->is_ready())
+        if (!progress(&n)) std::this_thread::yield();
+}
+
+shared_request
+shared_request::make_parent(std::vector<shared_request> const& reqs)
+{
+    // distinct communicators of the children, flattening those of composed children
+    std::vector<state_type::source> sources;
+    auto const add = [&sources](state_type::source const& x)
+    {
+        if (x.first && std::find(sources.begin(), sources.end(), x) == sources.end())
+            sources.push_back(x);
+    };
+    for (auto const& x : reqs)
+    {
+        if (!x.m) continue;
+        add({x.m->m_comm, x.m->m_owner});
+        for (auto const& y : x.m->m_sources) add(y);
+    }
+    if (sources.size() == 1) return {sources.front().first, sources.front().second};
+    return {std::move(sources)};
+}
+
+shared_request
+shared_request::make_when_all(std::vector<shared_request> const& reqs)
+{
+    auto r = make_parent(reqs);
+    // one count per child plus one for the setup below, such that r is not completed early
+    r.m->m_pending.store(reqs.size() + 1, std::memory_order_relaxed);
+    auto const arrive = [](state_type* s)
+    {
+        if (s->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) s->set_ready();
+    };
+    for (auto const& x : reqs)
+    {
+        if (!x.m) arrive(r.m);
+        else
+            x.m->add_continuation([p = r, arrive]() { arrive(p.m); });
+    }
+    arrive(r.m);
+    return r;
+}
+
+shared_request
+shared_request::make_when_any(std::vector<shared_request> const& reqs)
+{
+    auto r = make_parent(reqs);
+    if (reqs.empty()) r.m->set_ready();
+    for (auto const& x : reqs)
+    {
+        if (!x.m) r.m->set_ready();
+        else
+            x.m->add_continuation([p = r]() { p.m->set_ready(); });
+    }
+    return r;
+}
+
 /////////////////////////////////
 //// send_channel_base         //
 /////////////////////////////////
@@ -0,0 +1,413 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/stats.hpp>
+#include <oomph/latency.hpp>
+#include "./env.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace oomph
+{
+// Counter which is written by a single thread and may be read by any thread. Relaxed loads and
+// stores compile to plain moves: counting costs the same as a non-atomic increment.
+class relaxed_counter
+{
+  private:
+    std::atomic<std::uint64_t> m_value{0};
+
+  public:
+    void add(std::uint64_t n = 1) noexcept
+    {
+        m_value.store(m_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void max(std::uint64_t v) noexcept
+    {
+        if (v > m_value.load(std::memory_order_relaxed))
+            m_value.store(v, std::memory_order_relaxed);
+    }
+
+    std::uint64_t get() const noexcept { return m_value.load(std::memory_order_relaxed); }
+};
+
+struct peer_counters
+{
+    relaxed_counter messages_sent;
+    relaxed_counter bytes_sent;
+    relaxed_counter messages_received;
+    relaxed_counter bytes_received;
+    relaxed_counter wait_samples;
+    relaxed_counter late_sender_ns;
+    relaxed_counter late_receiver_ns;
+    relaxed_counter transfer_ns;
+};
+
+// Per peer data of one communicator, allocated in blocks of consecutive peers when a peer of the
+// block is first used: memory grows with the number of peers communicated with rather than with
+// the size of the communicator. Blocks are allocated by the owning thread, read by any thread.
+template<typename T>
+class peer_table
+{
+  public:
+    static constexpr std::size_t block_size = 64;
+
+  private:
+    std::size_t const                  m_num_peers;
+    std::unique_ptr<std::atomic<T*>[]> m_blocks;
+
+  public:
+    peer_table(std::size_t num_peers)
+    : m_num_peers{num_peers}
+    , m_blocks{new std::atomic<T*>[num_blocks()]()}
+    {
+    }
+
+    peer_table(peer_table const&) = delete;
+    peer_table& operator=(peer_table const&) = delete;
+
+    ~peer_table()
+    {
+        for (std::size_t i = 0; i < num_blocks(); ++i) delete[] m_blocks[i].load();
+    }
+
+    std::size_t num_peers() const noexcept { return m_num_peers; }
+
+    // called by the owning thread: null if peer is not a rank (e.g. any_source) or out of memory
+    T* get(int peer) noexcept
+    {
+        if (peer < 0 || (std::size_t)peer >= m_num_peers) return nullptr;
+        auto& b = m_blocks[peer / block_size];
+        auto  p = b.load(std::memory_order_relaxed);
+        if (!p)
+        {
+            p = new (std::nothrow) T[block_size]();
+            if (!p) return nullptr;
+            b.store(p, std::memory_order_release);
+        }
+        return p + peer % block_size;
+    }
+
+    // invokes f(peer, data) for the peers of the allocated blocks: may be called by any thread
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (std::size_t i = 0; i < num_blocks(); ++i)
+        {
+            auto const p = m_blocks[i].load(std::memory_order_acquire);
+            if (!p) continue;
+            auto const n = std::min(block_size, m_num_peers - i * block_size);
+            for (std::size_t j = 0; j < n; ++j) f(i * block_size + j, p[j]);
+        }
+    }
+
+  private:
+    std::size_t num_blocks() const noexcept { return (m_num_peers + block_size - 1) / block_size; }
+};
+
+// Per peer latency histograms of one communicator, see latency_histogram. The histogram of a peer
+// is allocated by the owning thread when the first operation with that peer completes.
+class latency_recorder
+{
+  public:
+    using clock_type = std::chrono::steady_clock;
+    static constexpr std::size_t num_buckets = latency_histogram::num_buckets;
+
+  private:
+    struct histogram
+    {
+        std::array<relaxed_counter, num_buckets> m_counts;
+        relaxed_counter                          m_max;
+    };
+
+    peer_table<std::atomic<histogram*>> m_hists;
+
+  public:
+    latency_recorder(std::size_t num_peers)
+    : m_hists{num_peers}
+    {
+    }
+
+    ~latency_recorder()
+    {
+        m_hists.for_each([](std::size_t, std::atomic<histogram*> const& h) { delete h.load(); });
+    }
+
+    // operations with any_source are not attributed to a peer and are skipped
+    void record(int peer, std::uint64_t ns) noexcept
+    {
+        auto const p = m_hists.get(peer);
+        if (!p) return;
+        auto h = p->load(std::memory_order_relaxed);
+        if (!h)
+        {
+            h = new (std::nothrow) histogram;
+            if (!h) return;
+            p->store(h, std::memory_order_release);
+        }
+        h->m_counts[latency_histogram::bucket(ns)].add();
+        h->m_max.max(ns);
+    }
+
+    // adds the histogram of each peer to out[peer].*member: may be called by any thread
+    void read(std::vector<peer_latency>& out, latency_histogram peer_latency::*member) const
+    {
+        if (out.size() < m_hists.num_peers()) out.resize(m_hists.num_peers());
+        m_hists.for_each(
+            [&out, member](std::size_t i, std::atomic<histogram*> const& p)
+            {
+                auto const h = p.load(std::memory_order_acquire);
+                if (!h) return;
+                auto& l = out[i].*member;
+                for (std::size_t j = 0; j < num_buckets; ++j)
+                    l.add_bucket(j, h->m_counts[j].get());
+                l.add_max(h->m_max.get());
+            });
+    }
+};
+
+// Counters of one communicator, updated by its owning thread only and aggregated on read.
+class communication_counters
+{
+  public:
+    using clock_type = std::chrono::steady_clock;
+    static constexpr std::size_t num_buckets = communication_stats::num_buckets;
+
+  private:
+    relaxed_counter                          m_messages_sent;
+    relaxed_counter                          m_bytes_sent;
+    relaxed_counter                          m_messages_received;
+    relaxed_counter                          m_bytes_received;
+    relaxed_counter                          m_max_sends_in_flight;
+    relaxed_counter                          m_max_recvs_in_flight;
+    relaxed_counter                          m_progress_calls;
+    relaxed_counter                          m_idle_progress_calls;
+    relaxed_counter                          m_callbacks;
+    relaxed_counter                          m_callback_ns;
+    relaxed_counter                          m_lock_waits;
+    relaxed_counter                          m_lock_wait_ns;
+    relaxed_counter                          m_cancellations;
+    relaxed_counter                          m_wait_unmatched;
+    std::array<relaxed_counter, num_buckets> m_callback_histogram;
+    peer_table<peer_counters>                m_peers;
+
+  public:
+    latency_recorder m_send_latency;
+    latency_recorder m_recv_latency;
+
+    // completion handlers are only counted when they are the user callbacks (immediate execution),
+    // otherwise the callbacks are counted when they are run deferred
+    bool m_time_completion_handlers = true;
+
+  public:
+    communication_counters(std::size_t num_peers)
+    : m_peers{num_peers}
+    , m_send_latency(num_peers)
+    , m_recv_latency(num_peers)
+    {
+    }
+
+    static std::uint64_t elapsed_ns(clock_type::time_point start) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start)
+            .count();
+    }
+
+    void post_send(int dst, std::size_t bytes, std::size_t in_flight) noexcept
+    {
+        m_messages_sent.add();
+        m_bytes_sent.add(bytes);
+        m_max_sends_in_flight.max(in_flight);
+        if (auto const p = m_peers.get(dst))
+        {
+            p->messages_sent.add();
+            p->bytes_sent.add(bytes);
+        }
+    }
+
+    void post_recv(int src, std::size_t bytes, std::size_t in_flight) noexcept
+    {
+        m_messages_received.add();
+        m_bytes_received.add(bytes);
+        m_max_recvs_in_flight.max(in_flight);
+        if (auto const p = m_peers.get(src))
+        {
+            p->messages_received.add();
+            p->bytes_received.add(bytes);
+        }
+    }
+
+    void progress(bool found_work) noexcept
+    {
+        m_progress_calls.add();
+        if (!found_work) m_idle_progress_calls.add();
+    }
+
+    // a callback which was not timed
+    void callback() noexcept { m_callbacks.add(); }
+
+    void callback(std::uint64_t ns) noexcept
+    {
+        m_callbacks.add();
+        m_callback_ns.add(ns);
+        std::size_t b = ns ? 64 - __builtin_clzll(ns) : 0;
+        m_callback_histogram[b < num_buckets ? b : num_buckets - 1].add();
+    }
+
+    void lock_wait(std::uint64_t ns) noexcept
+    {
+        m_lock_waits.add();
+        m_lock_wait_ns.add(ns);
+    }
+
+    void cancellation() noexcept { m_cancellations.add(); }
+
+    void wait_state(int src, std::uint64_t late_sender_ns, std::uint64_t late_receiver_ns,
+        std::uint64_t transfer_ns) noexcept
+    {
+        auto const p = m_peers.get(src);
+        if (!p) return;
+        p->wait_samples.add();
+        p->late_sender_ns.add(late_sender_ns);
+        p->late_receiver_ns.add(late_receiver_ns);
+        p->transfer_ns.add(transfer_ns);
+    }
+
+    void wait_unmatched() noexcept { m_wait_unmatched.add(); }
+
+    // adds the counters to s: may be called by any thread
+    void read(communication_stats& s) const
+    {
+        s.messages_sent += m_messages_sent.get();
+        s.bytes_sent += m_bytes_sent.get();
+        s.messages_received += m_messages_received.get();
+        s.bytes_received += m_bytes_received.get();
+        s.max_sends_in_flight = std::max(s.max_sends_in_flight, m_max_sends_in_flight.get());
+        s.max_recvs_in_flight = std::max(s.max_recvs_in_flight, m_max_recvs_in_flight.get());
+        s.progress_calls += m_progress_calls.get();
+        s.idle_progress_calls += m_idle_progress_calls.get();
+        s.callbacks += m_callbacks.get();
+        s.callback_ns += m_callback_ns.get();
+        s.lock_waits += m_lock_waits.get();
+        s.lock_wait_ns += m_lock_wait_ns.get();
+        s.cancellations += m_cancellations.get();
+        s.wait_unmatched += m_wait_unmatched.get();
+        for (std::size_t i = 0; i < num_buckets; ++i)
+            s.callback_histogram[i] += m_callback_histogram[i].get();
+        if (s.peers.size() < m_peers.num_peers()) s.peers.resize(m_peers.num_peers());
+        m_peers.for_each(
+            [&s](std::size_t i, peer_counters const& c)
+            {
+                auto& p = s.peers[i];
+                p.messages_sent += c.messages_sent.get();
+                p.bytes_sent += c.bytes_sent.get();
+                p.messages_received += c.messages_received.get();
+                p.bytes_received += c.bytes_received.get();
+                p.wait_samples += c.wait_samples.get();
+                p.late_sender_ns += c.late_sender_ns.get();
+                p.late_receiver_ns += c.late_receiver_ns.get();
+                p.transfer_ns += c.transfer_ns.get();
+            });
+    }
+
+    void read(std::vector<peer_latency>& l) const
+    {
+        m_send_latency.read(l, &peer_latency::send);
+        m_recv_latency.read(l, &peer_latency::recv);
+    }
+};
+
+// Appends a report to <OOMPH_STATS_FILE>.<rank>.txt every OOMPH_STATS_INTERVAL milliseconds
+// (default 1000) and once more on destruction.
+class stats_dump
+{
+  public:
+    using clock_type = std::chrono::steady_clock;
+    using report_type = std::function<void(std::ostream&)>;
+
+  private:
+    std::ofstream             m_file;
+    std::chrono::milliseconds m_interval;
+    report_type               m_report;
+    int const                 m_rank;
+    clock_type::time_point    m_start;
+    std::mutex                m_mutex;
+    std::condition_variable   m_cv;
+    bool                      m_stop = false;
+    std::thread               m_thread;
+
+  public:
+    static std::unique_ptr<stats_dump> from_env(int rank, report_type report)
+    {
+        char const* prefix = std::getenv("OOMPH_STATS_FILE");
+        if (!prefix || !*prefix) return {};
+        return std::make_unique<stats_dump>(
+            std::string(prefix) + "." + std::to_string(rank) + ".txt",
+            std::chrono::milliseconds(env_size("OOMPH_STATS_INTERVAL", 1000)), std::move(report),
+            rank);
+    }
+
+    stats_dump(std::string const& path, std::chrono::milliseconds interval, report_type report,
+        int rank)
+    : m_file(path)
+    , m_interval{interval}
+    , m_report{std::move(report)}
+    , m_rank{rank}
+    , m_start{clock_type::now()}
+    {
+        if (!m_file) throw std::runtime_error("oomph: cannot open statistics file " + path);
+        if (m_interval.count() > 0) m_thread = std::thread([this]() { run(); });
+    }
+
+    stats_dump(stats_dump const&) = delete;
+    stats_dump& operator=(stats_dump const&) = delete;
+
+    ~stats_dump()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+        dump();
+    }
+
+  private:
+    void dump()
+    {
+        auto const t = std::chrono::duration<double>(clock_type::now() - m_start).count();
+        m_file << "# oomph statistics of rank " << m_rank << " after " << t << " s\n";
+        m_report(m_file);
+        m_file << std::endl;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_cv.wait_for(lock, m_interval, [this]() { return m_stop; })) dump();
+    }
+};
+
+} // namespace oomph
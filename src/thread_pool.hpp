@@ -0,0 +1,140 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/util/unique_function.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace oomph
+{
+// Thread pool with one mutex-guarded queue per worker: jobs are distributed round robin, and a
+// worker whose queue is empty takes jobs from the back of the other queues. Submitting only takes
+// the lock of one queue, plus the pool lock if a worker is asleep. Jobs which are still queued on
+// destruction are run before the workers are joined.
+class thread_pool
+{
+  public:
+    using job_type = util::unique_function<void()>;
+
+  private:
+    struct worker_queue
+    {
+        std::mutex           m_mutex;
+        std::deque<job_type> m_jobs;
+    };
+
+  private:
+    std::vector<std::unique_ptr<worker_queue>> m_queues;
+    std::vector<std::thread>                   m_threads;
+    std::atomic<std::size_t>                   m_next{0};
+    std::atomic<std::size_t>                   m_pending{0};  // queued jobs
+    std::atomic<std::size_t>                   m_sleeping{0}; // workers waiting for jobs
+    std::mutex                                 m_mutex;       // for waiting and waking up
+    std::condition_variable                    m_cv;
+    bool                                       m_stop = false; // protected by m_mutex
+
+  public:
+    thread_pool(std::size_t num_threads)
+    {
+        if (num_threads == 0) num_threads = 1;
+        for (std::size_t i = 0; i < num_threads; ++i)
+            m_queues.push_back(std::make_unique<worker_queue>());
+        for (std::size_t i = 0; i < num_threads; ++i)
+            m_threads.emplace_back([this, i]() { work(i); });
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    std::size_t size() const noexcept { return m_threads.size(); }
+
+    // may be called from any thread
+    void submit(job_type&& job)
+    {
+        // pairs with work(): either the job is seen by a worker about to sleep, or the sleeping
+        // worker is seen here (both sequentially consistent)
+        m_pending.fetch_add(1);
+        auto& q = *m_queues[m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.m_mutex);
+            q.m_jobs.push_back(std::move(job));
+        }
+        if (m_sleeping.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cv.notify_one();
+        }
+    }
+
+  private:
+    bool pop(std::size_t i, job_type& job)
+    {
+        auto&                       q = *m_queues[i];
+        std::lock_guard<std::mutex> lock(q.m_mutex);
+        if (q.m_jobs.empty()) return false;
+        job = std::move(q.m_jobs.front());
+        q.m_jobs.pop_front();
+        return true;
+    }
+
+    bool steal(std::size_t i, job_type& job)
+    {
+        for (std::size_t k = 1; k < m_queues.size(); ++k)
+        {
+            auto&                       q = *m_queues[(i + k) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(q.m_mutex);
+            if (q.m_jobs.empty()) continue;
+            job = std::move(q.m_jobs.back());
+            q.m_jobs.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    void work(std::size_t i)
+    {
+        job_type job;
+        while (true)
+        {
+            if (pop(i, job) || steal(i, job))
+            {
+                m_pending.fetch_sub(1);
+                job();
+                job.reset();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_sleeping.fetch_add(1);
+            // a job which is counted but not queued yet is picked up by the next iteration
+            m_cv.wait(lock, [this]() { return m_stop || m_pending.load() > 0; });
+            m_sleeping.fetch_sub(1);
+            if (m_stop && m_pending.load() == 0) return;
+        }
+    }
+};
+
+} // namespace oomph
@@ -0,0 +1,74 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "./tool_hooks.hpp"
+#include <dlfcn.h>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+namespace oomph
+{
+namespace tool
+{
+namespace detail
+{
+std::atomic<hooks const*> g_attached{nullptr};
+} // namespace detail
+
+namespace
+{
+std::once_flag s_load_flag;
+} // namespace
+
+void
+attach_tool(hooks const& h)
+{
+    // a published table is never modified nor freed: other threads may still be using one which
+    // has been replaced or detached (one small table is leaked per attach)
+    detail::g_attached.store(new hooks(h), std::memory_order_release);
+}
+
+void
+detach_tool()
+{
+    detail::g_attached.store(nullptr, std::memory_order_release);
+}
+
+void
+detail::load_from_env()
+{
+    std::call_once(s_load_flag,
+        []()
+        {
+            char const* path = std::getenv("OOMPH_TOOL");
+            if (!path || !*path || g_attached.load()) return;
+            // the library stays loaded: the hooks point into it
+            void* lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+            if (!lib)
+            {
+                std::cerr << "oomph warning: cannot load tool " << path << ": " << dlerror()
+                          << std::endl;
+                return;
+            }
+            auto init = reinterpret_cast<void (*)(hooks*)>(dlsym(lib, "oomph_tool_init"));
+            if (!init)
+            {
+                std::cerr << "oomph warning: tool " << path << " does not export oomph_tool_init"
+                          << std::endl;
+                return;
+            }
+            hooks h;
+            init(&h);
+            attach_tool(h);
+        });
+}
+
+} // namespace tool
+} // namespace oomph
@@ -0,0 +1,90 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/tool.hpp>
+#include <atomic>
+#include <chrono>
+#include <utility>
+
+namespace oomph
+{
+namespace tool
+{
+namespace detail
+{
+extern std::atomic<hooks const*> g_attached;
+
+// loads the tool named by OOMPH_TOOL unless one is attached already, once per process
+void load_from_env();
+} // namespace detail
+
+// the attached hooks table or null: callers test this before preparing the hook arguments
+inline hooks const*
+attached() noexcept
+{
+    auto const t = detail::g_attached.load(std::memory_order_acquire);
+    return __builtin_expect(t != nullptr, 0) ? t : nullptr;
+}
+
+// times a phase of the setup or teardown of a context until it is destroyed, see hooks::phase
+class phase_timer
+{
+  private:
+    using clock_type = std::chrono::steady_clock;
+
+    hooks const*           m_hooks;
+    void const*            m_context;
+    char const*            m_name;
+    clock_type::time_point m_start;
+
+  public:
+    phase_timer(void const* context, char const* name)
+    : m_hooks{attached()}
+    , m_context{context}
+    , m_name{name}
+    {
+        if (m_hooks && m_hooks->phase) m_start = clock_type::now();
+    }
+
+    phase_timer(phase_timer const&) = delete;
+    phase_timer& operator=(phase_timer const&) = delete;
+
+    ~phase_timer() { end(); }
+
+    // ends the current phase and starts the next one
+    void next(char const* name)
+    {
+        end();
+        m_name = name;
+        if (m_hooks && m_hooks->phase) m_start = clock_type::now();
+    }
+
+  private:
+    void end()
+    {
+        if (!m_hooks || !m_hooks->phase) return;
+        auto const d = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock_type::now() - m_start);
+        m_hooks->phase(m_hooks->user_data, phase_info{m_context, m_name, std::uint64_t(d.count())});
+    }
+};
+
+// returns f(), which is constructed in place, timed as one phase
+template<typename F>
+auto
+timed_phase(void const* context, char const* name, F&& f)
+{
+    phase_timer t{context, name};
+    return std::forward<F>(f)();
+}
+
+} // namespace tool
+} // namespace oomph
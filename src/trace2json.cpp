@@ -0,0 +1,214 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#include "./trace_format.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Converts the binary trace files written by oomph (one per rank) into a single Chrome trace JSON
+// file, which can be loaded in chrome://tracing or Perfetto:
+//
+//     oomph_trace2json [-o trace.json] trace.0.bin trace.1.bin ...
+//
+// Ranks are shown as processes and communicators as threads. Messages are asynchronous slices
+// from post to completion, callbacks, progress and lock waits are nested slices.
+
+namespace
+{
+using namespace oomph;
+
+struct trace_file
+{
+    trace_file_header         m_header;
+    std::vector<trace_record> m_records;
+
+    explicit trace_file(std::string const& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("cannot open " + path);
+        in.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+        if (!in || std::memcmp(m_header.m_magic, trace_file_header::magic, 8) != 0)
+            throw std::runtime_error(path + " is not an oomph trace file");
+        if (m_header.m_version != trace_file_header::current_version)
+            throw std::runtime_error(path + " has an unsupported version");
+        m_records.resize(m_header.m_num_records);
+        in.read(reinterpret_cast<char*>(m_records.data()),
+            m_records.size() * sizeof(trace_record));
+        if (!in) throw std::runtime_error(path + " is truncated");
+    }
+
+    // global clock time in ns
+    double time_ns(trace_record const& r) const noexcept
+    {
+        return m_header.m_time_base_ns +
+               (double(r.m_time) - double(m_header.m_tick_base)) / m_header.m_ticks_per_ns;
+    }
+};
+
+char const*
+slice_name(trace_event e)
+{
+    switch (e)
+    {
+    case trace_event::callback_begin:
+    case trace_event::callback_end: return "callback";
+    case trace_event::progress_begin:
+    case trace_event::progress_end: return "progress";
+    case trace_event::lock_wait_begin:
+    case trace_event::lock_wait_end: return "lock wait";
+    default: return "";
+    }
+}
+
+class json_writer
+{
+    std::ostream& m_out;
+    bool          m_first = true;
+
+  public:
+    json_writer(std::ostream& out)
+    : m_out{out}
+    {
+        m_out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    }
+
+    ~json_writer() { m_out << "\n]}\n"; }
+
+    // starts a new event, the caller completes it with the remaining fields and the closing brace
+    std::ostream& event(char const* name, char const* ph, int pid, std::uint32_t tid, double ts_us)
+    {
+        if (!m_first) m_out << ",\n";
+        m_first = false;
+        char ts[32];
+        std::snprintf(ts, sizeof(ts), "%.3f", ts_us);
+        m_out << "{\"name\":\"" << name << "\",\"ph\":\"" << ph << "\",\"pid\":" << pid
+              << ",\"tid\":" << tid << ",\"ts\":" << ts;
+        return m_out;
+    }
+};
+
+void
+convert(std::vector<trace_file> const& files, std::ostream& out)
+{
+    double origin = 0;
+    bool   first = true;
+    for (auto const& f : files)
+    {
+        if (first || f.m_header.m_time_base_ns < origin) origin = f.m_header.m_time_base_ns;
+        first = false;
+    }
+
+    json_writer w(out);
+    for (auto const& f : files)
+    {
+        auto const pid = f.m_header.m_rank;
+        w.event("process_name", "M", pid, 0, 0)
+            << ",\"args\":{\"name\":\"rank " << pid << " (1 of " << f.m_header.m_sample
+            << " messages traced, " << f.m_header.m_dropped << " events dropped)\"}}";
+
+        // message kind by (communicator, id), needed to name the end of the async slices
+        std::map<std::pair<std::uint32_t, std::uint32_t>, char const*> kinds;
+        std::set<std::uint32_t>                                        comms;
+        for (auto const& r : f.m_records)
+        {
+            auto const tid = r.m_comm;
+            auto const ts = (f.time_ns(r) - origin) / 1000.0;
+            auto const key = std::make_pair(tid, r.m_id);
+            if (comms.insert(tid).second)
+                w.event("thread_name", "M", pid, tid, 0)
+                    << ",\"args\":{\"name\":\"communicator " << tid << "\"}}";
+            switch (r.m_event)
+            {
+            case trace_event::post_send:
+            case trace_event::post_recv:
+            {
+                auto const name = r.m_event == trace_event::post_send ? "send" : "recv";
+                kinds[key] = name;
+                w.event(name, "b", pid, tid, ts)
+                    << ",\"cat\":\"message\",\"id2\":{\"local\":\"" << tid << "." << r.m_id
+                    << "\"},\"args\":{\"peer\":" << r.m_peer << ",\"tag\":" << r.m_tag
+                    << ",\"bytes\":" << r.m_bytes << "}}";
+                break;
+            }
+            case trace_event::inject:
+            case trace_event::complete:
+            {
+                auto it = kinds.find(key);
+                if (it == kinds.end()) break; // post was dropped
+                bool const end = r.m_event == trace_event::complete;
+                w.event(end ? it->second : "inject", end ? "e" : "n", pid, tid, ts)
+                    << ",\"cat\":\"message\",\"id2\":{\"local\":\"" << tid << "." << r.m_id
+                    << "\"}}";
+                if (end) kinds.erase(it);
+                break;
+            }
+            case trace_event::callback_begin:
+            case trace_event::progress_begin:
+            case trace_event::lock_wait_begin:
+                w.event(slice_name(r.m_event), "B", pid, tid, ts) << "}";
+                break;
+            case trace_event::callback_end:
+            case trace_event::progress_end:
+            case trace_event::lock_wait_end:
+                w.event(slice_name(r.m_event), "E", pid, tid, ts) << "}";
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    std::string              output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+        else
+            inputs.push_back(argv[i]);
+    }
+    if (inputs.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [-o output.json] trace.0.bin [trace.1.bin ...]"
+                  << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::vector<trace_file> files;
+        for (auto const& p : inputs) files.emplace_back(p);
+        if (output.empty()) convert(files, std::cout);
+        else
+        {
+            std::ofstream out(output);
+            if (!out) throw std::runtime_error("cannot open " + output);
+            convert(files, out);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
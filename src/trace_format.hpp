@@ -0,0 +1,65 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of trace files: a header followed by fixed-size records. Shared by the tracer and
+// the oomph_trace2json converter.
+
+namespace oomph
+{
+enum class trace_event : std::uint8_t
+{
+    post_send,       // send posted by the user
+    post_recv,       // receive posted by the user
+    inject,          // operation handed to the transport
+    complete,        // completion detected by the transport
+    callback_begin,  // completion handler invoked
+    callback_end,    // completion handler returned
+    progress_begin,  // communicator progress
+    progress_end,    //
+    lock_wait_begin, // waiting for a contended transport lock
+    lock_wait_end    //
+};
+
+struct trace_record
+{
+    std::uint64_t m_time;  // raw ticks, see trace_file_header
+    std::uint64_t m_bytes; // message size for post events
+    std::int32_t  m_peer;  // peer rank for post events
+    std::int32_t  m_tag;   // tag for post events
+    std::uint32_t m_id;    // message id, unique per communicator (0 if not a message event)
+    std::uint32_t m_comm;  // communicator id, unique per context
+    trace_event   m_event;
+    std::uint8_t  m_reserved[7];
+};
+static_assert(sizeof(trace_record) == 40, "unexpected trace record size");
+
+struct trace_file_header
+{
+    static constexpr char          magic[8] = {'O', 'O', 'M', 'P', 'H', 'T', 'R', 'C'};
+    static constexpr std::uint32_t current_version = 2;
+
+    char          m_magic[8];
+    std::uint32_t m_version;
+    std::int32_t  m_rank;
+    std::uint64_t m_num_records;
+    std::uint64_t m_dropped;      // records lost because a ring buffer was full
+    std::uint64_t m_tick_base;    // raw ticks at m_time_base_ns
+    std::uint64_t m_time_base_ns; // global clock at m_tick_base, see context::global_time
+    double        m_ticks_per_ns;
+    std::uint32_t m_sample;       // 1 of m_sample messages is traced
+    std::uint32_t m_reserved;
+};
+static_assert(sizeof(trace_file_header) == 64, "unexpected trace file header size");
+
+} // namespace oomph
@@ -0,0 +1,359 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include "./trace_format.hpp"
+#include "./env.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace oomph
+{
+// raw timestamps: the time stamp counter where available, the steady clock otherwise
+struct trace_clock
+{
+    static std::uint64_t steady_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static std::uint64_t now() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return steady_ns();
+#endif
+    }
+};
+
+// Single-producer single-consumer ring of trace records: the owning thread of a communicator
+// pushes, the flusher thread of the tracer drains. Records are dropped (and counted) when the
+// ring is full, the producer never waits.
+class trace_ring
+{
+  private:
+    std::vector<trace_record>              m_records;
+    std::uint64_t const                    m_mask;
+    std::uint32_t const                    m_id;
+    std::uint32_t const                    m_sample;
+    std::uint32_t                          m_message_countdown = 1;
+    std::uint32_t                          m_progress_countdown = 1;
+    std::uint32_t                          m_last_id = 0;
+    std::uint64_t                          m_cached_tail = 0; // producer's view of m_tail
+    alignas(64) std::atomic<std::uint64_t> m_head{0};         // written by the producer
+    alignas(64) std::atomic<std::uint64_t> m_tail{0};         // written by the consumer
+    std::atomic<std::uint64_t>             m_dropped{0};
+
+  public:
+    // capacity must be a power of 2
+    trace_ring(std::size_t capacity, std::uint32_t id, std::uint32_t sample)
+    : m_records(capacity)
+    , m_mask{capacity - 1}
+    , m_id{id}
+    , m_sample{sample}
+    {
+    }
+
+    trace_ring(trace_ring const&) = delete;
+    trace_ring& operator=(trace_ring const&) = delete;
+
+    // returns a non-zero message id if the next message is traced
+    std::uint32_t sample_message() noexcept
+    {
+        if (--m_message_countdown) return 0;
+        m_message_countdown = m_sample;
+        if (++m_last_id == 0) ++m_last_id;
+        return m_last_id;
+    }
+
+    bool sample_progress() noexcept
+    {
+        if (--m_progress_countdown) return false;
+        m_progress_countdown = m_sample;
+        return true;
+    }
+
+    void push(trace_event e, std::uint32_t id, std::int32_t peer = 0, std::int32_t tag = 0,
+        std::uint64_t bytes = 0) noexcept
+    {
+        auto const head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cached_tail > m_mask)
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cached_tail > m_mask)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        m_records[head & m_mask] =
+            trace_record{trace_clock::now(), bytes, peer, tag, id, m_id, e, {}};
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+    // consumer: passes the available records to f in at most two contiguous pieces
+    template<typename F>
+    std::size_t drain(F&& f)
+    {
+        auto const tail = m_tail.load(std::memory_order_relaxed);
+        auto const head = m_head.load(std::memory_order_acquire);
+        if (head == tail) return 0;
+        auto const n = head - tail;
+        auto const first = tail & m_mask;
+        auto const n0 = std::min<std::uint64_t>(n, m_records.size() - first);
+        f(m_records.data() + first, n0);
+        if (n0 < n) f(m_records.data(), n - n0);
+        m_tail.store(head, std::memory_order_release);
+        return n;
+    }
+};
+
+// Streams records into a file through a sliding memory-mapped window. The header is written when
+// the file is closed.
+class trace_writer
+{
+  private:
+    static constexpr std::size_t window_size = 4u << 20;
+
+    int         m_fd;
+    char*       m_window = nullptr;
+    std::size_t m_window_offset = 0;
+    std::size_t m_size = sizeof(trace_file_header); // file offset of the next record
+    bool        m_failed = false;
+
+  public:
+    trace_writer(std::string const& path)
+    : m_fd{::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)}
+    {
+        if (m_fd < 0) throw std::runtime_error("oomph: cannot open trace file " + path);
+        map(0);
+    }
+
+    trace_writer(trace_writer const&) = delete;
+    trace_writer& operator=(trace_writer const&) = delete;
+
+    ~trace_writer()
+    {
+        if (m_window) ::munmap(m_window, window_size);
+        if (m_fd >= 0) ::close(m_fd);
+    }
+
+    bool failed() const noexcept { return m_failed; }
+
+    void write(void const* data, std::size_t bytes)
+    {
+        auto src = static_cast<char const*>(data);
+        while (bytes && !m_failed)
+        {
+            if (m_size == m_window_offset + window_size)
+            {
+                map(m_size);
+                if (m_failed) return;
+            }
+            auto const n = std::min(bytes, m_window_offset + window_size - m_size);
+            std::memcpy(m_window + (m_size - m_window_offset), src, n);
+            m_size += n;
+            src += n;
+            bytes -= n;
+        }
+    }
+
+    void close(trace_file_header const& h)
+    {
+        if (m_window) ::munmap(m_window, window_size);
+        m_window = nullptr;
+        if (::ftruncate(m_fd, m_size) != 0 ||
+            ::pwrite(m_fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h))
+            m_failed = true;
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+  private:
+    void map(std::size_t offset)
+    {
+        if (m_window) ::munmap(m_window, window_size);
+        m_window = nullptr;
+        if (::ftruncate(m_fd, offset + window_size) != 0)
+        {
+            m_failed = true;
+            return;
+        }
+        void* p = ::mmap(nullptr, window_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+        if (p == MAP_FAILED)
+        {
+            m_failed = true;
+            return;
+        }
+        m_window = static_cast<char*>(p);
+        m_window_offset = offset;
+    }
+};
+
+// Per-context tracer: owns the rings of all communicators and a flusher thread which periodically
+// drains them into the trace file <prefix>.<rank>.bin. Configured through the environment:
+// OOMPH_TRACE_FILE (prefix, tracing is disabled if unset), OOMPH_TRACE_SAMPLE (trace 1 of N
+// messages, default 1) and OOMPH_TRACE_BUFFER (records per communicator, default 64K).
+class tracer
+{
+  private:
+    trace_writer                             m_writer;
+    std::int32_t const                       m_rank;
+    std::uint32_t const                      m_sample;
+    std::size_t const                        m_capacity;
+    std::uint64_t const                      m_tick_base;
+    std::uint64_t const                      m_time_base_ns;
+    std::atomic<std::int64_t>                m_clock_offset{0};
+    std::mutex                               m_mutex;
+    std::vector<std::unique_ptr<trace_ring>> m_rings; // protected by m_mutex
+    std::uint32_t                            m_next_id = 0;
+    std::uint64_t                            m_num_records = 0;
+    std::uint64_t                            m_dropped = 0;
+    std::condition_variable                  m_cv;
+    bool                                     m_stop = false;
+    std::thread                              m_flusher;
+
+  public:
+    static std::unique_ptr<tracer> from_env(int rank)
+    {
+        char const* prefix = std::getenv("OOMPH_TRACE_FILE");
+        if (!prefix || !*prefix) return {};
+        auto const sample = env_size("OOMPH_TRACE_SAMPLE", 1);
+        auto const capacity = env_size("OOMPH_TRACE_BUFFER", 1u << 16);
+        if (sample == 0 || sample > 0xffffffffu)
+            throw std::runtime_error("oomph: invalid value for OOMPH_TRACE_SAMPLE");
+        return std::make_unique<tracer>(std::string(prefix) + "." + std::to_string(rank) + ".bin",
+            rank, sample, capacity);
+    }
+
+    tracer(std::string const& path, int rank, std::size_t sample, std::size_t capacity)
+    : m_writer(path)
+    , m_rank{rank}
+    , m_sample{(std::uint32_t)sample}
+    , m_capacity{round_up_pow2(std::max<std::size_t>(capacity, 64))}
+    , m_tick_base{trace_clock::now()}
+    , m_time_base_ns{trace_clock::steady_ns()}
+    , m_flusher([this]() { flush_loop(); })
+    {
+    }
+
+    tracer(tracer const&) = delete;
+    tracer& operator=(tracer const&) = delete;
+
+    ~tracer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_flusher.join();
+
+        auto const ticks = trace_clock::now();
+        auto const ns = trace_clock::steady_ns();
+        for (auto& r : m_rings) flush(*r);
+
+        trace_file_header h;
+        std::memcpy(h.m_magic, trace_file_header::magic, sizeof(h.m_magic));
+        h.m_version = trace_file_header::current_version;
+        h.m_rank = m_rank;
+        h.m_num_records = m_num_records;
+        h.m_dropped = m_dropped;
+        h.m_tick_base = m_tick_base;
+        h.m_time_base_ns = m_time_base_ns + m_clock_offset.load();
+        h.m_ticks_per_ns =
+            ns > m_time_base_ns ? double(ticks - m_tick_base) / double(ns - m_time_base_ns) : 1.0;
+        h.m_sample = m_sample;
+        h.m_reserved = 0;
+        m_writer.close(h);
+        if (m_writer.failed())
+            std::cerr << "oomph warning: failed to write trace file of rank " << m_rank
+                      << std::endl;
+    }
+
+    std::uint64_t time_base() const noexcept { return m_time_base_ns; }
+
+    // offset of the global clock to the steady clock at the time base, see clock_sync
+    void set_clock_offset(std::int64_t ns) noexcept { m_clock_offset.store(ns); }
+
+    trace_ring* make_ring()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rings.push_back(std::make_unique<trace_ring>(m_capacity, m_next_id++, m_sample));
+        return m_rings.back().get();
+    }
+
+    // the remaining records are flushed before the ring is destroyed
+    void release(trace_ring* r)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        flush(*r);
+        m_rings.erase(std::find_if(m_rings.begin(), m_rings.end(),
+            [r](auto const& p) { return p.get() == r; }));
+    }
+
+  private:
+    static std::size_t round_up_pow2(std::size_t n)
+    {
+        std::size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // called with m_mutex held
+    void drain(trace_ring& r)
+    {
+        m_num_records += r.drain(
+            [this](trace_record const* data, std::size_t n)
+            { m_writer.write(data, n * sizeof(trace_record)); });
+    }
+
+    // called with m_mutex held, once per ring
+    void flush(trace_ring& r)
+    {
+        drain(r);
+        m_dropped += r.dropped();
+    }
+
+    void flush_loop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop)
+        {
+            m_cv.wait_for(lock, std::chrono::milliseconds(10));
+            for (auto& r : m_rings) drain(*r);
+        }
+    }
+};
+
+} // namespace oomph
@@ -0,0 +1,189 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/util/mpi_error.hpp>
+#include <oomph/util/mpi_comm_holder.hpp>
+#include "./rank_topology.hpp"
+#include "./env.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace oomph
+{
+// Run-time parameters of a context. By default they are read from the environment. With
+// OOMPH_TUNE=1 they are selected by a short measurement when the context is created, and stored in
+// the profile <OOMPH_TUNE_DIR>/oomph_tuning.<backend>.<host>.txt (host of rank 0, OOMPH_TUNE_DIR
+// defaults to the working directory), which later runs read instead of measuring again. Variables
+// set explicitly in the environment take precedence over tuned values.
+struct tuning
+{
+    // blocking waits yield the core after this many progress calls, 0 never yields
+    // (OOMPH_PROGRESS_SPIN)
+    std::size_t m_progress_spin = 0;
+    // size of the callback thread pool (OOMPH_CALLBACK_THREADS)
+    std::size_t m_callback_threads = 2;
+
+    // collective: OOMPH_TUNE must be set alike on all ranks
+    static tuning from_env(MPI_Comm comm, rank_topology const& topo, char const* backend)
+    {
+        tuning t;
+        if (env_size("OOMPH_TUNE", 0))
+        {
+            int rank;
+            OOMPH_CHECK_MPI_RESULT(MPI_Comm_rank(comm, &rank));
+            std::string const path = profile_path(backend);
+            // found, progress spin, callback threads
+            std::uint64_t p[3] = {0, 0, 0};
+            if (rank == 0) p[0] = t.read(path);
+            p[1] = t.m_progress_spin;
+            p[2] = t.m_callback_threads;
+            OOMPH_CHECK_MPI_RESULT(MPI_Bcast(p, 3, MPI_UINT64_T, 0, comm));
+            t.m_progress_spin = p[1];
+            t.m_callback_threads = p[2];
+            if (!p[0])
+            {
+                t.measure(comm, topo);
+                if (rank == 0) t.write(path);
+            }
+        }
+        t.m_progress_spin = env_size("OOMPH_PROGRESS_SPIN", t.m_progress_spin);
+        t.m_callback_threads = env_size("OOMPH_CALLBACK_THREADS", t.m_callback_threads);
+        return t;
+    }
+
+  private:
+    static std::string profile_path(char const* backend)
+    {
+        char const* dir = std::getenv("OOMPH_TUNE_DIR");
+        char        host[256] = {};
+        gethostname(host, sizeof(host) - 1);
+        return std::string(dir && *dir ? dir : ".") + "/oomph_tuning." + backend + "." + host +
+               ".txt";
+    }
+
+    // returns whether the profile was found and complete
+    bool read(std::string const& path)
+    {
+        std::ifstream is(path);
+        std::string   key;
+        std::size_t   value;
+        int           found = 0;
+        while (is >> key >> value)
+        {
+            if (key == "progress_spin")
+            {
+                m_progress_spin = value;
+                found |= 1;
+            }
+            else if (key == "callback_threads")
+            {
+                m_callback_threads = value;
+                found |= 2;
+            }
+        }
+        return found == 3;
+    }
+
+    void write(std::string const& path) const
+    {
+        std::ofstream os(path);
+        os << "progress_spin " << m_progress_spin << "\n";
+        os << "callback_threads " << m_callback_threads << "\n";
+        if (!os) std::cerr << "oomph warning: failed to write tuning profile " << path << std::endl;
+    }
+
+    // collective
+    void measure(MPI_Comm c, rank_topology const& topo)
+    {
+        util::mpi_comm_holder comm(c);
+        int                   rank, size;
+        OOMPH_CHECK_MPI_RESULT(MPI_Comm_rank(comm.get(), &rank));
+        OOMPH_CHECK_MPI_RESULT(MPI_Comm_size(comm.get(), &size));
+
+        // local sample: ring among the ranks of a node, remote sample: shift by the smallest node
+        // size
+        std::vector<int> local(topo.local_ranks().begin(), topo.local_ranks().end());
+        std::sort(local.begin(), local.end());
+        auto const l = std::find(local.begin(), local.end(), rank) - local.begin();
+        int const  n = local.size();
+        int        shift = n;
+        OOMPH_CHECK_MPI_RESULT(
+            MPI_Allreduce(MPI_IN_PLACE, &shift, 1, MPI_INT, MPI_MIN, comm.get()));
+
+        static constexpr std::size_t candidates[] = {0, 1, 16, 256};
+        double                       best = 0;
+        for (auto spin : candidates)
+        {
+            double t = 0;
+            if (n > 1)
+                t += exchange(comm.get(), local[(l + 1) % n], local[(l + n - 1) % n], 0, spin);
+            if (shift < size)
+                t += exchange(comm.get(), (rank + shift) % size, (rank + size - shift) % size, 1,
+                    spin);
+            OOMPH_CHECK_MPI_RESULT(
+                MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, comm.get()));
+            if (spin == candidates[0] || t < best)
+            {
+                best = t;
+                m_progress_spin = spin;
+            }
+        }
+
+        // not measured: leave a core per rank to the application thread
+        std::size_t const cores = std::thread::hardware_concurrency() / std::max(n, 1);
+        m_callback_threads = std::clamp<std::size_t>(cores > 1 ? cores - 1 : 1, 1, 4);
+    }
+
+    // median time of a small message exchange with the given peers, waiting like a blocking wait
+    // with the given spin count
+    static double exchange(MPI_Comm comm, int dst, int src, int tag, std::size_t spin)
+    {
+        static constexpr int iterations = 21;
+        std::uint64_t        sbuf = 0, rbuf;
+        std::vector<double>  times;
+        OOMPH_CHECK_MPI_RESULT(MPI_Barrier(comm));
+        for (int i = 0; i < iterations; ++i)
+        {
+            auto const  start = std::chrono::steady_clock::now();
+            MPI_Request reqs[2];
+            OOMPH_CHECK_MPI_RESULT(MPI_Irecv(&rbuf, 1, MPI_UINT64_T, src, tag, comm, &reqs[0]));
+            OOMPH_CHECK_MPI_RESULT(MPI_Isend(&sbuf, 1, MPI_UINT64_T, dst, tag, comm, &reqs[1]));
+            int         done = 0;
+            std::size_t count = 0;
+            while (true)
+            {
+                OOMPH_CHECK_MPI_RESULT(MPI_Testall(2, reqs, &done, MPI_STATUSES_IGNORE));
+                if (done) break;
+                if (spin && ++count == spin)
+                {
+                    count = 0;
+                    sched_yield();
+                }
+            }
+            times.push_back(
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::nth_element(times.begin(), times.begin() + iterations / 2, times.end());
+        return times[iterations / 2];
+    }
+};
+
+} // namespace oomph
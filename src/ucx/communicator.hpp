@@ -16,7 +16,8 @@
 #include "./context.hpp"
 #include "../communicator_base.hpp"
 #include "../device_guard.hpp"
-#include <boost/lockfree/queue.hpp>
+#include "../iov.hpp"
+#include <boost/pool/pool.hpp>
 
 namespace oomph
 {
@@ -32,18 +33,21 @@ class communicator_impl : public communicator_base<communicator_impl>
     using worker_type = worker_t;
     using rank_type = communicator::rank_type;
     using tag_type = communicator::tag_type;
-    using lockfree_queue = boost::lockfree::queue<request_data::cb_ptr_t,
-        boost::lockfree::fixed_sized<false>, boost::lockfree::allocator<std::allocator<void>>>;
+    using cb_type = util::unique_function<void()>;
+    using lockfree_queue = completion_lockfree_queue;
+    using iov_type = iov_vector<context_impl::heap_type::pointer>;
 
   public:
-    context_impl*                       m_context;
-    bool const                          m_thread_safe;
-    worker_type*                        m_recv_worker;
-    worker_type*                        m_send_worker;
-    ucx_mutex&                          m_mutex;
-    lockfree_queue                      m_recv_cb_queue;
-    lockfree_queue                      m_cancel_recv_cb_queue;
-    std::vector<request_data::cb_ptr_t> m_cancel_recv_cb_vec;
+    context_impl*                            m_context;
+    bool const                               m_thread_safe;
+    worker_type*                             m_recv_worker;
+    worker_type*                             m_send_worker;
+    ucx_mutex&                               m_mutex;
+    lockfree_queue                           m_recv_cb_queue;
+    lockfree_queue                           m_cancel_recv_cb_queue;
+    charged_vector<request_data::completion> m_cancel_recv_cb_vec;
+    boost::pool<>                            m_cb_pool;
+    memory_charge                            m_cb_pool_memory;
 
   public:
     communicator_impl(context_impl* ctxt, bool thread_safe, worker_type* recv_worker,
@@ -56,6 +60,9 @@ class communicator_impl : public communicator_base<communicator_impl>
     , m_mutex{mtx}
     , m_recv_cb_queue(128)
     , m_cancel_recv_cb_queue(128)
+    , m_cancel_recv_cb_vec(ctxt->get_memory().queue_allocator())
+    , m_cb_pool{sizeof(cb_type), detail::request_pool_start_size}
+    , m_cb_pool_memory{ctxt->get_memory().charge_queues()}
     {
     }
 
@@ -70,10 +77,76 @@ class communicator_impl : public communicator_base<communicator_impl>
     }
 
     auto& get_heap() noexcept { return m_context->get_heap(); }
+    auto& get_registration_cache() noexcept { return m_context->get_registration_cache(); }
+
+    // Callbacks of scheduled operations are kept in pooled storage. They are created and destroyed
+    // by the thread owning this communicator only: completions of receives finished by other
+    // threads are passed back through m_recv_cb_queue.
+    request_data::cb_ptr_t make_cb(cb_type&& cb)
+    {
+        // the memory of the pool is charged to the queues when it allocates a chunk, that of the
+        // lock-free queues (a node per element) is not accounted for
+        auto const next = m_cb_pool.get_next_size();
+        auto const p = m_cb_pool.malloc();
+        if (m_cb_pool.get_next_size() != next) m_cb_pool_memory.resize(pool_bytes(m_cb_pool));
+        return ::new (p) cb_type(std::move(cb));
+    }
+
+    void free_cb(request_data::cb_ptr_t cb)
+    {
+        cb->~cb_type();
+        m_cb_pool.free(cb);
+    }
+
+    // completion of an operation: called by the owning thread only. A failed receive is reported
+    // by an exception, unless it was posted to the completion queue, which records the failure.
+    void complete(request_data::completion const& c)
+    {
+        bool const failed = c.m_status == completion_status::error;
+        if (failed && !report_completions()) throw_recv_error();
+        if (c.m_send) on_send_completion(c.m_peer, c.m_post);
+        else
+            on_recv_completion(c.m_peer, c.m_post);
+        if (c.m_cb)
+        {
+            detail::transport_completion const t{c.m_peer, c.m_bytes, c.m_status};
+            auto const reported = run_completion_handler(*c.m_cb, c.m_send ? nullptr : &t);
+            free_cb(c.m_cb);
+            if (failed && !reported) throw_recv_error();
+        }
+        else
+        {
+            if (c.m_state) c.m_state->set_ready();
+            --(*c.m_scheduled);
+            // drop the reference to the request state held by the operation
+            communicator::shared_request_ptr h{c.m_state};
+            if (failed) throw_recv_error();
+        }
+    }
+
+    [[noreturn]] static void throw_recv_error()
+    {
+        throw std::runtime_error("oomph: ucx error - recv message truncated");
+    }
+
+    request_data::completion make_completion(util::unique_function<void()>&& cb)
+    {
+        return {make_cb(std::move(cb)), nullptr, nullptr};
+    }
+
+    // the operation holds a reference to the request state until it completes
+    request_data::completion make_completion(std::size_t* scheduled,
+        communicator::shared_request_ptr&& req)
+    {
+        return {nullptr, req.release(), scheduled};
+    }
 
     void progress()
     {
-        while (ucp_worker_progress(m_send_worker->get())) {}
+        [[maybe_unused]] auto const t = trace_progress();
+        [[maybe_unused]] auto const r = record_progress();
+        std::size_t                 n = 0;
+        while (ucp_worker_progress(m_send_worker->get())) ++n;
         if (m_thread_safe)
         {
 #ifdef OOMPH_UCX_USE_SPIN_LOCK
@@ -82,48 +155,77 @@ class communicator_impl : public communicator_base<communicator_impl>
 #endif
             {
                 // progress recv worker in locked region
-                ucx_lock lock(m_mutex);
-                while (ucp_worker_progress(m_recv_worker->get())) {}
+                lock(m_mutex);
+                ucx_lock lock(m_mutex, std::adopt_lock);
+                while (ucp_worker_progress(m_recv_worker->get())) ++n;
             }
         }
         else
         {
-            while (ucp_worker_progress(m_recv_worker->get())) {}
+            while (ucp_worker_progress(m_recv_worker->get())) ++n;
         }
-        // work through ready recv callbacks, which were pushed to the queue by other threads
+        // work through ready recv completions, which were pushed to the queue by other threads
         // (including this thread)
         if (m_thread_safe)
-            m_recv_cb_queue.consume_all([](request_data::cb_ptr_t cb) {
-                cb->invoke();
-                delete cb;
-            });
+            n += m_recv_cb_queue.consume_all(
+                [this](request_data::completion const& c) { complete(c); });
+        // requests whose callbacks were run by the thread pool
+        n += m_executor.progress();
+        on_progress(n);
+    }
+
+    void send(context_impl::heap_type::pointer const& ptr, std::size_t offset, std::size_t size,
+        rank_type dst, tag_type tag, util::unique_function<void()>&& cb,
+        communicator::shared_request_ptr&& req)
+    {
+        // device is set according to message memory: needed?
+        const_device_guard dg(ptr);
+        send_nb(static_cast<char const*>(dg.data()) + offset, size, ucp_dt_make_contig(1), dst,
+            tag, make_completion(std::move(cb)), req.get());
+    }
+
+    void send(context_impl::heap_type::pointer const& ptr, std::size_t offset, std::size_t size,
+        rank_type dst, tag_type tag, std::size_t* scheduled, communicator::shared_request_ptr&& req)
+    {
+        const_device_guard dg(ptr);
+        auto const         r = req.get();
+        send_nb(static_cast<char const*>(dg.data()) + offset, size, ucp_dt_make_contig(1), dst,
+            tag, make_completion(scheduled, std::move(req)), r);
+    }
+
+    void send_iov(iov_type const& iov, rank_type dst, tag_type tag,
+        util::unique_function<void()>&& cb, communicator::shared_request_ptr&& req)
+    {
+        // the iov array must stay alive until the operation completes: it is owned by the callback
+        auto dt_iov = make_dt_iov(iov);
+        auto buffer = dt_iov.data();
+        auto count = dt_iov.size();
+        send_nb(buffer, count, ucp_dt_make_iov(), dst, tag,
+            make_completion([dt_iov = std::move(dt_iov), cb = std::move(cb)]() mutable { cb(); }),
+            req.get());
     }
 
-    void send(context_impl::heap_type::pointer const& ptr, std::size_t size, rank_type dst,
-        tag_type tag, util::unique_function<void()>&& cb, communicator::shared_request_ptr&& req)
+    void send_nb(void const* buffer, std::size_t count, ucp_datatype_t datatype, rank_type dst,
+        tag_type tag, request_data::completion c, detail::request_state* req)
     {
+        c.m_peer = dst;
+        c.m_send = true;
+        c.m_post = post_time();
         const auto& ep = m_send_worker->connect(dst);
         const auto  stag =
             ((std::uint_fast64_t)tag << OOMPH_UCX_TAG_BITS) | (std::uint_fast64_t)(rank());
 
-        ucs_status_ptr_t ret;
-        {
-            // device is set according to message memory: needed?
-            const_device_guard dg(ptr);
-
-            ret = ucp_tag_send_nb(ep.get(),         // destination
-                dg.data(),                          // buffer
-                size,                               // buffer size
-                ucp_dt_make_contig(1),              // data type
-                stag,                               // tag
-                &communicator_impl::send_callback); // callback function pointer
-        }
+        ucs_status_ptr_t ret = ucp_tag_send_nb(ep.get(), // destination
+            buffer,                                      // buffer
+            count,                                       // buffer size or number of iov elements
+            datatype,                                    // data type
+            stag,                                        // tag
+            &communicator_impl::send_callback);          // callback function pointer
 
         if (reinterpret_cast<std::uintptr_t>(ret) == UCS_OK)
         {
             // send operation is completed immediately
-            // call the callback
-            cb();
+            complete(c);
             // request is freed by ucx internally
         }
         else if (!UCS_PTR_IS_ERR(ret))
@@ -133,8 +235,8 @@ class communicator_impl : public communicator_base<communicator_impl>
             auto& req_data = request_data::get(ret);
             //req_data.m_ucx_ptr = ret; // probably not needed since set with request_init
             req_data.m_comm = this;
-            req_data.m_cb = cb.release();
-            req->m_data = &req_data;
+            req_data.m_completion = c;
+            if (req) req->m_data = &req_data;
         }
         else
         {
@@ -143,9 +245,41 @@ class communicator_impl : public communicator_base<communicator_impl>
         }
     }
 
-    void recv(context_impl::heap_type::pointer& ptr, std::size_t size, rank_type src, tag_type tag,
+    void recv(context_impl::heap_type::pointer& ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag, util::unique_function<void()>&& cb,
+        communicator::shared_request_ptr&& req)
+    {
+        // device is set according to message memory: needed?
+        device_guard dg(ptr);
+        recv_nb(static_cast<char*>(dg.data()) + offset, size, ucp_dt_make_contig(1), src, tag,
+            make_completion(std::move(cb)), req.get());
+    }
+
+    void recv(context_impl::heap_type::pointer& ptr, std::size_t offset, std::size_t size,
+        rank_type src, tag_type tag, std::size_t* scheduled, communicator::shared_request_ptr&& req)
+    {
+        device_guard dg(ptr);
+        auto const   r = req.get();
+        recv_nb(static_cast<char*>(dg.data()) + offset, size, ucp_dt_make_contig(1), src, tag,
+            make_completion(scheduled, std::move(req)), r);
+    }
+
+    void recv_iov(iov_type const& iov, rank_type src, tag_type tag,
         util::unique_function<void()>&& cb, communicator::shared_request_ptr&& req)
     {
+        auto dt_iov = make_dt_iov(iov);
+        auto buffer = dt_iov.data();
+        auto count = dt_iov.size();
+        recv_nb(buffer, count, ucp_dt_make_iov(), src, tag,
+            make_completion([dt_iov = std::move(dt_iov), cb = std::move(cb)]() mutable { cb(); }),
+            req.get());
+    }
+
+    void recv_nb(void* buffer, std::size_t count, ucp_datatype_t datatype, rank_type src,
+        tag_type tag, request_data::completion c, detail::request_state* req)
+    {
+        c.m_peer = src;
+        c.m_post = post_time();
         const auto rtag =
             (communicator::any_source == src)
                 ? ((std::uint_fast64_t)tag << OOMPH_UCX_TAG_BITS)
@@ -155,33 +289,29 @@ class communicator_impl : public communicator_base<communicator_impl>
                                    ? (OOMPH_UCX_TAG_MASK | OOMPH_UCX_ANY_SOURCE_MASK)
                                    : (OOMPH_UCX_TAG_MASK | OOMPH_UCX_SPECIFIC_SOURCE_MASK);
 
-        // pointer to store callback in case of early completion
-        request_data::cb_ptr_t cb_ptr = nullptr;
+        // the completion is handled outside the locked region in case of early completion
+        bool early_completed = false;
         {
             // locked region
-            if (m_thread_safe) m_mutex.lock();
+            if (m_thread_safe) lock(m_mutex);
 
-            ucs_status_ptr_t ret;
-            {
-                // device is set according to message memory: needed?
-                device_guard dg(ptr);
-
-                ret = ucp_tag_recv_nb(m_recv_worker->get(), // worker
-                    dg.data(),                              // buffer
-                    size,                                   // buffer size
-                    ucp_dt_make_contig(1),                  // data type
-                    rtag,                                   // tag
-                    rtag_mask,                              // tag mask
-                    &communicator_impl::recv_callback);     // callback function pointer
-            }
+            ucs_status_ptr_t ret = ucp_tag_recv_nb(m_recv_worker->get(), // worker
+                buffer,                                               // buffer
+                count,                              // buffer size or number of iov elements
+                datatype,                           // data type
+                rtag,                               // tag
+                rtag_mask,                          // tag mask
+                &communicator_impl::recv_callback); // callback function pointer
 
             if (!UCS_PTR_IS_ERR(ret))
             {
-                if (UCS_INPROGRESS != ucp_request_check_status(ret))
+                ucp_tag_recv_info_t info;
+                auto const          status = ucp_tag_recv_request_test(ret, &info);
+                if (UCS_INPROGRESS != status)
                 {
                     // early completed
-                    // store callback for later: will be called outside locked region
-                    cb_ptr = cb.release();
+                    early_completed = true;
+                    set_received(c, status, &info);
                     // destroy request
                     request_data::get(ret).clear();
                     ucp_request_free(ret);
@@ -193,8 +323,8 @@ class communicator_impl : public communicator_base<communicator_impl>
                     auto& req_data = request_data::get(ret);
                     //req_data.m_ucx_ptr = ret; // probably not needed since set with request_init
                     req_data.m_comm = this;
-                    req_data.m_cb = cb.release();
-                    req->m_data = &req_data;
+                    req_data.m_completion = c;
+                    if (req) req->m_data = &req_data;
                 }
             }
             else
@@ -206,11 +336,19 @@ class communicator_impl : public communicator_base<communicator_impl>
             if (m_thread_safe) m_mutex.unlock();
         }
         // check for early completion
-        if (cb_ptr)
+        if (early_completed) complete(c);
+    }
+
+    std::vector<ucp_dt_iov_t> make_dt_iov(iov_type const& iov)
+    {
+        std::vector<ucp_dt_iov_t> dt_iov(iov.size());
+        for (std::size_t i = 0; i < iov.size(); ++i)
         {
-            cb_ptr->invoke();
-            delete cb_ptr;
+            device_guard dg(*iov[i].m_ptr);
+            dt_iov[i].buffer = static_cast<char*>(dg.data()) + iov[i].m_offset;
+            dt_iov[i].length = iov[i].m_size;
         }
+        return dt_iov;
     }
 
     inline static void send_callback(void* ucx_req, ucs_status_t status)
@@ -218,9 +356,8 @@ class communicator_impl : public communicator_base<communicator_impl>
         auto& req_data = request_data::get(ucx_req);
         if (status == UCS_OK)
         {
-            // invoke callback
-            req_data.m_cb->invoke();
-            delete req_data.m_cb;
+            // invoke callback or complete request
+            req_data.m_comm->complete(req_data.m_completion);
         }
         // else: cancelled - do nothing - cancel for sends does not exist
 
@@ -229,50 +366,57 @@ class communicator_impl : public communicator_base<communicator_impl>
         ucp_request_free(ucx_req);
     }
 
-    void enqueue_recv(request_data::cb_ptr_t cb)
+    void enqueue_recv(request_data::completion const& c)
     {
-        while (!m_recv_cb_queue.push(cb)) {}
+        while (!m_recv_cb_queue.push(c)) {}
     }
 
-    void enqueue_cancel_recv(request_data::cb_ptr_t cb)
+    void enqueue_cancel_recv(request_data::completion const& c)
     {
-        while (!m_cancel_recv_cb_queue.push(cb)) {}
+        while (!m_cancel_recv_cb_queue.push(c)) {}
     }
 
-    inline static void recv_callback(
-        void* ucx_req, ucs_status_t status, ucp_tag_recv_info_t* /*info*/)
+    // source and length of a completed receive, or its failure
+    static void set_received(request_data::completion& c, ucs_status_t status,
+        ucp_tag_recv_info_t const* info) noexcept
+    {
+        if (status != UCS_OK)
+        {
+            c.m_status = completion_status::error;
+            return;
+        }
+        c.m_peer = (int)(info->sender_tag & OOMPH_UCX_SPECIFIC_SOURCE_MASK);
+        c.m_bytes = info->length;
+    }
+
+    inline static void recv_callback(void* ucx_req, ucs_status_t status, ucp_tag_recv_info_t* info)
     {
         auto& req_data = request_data::get(ucx_req);
-        if (status == UCS_OK)
+        if (status != UCS_ERR_CANCELED)
         {
             // return if early completion
             // early completion is indicated by missing request data (null pointer)
             if (!req_data.m_comm) return;
+            // errors, e.g. truncation, are reported on completion
+            set_received(req_data.m_completion, status, info);
 
-            // enqueue callback on the issuing communicator
+            // enqueue completion on the issuing communicator
             // this guarantees that only the communicator on which the receive was executed will
-            // invoke the callback
-            if (req_data.m_comm->m_thread_safe) { req_data.m_comm->enqueue_recv(req_data.m_cb); }
+            // invoke the callback or touch the request
+            if (req_data.m_comm->m_thread_safe)
+                req_data.m_comm->enqueue_recv(req_data.m_completion);
             else
-            {
-                req_data.m_cb->invoke();
-                delete req_data.m_cb;
-            }
+                req_data.m_comm->complete(req_data.m_completion);
 
             // destroy request
             req_data.clear();
             ucp_request_free(ucx_req);
         }
-        else if (status == UCS_ERR_CANCELED)
-        {
-            // receive was cancelled
-            // enqueue callback on the issuing communicator
-            req_data.m_comm->enqueue_cancel_recv(req_data.m_cb);
-        }
         else
         {
-            // an error occurred
-            throw std::runtime_error("oomph: ucx error - recv message truncated");
+            // receive was cancelled
+            // enqueue completion on the issuing communicator
+            req_data.m_comm->enqueue_cancel_recv(req_data.m_completion);
         }
     }
 
@@ -283,37 +427,42 @@ class communicator_impl : public communicator_base<communicator_impl>
         auto& req_data = request_data::get(req.m_data->m_data);
         {
             // locked region
-            if (m_thread_safe) m_mutex.lock();
+            if (m_thread_safe) lock(m_mutex);
             ucp_request_cancel(m_recv_worker->get(), req_data.m_ucx_ptr);
             if (m_thread_safe) m_mutex.unlock();
         }
         // The ucx callback will still be executed after the cancel. However, the status argument
         // will indicate whether the cancel was successful.
         // Progress the receive worker in order to execute the ucx callback
-        if (m_thread_safe) m_mutex.lock();
+        if (m_thread_safe) lock(m_mutex);
         while (ucp_worker_progress(m_recv_worker->get())) {}
         if (m_thread_safe) m_mutex.unlock();
-        // check whether the cancelled callback was enqueued by consuming all queued cancelled
-        // callbacks and putting them in a temporary vector
+        // check whether the cancelled completion was enqueued by consuming all queued cancelled
+        // completions and putting them in a temporary vector
         bool found = false;
         m_cancel_recv_cb_vec.clear();
         m_cancel_recv_cb_queue.consume_all(
-            [this, cmp = req_data.m_cb, &found](request_data::cb_ptr_t cb) {
-                if (cb == cmp) found = true;
+            [this, cmp = req_data.m_completion, &found](request_data::completion const& c)
+            {
+                if (c.m_cb == cmp.m_cb && c.m_state == cmp.m_state) found = true;
                 else
-                    m_cancel_recv_cb_vec.push_back(cb);
+                    m_cancel_recv_cb_vec.push_back(c);
             });
-        // re-enqueue all callbacks which were not identical with the current callback
-        for (auto x : m_cancel_recv_cb_vec)
+        // re-enqueue all completions which were not identical with the current one
+        for (auto const& x : m_cancel_recv_cb_vec)
             while (!m_cancel_recv_cb_queue.push(x)) {}
 
-        // delete callback here if it was actually cancelled
+        // free callback or drop the reference to the request state if it was actually cancelled
         if (found)
         {
-            delete req_data.m_cb;
+            if (req_data.m_completion.m_cb) free_cb(req_data.m_completion.m_cb);
+            else
+            {
+                communicator::shared_request_ptr h{req_data.m_completion.m_state};
+            }
             // destroy request
             req_data.clear();
-            if (m_thread_safe) m_mutex.lock();
+            if (m_thread_safe) lock(m_mutex);
             ucp_request_free(req_data.m_ucx_ptr);
             if (m_thread_safe) m_mutex.unlock();
         }
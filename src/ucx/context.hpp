@@ -11,12 +11,17 @@
 #pragma once
 
 #include "../context_base.hpp"
+#include "../registration_cache.hpp"
 #include "./config.hpp"
 #include "./rma_context.hpp"
 #include "./region.hpp"
 #include "./worker.hpp"
 #include "./request_data.hpp"
 #include "./address_db.hpp"
+#if defined OOMPH_UCX_USE_MEMORY_HOOKS
+#include <ucm/api/ucm.h>
+#endif
+#include <iostream>
 #include <vector>
 #include <memory>
 
@@ -28,6 +33,7 @@ class context_impl : public context_base
     using region_type = region;
     using device_region_type = region;
     using heap_type = hwmalloc::heap<context_impl>;
+    using registration_cache_type = registration_cache<heap_type>;
     using rank_type = communicator::rank_type;
     using worker_type = worker_t;
 
@@ -44,25 +50,30 @@ class context_impl : public context_base
     type_erased_address_db_t                  m_db;
     ucp_context_h_holder                      m_context;
     heap_type                                 m_heap;
+    registration_cache_type                   m_registration_cache;
     rma_context                               m_rma_context;
     std::size_t                               m_req_size;
     std::unique_ptr<worker_type>              m_worker; // shared, serialized - per rank
     std::vector<std::unique_ptr<worker_type>> m_workers;
+    memory_charge                             m_address_table;
     ucx_mutex                                 m_mutex;
 
     friend struct worker_t;
 
   public: // ctors
     context_impl(MPI_Comm mpi_c, bool thread_safe)
-    : context_base(mpi_c, thread_safe)
+    : context_base(mpi_c, thread_safe, "ucx")
 #if defined OOMPH_UCX_USE_PMI
     , m_db(address_db_pmi(context_base::m_mpi_comm))
 #else
     , m_db(address_db_mpi(context_base::m_mpi_comm))
 #endif
-    , m_heap{this}
-    , m_rma_context()
+    , m_heap{timed_phase("heap", [this]() { return heap_type{this}; })}
+    , m_registration_cache{m_heap}
+    , m_rma_context(m_memory)
     {
+        auto p = phase("ucp_init");
+
         // read run-time context
         ucp_config_t* config_ptr;
         OOMPH_CHECK_UCX_RESULT(ucp_config_read(NULL, NULL, &config_ptr));
@@ -123,15 +134,34 @@ class context_impl : public context_base
         if (this->m_thread_safe && attr.thread_mode != UCS_THREAD_MODE_MULTI)
             throw std::runtime_error("ucx cannot be used with multi-threaded context");
 
+        p.next("worker");
         // make shared worker
         // use single-threaded UCX mode, as per developer advice
         // https://github.com/openucx/ucx/issues/4609
-        m_worker.reset(new worker_type{get(), m_db, UCS_THREAD_MODE_SINGLE});
+        m_worker.reset(new worker_type{get(), m_db, UCS_THREAD_MODE_SINGLE, m_memory});
 
         // intialize database
+        p.next("address_exchange");
         m_db.init(m_worker->address());
+        // estimated: the addresses of all peers are about as large as this one
+        m_address_table = m_memory.charge_addresses(m_db.size() * m_worker->address().size());
 
         m_rma_context.set_ucp_context(m_context.m_context);
+
+        p.next("memory_events");
+
+#if defined OOMPH_UCX_USE_MEMORY_HOOKS
+        // cached registrations of user memory are invalidated when the memory is unmapped
+        if (m_registration_cache.enabled() &&
+            ucm_set_event_handler(UCM_EVENT_VM_UNMAPPED, 1000, &context_impl::vm_unmapped, this) !=
+                UCS_OK)
+        {
+            std::cerr << "oomph warning: UCX memory events are not available, registration cache "
+                         "disabled"
+                      << std::endl;
+            m_registration_cache.disable();
+        }
+#endif
     }
 
     ~context_impl();
@@ -141,26 +171,36 @@ class context_impl : public context_base
 
     ucp_context_h get() const noexcept { return m_context.m_context; }
 
-    region make_region(void* ptr) { return {ptr}; }
+    region make_region(void* ptr, memory_charge&& charge) { return {ptr, std::move(charge)}; }
 
     auto& get_heap() noexcept { return m_heap; }
+    auto& get_registration_cache() noexcept { return m_registration_cache; }
 
     communicator_impl* get_communicator();
+
+#if defined OOMPH_UCX_USE_MEMORY_HOOKS
+  private:
+    static void vm_unmapped(ucm_event_type_t, ucm_event_t* event, void* arg)
+    {
+        static_cast<context_impl*>(arg)->m_registration_cache.defer_invalidate(
+            event->vm_unmapped.address, event->vm_unmapped.size);
+    }
+#endif
 };
 
 template<>
 region
-register_memory<context_impl>(context_impl& c, void* ptr, std::size_t)
+register_memory<context_impl>(context_impl& c, void* ptr, std::size_t size)
 {
-    return c.make_region(ptr);
+    return c.make_region(ptr, c.get_memory().charge_host(ptr, size));
 }
 
 #if HWMALLOC_ENABLE_DEVICE
 template<>
 region
-register_device_memory<context_impl>(context_impl& c, void* ptr, std::size_t)
+register_device_memory<context_impl>(context_impl& c, void* ptr, std::size_t size)
 {
-    return c.make_region(ptr);
+    return c.make_region(ptr, c.get_memory().charge_device(size));
 }
 #endif
 
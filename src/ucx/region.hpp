@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include "../memory_accounting.hpp"
 #include "./handle.hpp"
 
 namespace oomph
@@ -19,11 +20,13 @@ class region
     using handle_type = handle;
 
   private:
-    void* m_ptr;
+    void*         m_ptr;
+    memory_charge m_charge;
 
   public:
-    region(void* ptr)
+    region(void* ptr, memory_charge&& charge)
     : m_ptr{ptr}
+    , m_charge{std::move(charge)}
     {
     }
 
@@ -31,6 +34,7 @@ class region
 
     region(region&& r) noexcept
     : m_ptr{std::exchange(r.m_ptr, nullptr)}
+    , m_charge{std::move(r.m_charge)}
     {
     }
 
@@ -51,12 +55,15 @@ class rma_region
     void*         m_ptr;
     std::size_t   m_size;
     ucp_mem_h     m_memh;
+    memory_charge m_charge;
 
   public:
-    rma_region(ucp_context_h ctxt, void* ptr, std::size_t size, bool gpu = false)
+    rma_region(ucp_context_h ctxt, void* ptr, std::size_t size, memory_charge&& charge,
+        bool gpu = false)
     : m_ucp_context{ctxt}
     , m_ptr{ptr}
     , m_size{size}
+    , m_charge{std::move(charge)}
     {
         ucp_mem_map_params_t params;
 
@@ -103,6 +110,7 @@ class rma_region
     , m_ptr{std::exchange(r.m_ptr, nullptr)}
     , m_size{r.m_size}
     , m_memh{r.m_memh}
+    , m_charge{std::move(r.m_charge)}
     {
     }
     ~rma_region()
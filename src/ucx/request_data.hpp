@@ -9,7 +9,11 @@
  */
 #pragma once
 
+#include <oomph/completion_queue.hpp>
 #include <oomph/util/unique_function.hpp>
+#include <oomph/detail/request_state.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <chrono>
 
 namespace oomph
 {
@@ -18,19 +22,35 @@ class communicator_impl;
 struct request_data
 {
     using comm_ptr_t = communicator_impl*;
-    using cb_ptr_t = util::detail::unique_function<void>*;
+    using cb_ptr_t = util::unique_function<void()>*;
+
+    // what to do once the operation has completed: invoke the callback m_cb or, if there is none,
+    // set the ready flag of m_state (null for detached operations) and decrement m_scheduled.
+    // The remaining members are used to record the latency of the operation; peer, length and
+    // outcome of a receive are updated to the received ones on completion.
+    struct completion
+    {
+        cb_ptr_t                              m_cb = nullptr;
+        detail::request_state*                m_state = nullptr;
+        std::size_t*                          m_scheduled = nullptr;
+        int                                   m_peer = -1;
+        std::size_t                           m_bytes = 0;
+        completion_status                     m_status = completion_status::success;
+        bool                                  m_send = false;
+        std::chrono::steady_clock::time_point m_post{};
+    };
 
     void*      m_ucx_ptr;
     comm_ptr_t m_comm;
-    cb_ptr_t   m_cb;
+    completion m_completion;
 
     void clear()
     {
         m_comm = nullptr;
-        m_cb = nullptr;
+        m_completion = completion{};
     }
 
-    static request_data* construct(void* ptr, comm_ptr_t comm, cb_ptr_t cb)
+    static request_data* construct(void* ptr, comm_ptr_t comm, completion c)
     {
         // alignment mask
         static constexpr std::uintptr_t mask = ~(alignof(request_data) - 1u);
@@ -39,7 +59,7 @@ struct request_data
             (reinterpret_cast<std::uintptr_t>((unsigned char*)ptr) + alignof(request_data) - 1) &
             mask);
         // construct in ucx provided memory
-        new (a_ptr) request_data{ptr, comm, cb};
+        new (a_ptr) request_data{ptr, comm, c};
         return a_ptr;
     }
 
@@ -54,10 +74,15 @@ struct request_data
     }
 
     // initialize request on prestine request data allocated by ucx
-    static void init(void* ptr) { request_data::construct(ptr, nullptr, nullptr); }
+    static void init(void* ptr) { request_data::construct(ptr, nullptr, completion{}); }
 };
 
 using request_data_size =
     std::integral_constant<std::size_t, sizeof(request_data) + alignof(request_data)>;
 
+// completions handed over between threads, see communicator_impl
+// queue nodes are recycled through the queues' free lists: they only allocate while growing
+using completion_lockfree_queue = boost::lockfree::queue<request_data::completion,
+    boost::lockfree::fixed_sized<false>, boost::lockfree::allocator<std::allocator<void>>>;
+
 } // namespace oomph
@@ -27,12 +27,14 @@ class rma_context
     using tag_type = communicator::tag_type;
 
   private:
-    heap_type     m_heap;
-    ucp_context_h m_context;
+    memory_accounting* m_memory;
+    heap_type          m_heap;
+    ucp_context_h      m_context;
 
   public:
-    rma_context()
-    : m_heap{this}
+    rma_context(memory_accounting& memory)
+    : m_memory{&memory}
+    , m_heap{this}
     {
     }
     rma_context(context_impl const&) = delete;
@@ -40,7 +42,7 @@ class rma_context
 
     rma_region make_region(void* ptr, std::size_t size, bool gpu = false)
     {
-        return {m_context, ptr, size, gpu};
+        return {m_context, ptr, size, m_memory->charge_rma(size), gpu};
     }
 
     auto& get_heap() noexcept { return m_heap; }
@@ -20,7 +20,7 @@ communicator_impl*
 context_impl::get_communicator()
 {
     auto send_worker = std::make_unique<worker_type>(get(), m_db,
-        (m_thread_safe ? UCS_THREAD_MODE_SERIALIZED : UCS_THREAD_MODE_SINGLE));
+        (m_thread_safe ? UCS_THREAD_MODE_SERIALIZED : UCS_THREAD_MODE_SINGLE), m_memory);
     auto send_worker_ptr = send_worker.get();
     if (m_thread_safe)
     {
@@ -39,8 +39,15 @@ context_impl::get_communicator()
 
 context_impl::~context_impl()
 {
+#if defined OOMPH_UCX_USE_MEMORY_HOOKS
+    if (m_registration_cache.enabled())
+        ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED, &context_impl::vm_unmapped, this);
+#endif
+
     // issue a barrier to sync all contexts
+    auto p = phase("teardown_barrier");
     MPI_Barrier(m_mpi_comm);
+    p.next("endpoint_close");
 
     const auto              t0 = std::chrono::system_clock::now();
     double                  elapsed = 0.0;
@@ -76,6 +83,7 @@ context_impl::~context_impl()
         for (auto& h : handles) ucp_request_free(h.m_status);
     }
 
+    p.next("flush");
     // issue another non-blocking barrier while progressing the receive worker in order to flush all
     // remaining (remote) endpoints which are connected to this receive worker
     MPI_Request req;
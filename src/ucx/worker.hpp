@@ -15,6 +15,7 @@
 //#include "./error.hpp"
 #include "./endpoint.hpp"
 #include "./address_db.hpp"
+#include "../memory_accounting.hpp"
 //#include "../util/pthread_spin_mutex.hpp"
 //#include "../mpi/rank_topology.hpp"
 #include <map>
@@ -77,17 +78,22 @@ struct worker_t
     address_t                 m_address;
     ep_handle_vector          m_endpoint_handles;
     cache_type                m_endpoint_cache;
+    memory_charge             m_worker_count;
+    memory_charge             m_endpoint_count;
+    memory_charge             m_address_size;
     //int                       m_progressed_sends = 0;
     //mutex_t*                  m_mutex_ptr = nullptr;
     //volatile int              m_progressed_recvs = 0;
     //volatile int              m_progressed_cancels = 0;
 
     worker_t(ucp_context_h ucp_handle, type_erased_address_db_t& db /*, mutex_t& mm*/,
-        ucs_thread_mode_t mode /*, const mpi::rank_topology& t*/)
+        ucs_thread_mode_t mode, memory_accounting& memory /*, const mpi::rank_topology& t*/)
     //: m_rank_topology(t)
     : m_db{db}
     , m_rank{m_db.rank()}
     , m_size{m_db.size()}
+    , m_worker_count{memory.charge_workers(1)}
+    , m_endpoint_count{memory.charge_endpoints()}
     //, m_mutex_ptr{&mm}
     {
         ucp_worker_params_t params;
@@ -101,6 +107,7 @@ struct worker_t
         m_address = address_t{reinterpret_cast<unsigned char*>(worker_address),
             reinterpret_cast<unsigned char*>(worker_address) + address_length};
         ucp_worker_release_address(m_worker.get(), worker_address);
+        m_address_size = memory.charge_addresses(address_length);
         m_worker.m_moved = false;
     }
 
@@ -120,6 +127,7 @@ struct worker_t
         auto addr = m_db.find(rank);
         auto p =
             m_endpoint_cache.insert(std::make_pair(rank, endpoint_t{rank, m_worker.get(), addr}));
+        m_endpoint_count.resize(m_endpoint_cache.size());
         return p.first->second;
     }
 
@@ -0,0 +1,224 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#pragma once
+
+#include <oomph/util/mpi_error.hpp>
+#include <oomph/util/mpi_comm_holder.hpp>
+#include "./stats_counters.hpp"
+#include "./env.hpp"
+#include "./clock_sync.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace oomph
+{
+// communicator for the time stamps of the wait analysis and its sampling interval, shared by the
+// communicators of a context
+struct wait_channel
+{
+    util::mpi_comm_holder m_comm;
+    std::uint64_t         m_sample;
+
+    // collective: the variable must be set alike on all ranks
+    static std::unique_ptr<wait_channel> from_env(MPI_Comm comm)
+    {
+        auto const sample = env_size("OOMPH_WAIT_ANALYSIS", 0);
+        if (!sample) return {};
+        return std::unique_ptr<wait_channel>(new wait_channel{util::mpi_comm_holder(comm), sample});
+    }
+};
+
+// Wait-state analysis of one communicator, enabled with OOMPH_WAIT_ANALYSIS=N. Of every N messages
+// to a peer with a given tag, the sender posts a time stamp on a duplicate of the context's MPI
+// communicator, with the same peer and tag, right before the message itself. Since MPI matches
+// messages of a peer and tag in order, both sides count their posts per peer and tag and thereby
+// select the same messages without further coordination. On completion of such a receive, the time
+// from posting it is split into waiting for a late sender and the transfer, or the time by which
+// the receive was posted after the send is recorded as late receiver. If the time stamp has not
+// arrived yet when the message completes, the receive is accounted for by a later progress call.
+// Time stamps are taken from the global clock of the context.
+//
+// This requires every peer and tag pair to be used by a single communicator on either side.
+// Receives from any_source are not sampled and cancelled receives are not accounted for: both put
+// the pairing out of step, which is detected through sequence numbers and counted as unmatched.
+class wait_analysis
+{
+  private:
+    struct stamp
+    {
+        std::uint64_t m_time;
+        std::uint64_t m_seq;
+    };
+
+    struct pending_send
+    {
+        MPI_Request m_req;
+        stamp       m_stamp;
+    };
+
+    struct pending_recv
+    {
+        MPI_Request   m_req = MPI_REQUEST_NULL;
+        stamp         m_stamp;
+        std::uint64_t m_seq;
+        std::uint64_t m_post;
+        std::uint64_t m_done; // completion of the message
+        int           m_src;
+    };
+
+    MPI_Comm                                         m_comm;
+    std::uint64_t const                              m_sample;
+    clock_sync const&                                m_clock;
+    std::unordered_map<std::uint64_t, std::uint64_t> m_send_seq;
+    std::unordered_map<std::uint64_t, std::uint64_t> m_recv_seq;
+    // deques keep the buffers of posted MPI operations in place when growing
+    std::deque<pending_send>   m_sends;
+    std::deque<pending_recv>   m_recvs; // indexed by slot - 1
+    std::vector<std::uint32_t> m_free_slots;
+    std::vector<std::uint32_t> m_completed; // slots of completed messages awaiting their stamp
+
+  public:
+    wait_analysis(wait_channel const& c, clock_sync const& clock)
+    : m_comm{c.m_comm.get()}
+    , m_sample{c.m_sample}
+    , m_clock{clock}
+    {
+    }
+
+    wait_analysis(wait_analysis const&) = delete;
+    wait_analysis& operator=(wait_analysis const&) = delete;
+
+    ~wait_analysis()
+    {
+        for (auto& s : m_sends) finish(s.m_req);
+        for (auto& r : m_recvs) finish(r.m_req);
+    }
+
+    std::uint64_t now() const noexcept { return m_clock.global_ns(); }
+
+    // must be called right before posting the send
+    void post_send(int dst, int tag)
+    {
+        auto const seq = m_send_seq[key(dst, tag)]++;
+        if (seq % m_sample) return;
+        retire_sends();
+        m_sends.push_back(pending_send{MPI_REQUEST_NULL, stamp{now(), seq}});
+        auto& s = m_sends.back();
+        OOMPH_CHECK_MPI_RESULT(
+            MPI_Isend(&s.m_stamp, sizeof(stamp), MPI_BYTE, dst, tag, m_comm, &s.m_req));
+    }
+
+    // must be called right before posting the receive: returns a non-zero slot if it is sampled
+    std::uint32_t post_recv(int src, int tag)
+    {
+        if (src < 0) return 0;
+        auto const seq = m_recv_seq[key(src, tag)]++;
+        if (seq % m_sample) return 0;
+        std::uint32_t slot;
+        if (m_free_slots.empty())
+        {
+            m_recvs.emplace_back();
+            slot = m_recvs.size();
+        }
+        else
+        {
+            slot = m_free_slots.back();
+            m_free_slots.pop_back();
+        }
+        auto& r = m_recvs[slot - 1];
+        r.m_seq = seq;
+        r.m_src = src;
+        r.m_post = now();
+        OOMPH_CHECK_MPI_RESULT(
+            MPI_Irecv(&r.m_stamp, sizeof(stamp), MPI_BYTE, src, tag, m_comm, &r.m_req));
+        return slot;
+    }
+
+    // called on completion of a sampled receive: the time stamp was sent before the message, but
+    // its receive may not have completed yet, in which case it is accounted for by progress
+    void complete_recv(std::uint32_t slot, communication_counters& counters)
+    {
+        auto& r = m_recvs[slot - 1];
+        r.m_done = now();
+        if (test(r.m_req)) account(slot, counters);
+        else m_completed.push_back(slot);
+    }
+
+    // accounts for the completed receives whose time stamp has arrived since
+    void progress(communication_counters& counters)
+    {
+        for (std::size_t i = 0; i < m_completed.size();)
+        {
+            auto const slot = m_completed[i];
+            if (!test(m_recvs[slot - 1].m_req))
+            {
+                ++i;
+                continue;
+            }
+            m_completed[i] = m_completed.back();
+            m_completed.pop_back();
+            account(slot, counters);
+        }
+    }
+
+  private:
+    static std::uint64_t key(int peer, int tag) noexcept
+    {
+        return ((std::uint64_t)(std::uint32_t)peer << 32) | (std::uint32_t)tag;
+    }
+
+    static bool test(MPI_Request& req)
+    {
+        int flag;
+        OOMPH_CHECK_MPI_RESULT(MPI_Test(&req, &flag, MPI_STATUS_IGNORE));
+        return flag;
+    }
+
+    void account(std::uint32_t slot, communication_counters& counters)
+    {
+        auto const& r = m_recvs[slot - 1];
+        m_free_slots.push_back(slot);
+        if (r.m_stamp.m_seq != r.m_seq)
+        {
+            counters.wait_unmatched();
+            return;
+        }
+
+        auto const done = r.m_done;
+        auto const sent = r.m_stamp.m_time;
+        auto const late_sender = sent > r.m_post ? std::min(sent, done) - r.m_post : 0;
+        auto const late_receiver = r.m_post > sent ? r.m_post - sent : 0;
+        auto const start = std::max(sent, r.m_post);
+        counters.wait_state(r.m_src, late_sender, late_receiver, done > start ? done - start : 0);
+    }
+
+    void retire_sends()
+    {
+        while (!m_sends.empty() && test(m_sends.front().m_req)) m_sends.pop_front();
+    }
+
+    // completes or cancels an operation which is still pending on destruction
+    static void finish(MPI_Request& req) noexcept
+    {
+        if (req == MPI_REQUEST_NULL) return;
+        int flag;
+        MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+        if (flag) return;
+        MPI_Cancel(&req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    }
+};
+
+} // namespace oomph
@@ -0,0 +1,80 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <oomph/context.hpp>
+#include <memory>
+#include <vector>
+
+// A communicator on the ring of all ranks, sending to the successor and receiving from the
+// predecessor, with num_msgs send and receive buffers of size elements. Send buffer i of a rank
+// holds rank * 1000 + i. The context is created on MPI_COMM_WORLD unless one is passed.
+struct ring_environment
+{
+    using rank_type = oomph::communicator::rank_type;
+    using message = oomph::message_buffer<rank_type>;
+
+    std::unique_ptr<oomph::context> owned_ctxt;
+    oomph::context&                 ctxt;
+    oomph::communicator             comm;
+    rank_type                       speer_rank;
+    rank_type                       rpeer_rank;
+    std::vector<message>            smsgs;
+    std::vector<message>            rmsgs;
+
+    ring_environment(int num_msgs, std::size_t size)
+    : ring_environment(new oomph::context(MPI_COMM_WORLD, false), num_msgs, size)
+    {
+    }
+
+    ring_environment(oomph::context& c, int num_msgs, std::size_t size)
+    : ring_environment(nullptr, c, num_msgs, size)
+    {
+    }
+
+    void fill_recv_buffers()
+    {
+        for (auto& m : rmsgs)
+            for (auto& x : m) x = -1;
+    }
+
+    // m holds send buffer i of the predecessor
+    bool check_recv(message const& m, int i) const
+    {
+        for (auto x : m)
+            if (x != rpeer_rank * 1000 + i) return false;
+        return true;
+    }
+
+    bool check_recv_buffer(int i) const { return check_recv(rmsgs[i], i); }
+
+  private:
+    // takes ownership of c
+    ring_environment(oomph::context* c, int num_msgs, std::size_t size)
+    : ring_environment(std::unique_ptr<oomph::context>(c), *c, num_msgs, size)
+    {
+    }
+
+    ring_environment(
+        std::unique_ptr<oomph::context> owned, oomph::context& c, int num_msgs, std::size_t size)
+    : owned_ctxt(std::move(owned))
+    , ctxt(c)
+    , comm(ctxt.get_communicator())
+    , speer_rank((comm.rank() + 1) % comm.size())
+    , rpeer_rank((comm.rank() + comm.size() - 1) % comm.size())
+    {
+        for (int i = 0; i < num_msgs; ++i)
+        {
+            smsgs.push_back(comm.make_buffer<rank_type>(size));
+            rmsgs.push_back(comm.make_buffer<rank_type>(size));
+            for (auto& x : smsgs.back()) x = comm.rank() * 1000 + i;
+        }
+    }
+};
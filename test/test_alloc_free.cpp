@@ -0,0 +1,203 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "./ring_environment.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#define NWARMUP 20
+#define NITERS  100
+#define SIZE    64
+
+// Count heap allocations made by the test thread by interposing the C allocation functions. Only
+// allocations in between start_counting() and stop_counting() are recorded; allocations made by
+// threads of the transport layer are ignored.
+#if defined(__GLIBC__)
+#define OOMPH_TEST_COUNT_ALLOCATIONS 1
+
+extern "C" void* __libc_malloc(std::size_t);
+extern "C" void* __libc_calloc(std::size_t, std::size_t);
+extern "C" void* __libc_realloc(void*, std::size_t);
+
+namespace
+{
+thread_local bool        counting = false;
+thread_local std::size_t num_allocations = 0;
+} // namespace
+
+extern "C" void*
+malloc(std::size_t size)
+{
+    if (counting) ++num_allocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void*
+calloc(std::size_t n, std::size_t size)
+{
+    if (counting) ++num_allocations;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void*
+realloc(void* ptr, std::size_t size)
+{
+    if (counting) ++num_allocations;
+    return __libc_realloc(ptr, size);
+}
+#else
+#define OOMPH_TEST_COUNT_ALLOCATIONS 0
+
+namespace
+{
+bool        counting = false;
+std::size_t num_allocations = 0;
+} // namespace
+#endif
+
+void
+start_counting()
+{
+    num_allocations = 0;
+    counting = true;
+}
+
+std::size_t
+stop_counting()
+{
+    counting = false;
+    return num_allocations;
+}
+
+// sends from the first buffer, receives into one buffer per receive in flight
+struct test_environment : public ring_environment
+{
+    static constexpr int total = NWARMUP + NITERS;
+
+    int depth; // receives in flight
+
+    test_environment(int size)
+    : ring_environment(size, SIZE)
+    , depth(size)
+    {
+    }
+
+    message& smsg() { return smsgs[0]; }
+    message& rmsg(int i) { return rmsgs[i % depth]; }
+
+    // Posts the receive of iteration i + depth - 1 with post before running iteration i, and
+    // returns the number of allocations made in the last NITERS iterations. On the ring a rank is
+    // at most size - 1 iterations ahead of its successor, so with depth = size every message finds
+    // its receive posted: unexpected messages make MPI allocate depending on timing.
+    template<typename Post, typename Iteration>
+    std::size_t count(Post&& post, Iteration&& iteration)
+    {
+        for (int i = 0; i < depth - 1 && i < total; ++i) post(i);
+        for (int i = 0; i < total; ++i)
+        {
+            if (i == NWARMUP) start_counting();
+            if (i + depth - 1 < total) post(i + depth - 1);
+            iteration(i);
+        }
+        return stop_counting();
+    }
+
+    bool check_recv(message const& m) const { return ring_environment::check_recv(m, 0); }
+};
+
+TEST_F(mpi_test_fixture, alloc_free_wait)
+{
+#if !OOMPH_TEST_COUNT_ALLOCATIONS
+    GTEST_SKIP() << "allocation counting requires glibc";
+#endif
+    test_environment                 env(world_size);
+    auto&                            comm = env.comm;
+    std::vector<oomph::recv_request> rreqs(env.depth);
+    bool                             ok = true;
+
+    auto const n = env.count(
+        [&](int i) { rreqs[i % env.depth] = comm.recv(env.rmsg(i), env.rpeer_rank, i); },
+        [&](int i)
+        {
+            auto  sreq = comm.send(env.smsg(), env.speer_rank, i);
+            auto& rreq = rreqs[i % env.depth];
+            while (!(rreq.test() && sreq.test())) {}
+            ok = ok && env.check_recv(env.rmsg(i));
+        });
+    EXPECT_EQ(n, 0u);
+    EXPECT_TRUE(ok);
+}
+
+TEST_F(mpi_test_fixture, alloc_free_callback)
+{
+#if !OOMPH_TEST_COUNT_ALLOCATIONS
+    GTEST_SKIP() << "allocation counting requires glibc";
+#endif
+    using message = test_environment::message;
+    test_environment  env(world_size);
+    auto&             comm = env.comm;
+    std::vector<char> received(test_environment::total, 0);
+    int               sent = 0;
+    bool              ok = true;
+
+    auto const n = env.count(
+        [&](int i)
+        {
+            comm.recv(env.rmsg(i), env.rpeer_rank, i,
+                [&](message& m, int, int tag)
+                {
+                    received[tag] = 1;
+                    ok = ok && env.check_recv(m);
+                });
+        },
+        [&](int i)
+        {
+            comm.send(env.smsg(), env.speer_rank, i, [&sent](message const&, int, int) { ++sent; });
+            while (!received[i] || sent <= i) comm.progress();
+        });
+    EXPECT_EQ(n, 0u);
+    EXPECT_EQ(sent, test_environment::total);
+    EXPECT_TRUE(comm.is_ready());
+    EXPECT_TRUE(ok);
+}
+
+TEST_F(mpi_test_fixture, alloc_free_callback_rref)
+{
+#if !OOMPH_TEST_COUNT_ALLOCATIONS
+    GTEST_SKIP() << "allocation counting requires glibc";
+#endif
+    using message = test_environment::message;
+    test_environment env(world_size);
+    auto&            comm = env.comm;
+
+    // the messages are handed to the communicator and given back by the callbacks
+    auto const n = env.count(
+        [&](int i)
+        {
+            comm.recv(std::move(env.rmsg(i)), env.rpeer_rank, i,
+                [&env](message m, int, int tag) { env.rmsg(tag) = std::move(m); });
+        },
+        [&](int i)
+        {
+            comm.send(std::move(env.smsg()), env.speer_rank, i,
+                [&env](message m, int, int) { env.smsg() = std::move(m); });
+            while (!(env.rmsg(i) && env.smsg())) comm.progress();
+        });
+    EXPECT_EQ(n, 0u);
+    ASSERT_TRUE(env.smsg());
+    for (auto& m : env.rmsgs)
+    {
+        ASSERT_TRUE(m);
+        EXPECT_TRUE(env.check_recv(m));
+    }
+}
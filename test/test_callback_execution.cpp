@@ -0,0 +1,107 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "./ring_environment.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define NITERS 20
+#define SIZE   64
+#define NMSGS  8
+
+// callbacks run where the policy says, and requests become ready once the callbacks have returned
+void
+run(oomph::context& ctxt, oomph::callback_execution e)
+{
+    using message = ring_environment::message;
+    ring_environment env(ctxt, NMSGS, SIZE);
+    auto&            comm = env.comm;
+    auto const       owner = std::this_thread::get_id();
+    comm.set_callback_execution(e);
+
+    std::atomic<int> num_correct{0};
+    std::atomic<int> num_sent{0};
+    std::atomic<int> num_owner{0};
+    for (int it = 0; it < NITERS; ++it)
+    {
+        std::vector<oomph::recv_request> rreqs;
+        std::vector<oomph::send_request> sreqs;
+        for (int i = 0; i < NMSGS; ++i)
+            rreqs.push_back(comm.recv(env.rmsgs[i], env.rpeer_rank, i,
+                [&, i](message& m, int, int)
+                {
+                    if (env.check_recv(m, i)) ++num_correct;
+                    if (std::this_thread::get_id() == owner) ++num_owner;
+                }));
+        for (int i = 0; i < NMSGS; ++i)
+            sreqs.push_back(comm.send(std::move(env.smsgs[i]), env.speer_rank, i,
+                [&, i](message m, int, int)
+                {
+                    env.smsgs[i] = std::move(m);
+                    ++num_sent;
+                }));
+        for (auto& r : rreqs) r.wait();
+        for (auto& r : sreqs) r.wait();
+    }
+    EXPECT_TRUE(comm.is_ready());
+    EXPECT_EQ(num_correct.load(), NITERS * NMSGS);
+    EXPECT_EQ(num_sent.load(), NITERS * NMSGS);
+    if (e == oomph::callback_execution::thread_pool) EXPECT_EQ(num_owner.load(), 0);
+    else
+        EXPECT_EQ(num_owner.load(), NITERS * NMSGS);
+}
+
+TEST_F(mpi_test_fixture, callback_execution)
+{
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        run(ctxt, oomph::callback_execution::immediate);
+        run(ctxt, oomph::callback_execution::deferred);
+    }
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, true);
+        run(ctxt, oomph::callback_execution::thread_pool);
+    }
+}
+
+TEST_F(mpi_test_fixture, callback_execution_deferred)
+{
+    using message = ring_environment::message;
+    oomph::context   ctxt(MPI_COMM_WORLD, false);
+    ring_environment env(ctxt, NMSGS, SIZE);
+    auto&            comm = env.comm;
+    comm.set_callback_execution(oomph::callback_execution::deferred);
+
+    int  received = 0;
+    auto rreq = comm.recv(env.rmsgs[0], env.rpeer_rank, 0, [&](message&, int, int) { ++received; });
+    comm.send(env.smsgs[0], env.speer_rank, 0).wait();
+
+    // progress never runs deferred callbacks
+    for (int i = 0; i < 1000; ++i) comm.progress();
+    EXPECT_EQ(received, 0);
+    EXPECT_FALSE(rreq.is_ready());
+
+    while (comm.run_deferred_callbacks() == 0) comm.progress();
+    EXPECT_EQ(received, 1);
+    EXPECT_TRUE(rreq.is_ready());
+    EXPECT_TRUE(env.check_recv_buffer(0));
+    EXPECT_EQ(comm.run_deferred_callbacks(), 0u);
+
+    // testing a request runs the deferred callbacks
+    rreq = comm.recv(env.rmsgs[0], env.rpeer_rank, 1, [&](message&, int, int) { ++received; });
+    auto sreq = comm.send(env.smsgs[0], env.speer_rank, 1, [&](message const&, int, int) {});
+    while (!rreq.test()) {}
+    while (!sreq.test()) {}
+    EXPECT_EQ(received, 2);
+    EXPECT_TRUE(comm.is_ready());
+}
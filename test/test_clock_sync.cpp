@@ -0,0 +1,73 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <cstdint>
+
+#define NITERS 10
+
+// allowed deviation from causality: the error of the offset of a rank at synchronization plus the
+// one of the drift extrapolation, which is up to twice the error over the time between the
+// synchronizations (about as long as the checks take), with some margin
+std::int64_t
+tolerance(std::int64_t error_ns)
+{
+    return 4 * error_ns;
+}
+
+// times sent from rank 0 must not be later than the time of arrival and vice versa
+void
+check_causality(oomph::context const& ctxt, int rank, int size)
+{
+    for (int i = 0; i < NITERS; ++i)
+    {
+        for (int r = 1; r < size; ++r)
+        {
+            if (rank == 0)
+            {
+                // time and error bound of rank r
+                std::int64_t t[2] = {ctxt.global_time().count(), 0};
+                MPI_Send(t, 1, MPI_INT64_T, r, 0, MPI_COMM_WORLD);
+                MPI_Recv(t, 2, MPI_INT64_T, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                EXPECT_LE(t[0], ctxt.global_time().count() + tolerance(t[1]));
+            }
+            else if (rank == r)
+            {
+                std::int64_t const error = ctxt.global_time_error().count();
+                std::int64_t       t[2];
+                MPI_Recv(t, 1, MPI_INT64_T, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                EXPECT_GE(ctxt.global_time().count() + tolerance(error), t[0]);
+                t[0] = ctxt.global_time().count();
+                t[1] = error;
+                MPI_Send(t, 2, MPI_INT64_T, 0, 0, MPI_COMM_WORLD);
+            }
+        }
+    }
+}
+
+TEST_F(mpi_test_fixture, clock_sync)
+{
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+
+    auto const t0 = ctxt.global_time();
+    auto const t1 = ctxt.global_time();
+    EXPECT_LE(t0, t1);
+
+    // rank 0 is the reference
+    if (world_rank == 0) EXPECT_EQ(ctxt.global_time_error().count(), 0);
+    else
+        EXPECT_GT(ctxt.global_time_error().count(), 0);
+
+    check_causality(ctxt, world_rank, world_size);
+    ctxt.synchronize_clocks();
+    check_causality(ctxt, world_rank, world_size);
+    EXPECT_LE(t1, ctxt.global_time());
+}
@@ -0,0 +1,160 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "./ring_environment.hpp"
+#include <stdexcept>
+#include <vector>
+
+#define NITERS 20
+#define SIZE   64
+#define NMSGS  8
+
+TEST_F(mpi_test_fixture, completion_queue)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+    comm.enable_completion_queue(2 * NMSGS);
+
+    // small output span: records are drained in several batches
+    oomph::completion out[3];
+    for (int it = 0; it < NITERS; ++it)
+    {
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            for (auto& x : env.rmsgs[i]) x = -1;
+            comm.post_recv(env.rmsgs[i], env.rpeer_rank, i, &env.rmsgs[i]);
+        }
+        for (int i = 0; i < NMSGS; ++i)
+            comm.post_send(env.smsgs[i], env.speer_rank, i, &env.smsgs[i]);
+
+        std::vector<int> recvd(NMSGS, 0);
+        std::vector<int> sent(NMSGS, 0);
+        int              n = 0;
+        while (n < 2 * NMSGS)
+        {
+            auto const m = comm.poll_completions(out);
+            for (std::size_t k = 0; k < m; ++k)
+            {
+                auto const& c = out[k];
+                ASSERT_GE(c.tag, 0);
+                ASSERT_LT(c.tag, NMSGS);
+                EXPECT_EQ(c.bytes, SIZE * sizeof(int));
+                EXPECT_EQ(c.status, oomph::completion_status::success);
+                if (c.kind == oomph::completion_kind::recv)
+                {
+                    EXPECT_EQ(c.peer, env.rpeer_rank);
+                    EXPECT_EQ(c.cookie, &env.rmsgs[c.tag]);
+                    EXPECT_TRUE(env.check_recv_buffer(c.tag));
+                    ++recvd[c.tag];
+                }
+                else
+                {
+                    EXPECT_EQ(c.peer, env.speer_rank);
+                    EXPECT_EQ(c.cookie, &env.smsgs[c.tag]);
+                    ++sent[c.tag];
+                }
+            }
+            n += m;
+        }
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            EXPECT_EQ(recvd[i], 1);
+            EXPECT_EQ(sent[i], 1);
+        }
+        EXPECT_TRUE(comm.is_ready());
+        EXPECT_EQ(comm.poll_completions(out), 0u);
+    }
+}
+
+TEST_F(mpi_test_fixture, completion_queue_full)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+
+    EXPECT_THROW(comm.post_send(env.smsgs[0], env.speer_rank, 0), std::runtime_error);
+
+    // capacity counts records which have not been polled yet
+    comm.enable_completion_queue(1);
+    comm.post_recv(env.rmsgs[0], env.rpeer_rank, 0);
+    EXPECT_THROW(comm.post_send(env.smsgs[0], env.speer_rank, 0), std::runtime_error);
+    EXPECT_THROW(comm.enable_completion_queue(4), std::runtime_error);
+    comm.send(env.smsgs[0], env.speer_rank, 0).wait();
+    comm.wait_all();
+
+    oomph::completion c;
+    EXPECT_EQ(comm.poll_completions({&c, 1}), 1u);
+    EXPECT_EQ(c.kind, oomph::completion_kind::recv);
+    EXPECT_TRUE(env.check_recv_buffer(0));
+    comm.enable_completion_queue(4);
+}
+
+// the outcome reported by the transport layer overrides the posted values, once
+TEST_F(mpi_test_fixture, completion_queue_reported_status)
+{
+    using oomph::completion_status;
+    oomph::detail::completion_queue q(3);
+    int                             cookie;
+    oomph::completion const         posted{
+        &cookie, 1, 7, 64, oomph::completion_kind::recv, completion_status::success};
+
+    oomph::detail::transport_completion const received{2, 16, completion_status::success};
+    oomph::detail::transport_completion const failed{2, 16, completion_status::error};
+    oomph::detail::transport_completion const cancelled{2, 0, completion_status::cancelled};
+    for (auto t : {&received, &failed, &cancelled})
+    {
+        q.reserve();
+        q.set_reported(t);
+        q.push(posted);
+        EXPECT_EQ(q.reported(), nullptr);
+    }
+
+    oomph::completion c[3];
+    ASSERT_EQ(q.pop(c), 3u);
+    EXPECT_EQ(c[0].status, completion_status::success);
+    EXPECT_EQ(c[0].peer, 2);
+    EXPECT_EQ(c[0].bytes, 16u);
+    EXPECT_EQ(c[1].status, completion_status::error);
+    EXPECT_EQ(c[1].peer, 1);
+    EXPECT_EQ(c[1].bytes, 0u);
+    EXPECT_EQ(c[2].status, completion_status::cancelled);
+    EXPECT_EQ(c[2].bytes, 0u);
+    for (auto const& r : c) EXPECT_EQ(r.cookie, &cookie);
+}
+
+TEST_F(mpi_test_fixture, completion_queue_any_source)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+    comm.enable_completion_queue(2);
+
+    // the record of a receive holds the actual source and length of the message
+    auto smsg = comm.make_buffer<int>(SIZE / 2);
+    for (int it = 0; it < NITERS; ++it)
+    {
+        comm.post_recv(env.rmsgs[0], oomph::communicator::any_source, it);
+        comm.post_send(smsg, env.speer_rank, it);
+        oomph::completion out[2];
+        int               n = 0;
+        while (n < 2)
+        {
+            auto const m = comm.poll_completions({out + n, 2u - n});
+            n += m;
+        }
+        for (auto const& c : out)
+        {
+            EXPECT_EQ(c.bytes, SIZE / 2 * sizeof(int));
+            if (c.kind == oomph::completion_kind::recv) EXPECT_EQ(c.peer, env.rpeer_rank);
+            else
+                EXPECT_EQ(c.peer, env.speer_rank);
+        }
+    }
+}
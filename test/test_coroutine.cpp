@@ -0,0 +1,171 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/coroutine.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <stdexcept>
+#include <vector>
+
+#define NITERS  10
+#define SIZE    16
+#define NBLOCKS 256
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+struct block
+{
+    message smsg;
+    message rmsg;
+    int     num_correct = 0;
+};
+
+// one exchange with the neighbours: returns true if the received data is correct
+oomph::coro::task<bool>
+exchange(oomph::communicator& comm, block& b, int id, int it)
+{
+    auto const speer = (comm.rank() + 1) % comm.size();
+    auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+    for (auto& x : b.smsg) x = comm.rank() * 1000 + it;
+    for (auto& x : b.rmsg) x = -1;
+
+    auto r = comm.recv(b.rmsg, rpeer, id);
+    co_await comm.send(b.smsg, speer, id);
+    co_await std::move(r);
+
+    for (auto x : b.rmsg)
+        if (x != rpeer * 1000 + it) co_return false;
+    co_return true;
+}
+
+// per-block pipeline of exchanges
+oomph::coro::task<>
+pipeline(oomph::communicator& comm, block& b, int id)
+{
+    for (int it = 0; it < NITERS; ++it)
+        if (co_await exchange(comm, b, id, it)) ++b.num_correct;
+}
+
+TEST_F(mpi_test_fixture, coroutine_pipeline)
+{
+    oomph::context         ctxt(MPI_COMM_WORLD, false);
+    auto                   comm = ctxt.get_communicator();
+    oomph::coro::scheduler sched(comm);
+
+    std::vector<block> blocks(NBLOCKS);
+    for (auto& b : blocks)
+    {
+        b.smsg = comm.make_buffer<rank_type>(SIZE);
+        b.rmsg = comm.make_buffer<rank_type>(SIZE);
+    }
+
+    for (int i = 0; i < NBLOCKS; ++i) sched.spawn(pipeline(comm, blocks[i], i));
+    EXPECT_EQ(sched.num_tasks(), (std::size_t)NBLOCKS);
+    sched.run();
+    EXPECT_EQ(sched.num_tasks(), 0u);
+    EXPECT_TRUE(comm.is_ready());
+    for (auto const& b : blocks) EXPECT_EQ(b.num_correct, NITERS);
+}
+
+oomph::coro::task<>
+barrier_task(oomph::barrier& b, oomph::communicator& comm, int& count)
+{
+    for (int i = 0; i < NITERS; ++i)
+    {
+        co_await oomph::coro::rank_barrier(b, comm);
+        ++count;
+    }
+}
+
+TEST_F(mpi_test_fixture, coroutine_barrier)
+{
+    oomph::context         ctxt(MPI_COMM_WORLD, false);
+    auto                   comm = ctxt.get_communicator();
+    oomph::barrier         b;
+    oomph::coro::scheduler sched(comm);
+
+    int count = 0;
+    sched.spawn(barrier_task(b, comm, count));
+    sched.run();
+    EXPECT_EQ(count, NITERS);
+
+    oomph::barrier b2(2);
+    EXPECT_THROW((void)oomph::coro::rank_barrier(b2, comm), std::runtime_error);
+}
+
+// requests of operations with deferred callbacks become ready once the scheduler ran the callbacks
+oomph::coro::task<>
+deferred_task(oomph::communicator& comm, block& b, int& called)
+{
+    auto const speer = (comm.rank() + 1) % comm.size();
+    auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+    for (auto& x : b.smsg) x = comm.rank();
+
+    auto r = comm.recv(b.rmsg, rpeer, 0, [&called](message&, int, int) { ++called; });
+    co_await comm.send(b.smsg, speer, 0, [&called](message const&, int, int) { ++called; });
+    co_await std::move(r);
+
+    for (auto x : b.rmsg)
+        if (x == rpeer) ++b.num_correct;
+}
+
+TEST_F(mpi_test_fixture, coroutine_deferred_callbacks)
+{
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    auto           comm = ctxt.get_communicator();
+    comm.set_callback_execution(oomph::callback_execution::deferred);
+    oomph::coro::scheduler sched(comm);
+
+    block b;
+    b.smsg = comm.make_buffer<rank_type>(SIZE);
+    b.rmsg = comm.make_buffer<rank_type>(SIZE);
+    int called = 0;
+    sched.spawn(deferred_task(comm, b, called));
+    sched.run();
+    EXPECT_EQ(called, 2);
+    EXPECT_EQ(b.num_correct, SIZE);
+    EXPECT_TRUE(comm.is_ready());
+}
+
+oomph::coro::task<int>
+throwing_task(int i)
+{
+    if (i > 0) throw std::runtime_error("test");
+    co_return i;
+}
+
+oomph::coro::task<>
+catching_task(int& caught)
+{
+    try
+    {
+        co_await throwing_task(1);
+    }
+    catch (std::runtime_error const&)
+    {
+        ++caught;
+    }
+    caught += co_await throwing_task(0) == 0 ? 1 : 0;
+    co_await throwing_task(2);
+}
+
+TEST_F(mpi_test_fixture, coroutine_exception)
+{
+    oomph::context         ctxt(MPI_COMM_WORLD, false);
+    auto                   comm = ctxt.get_communicator();
+    oomph::coro::scheduler sched(comm);
+
+    int caught = 0;
+    sched.spawn(catching_task(caught));
+    EXPECT_THROW(sched.run(), std::runtime_error);
+    EXPECT_EQ(caught, 2);
+    EXPECT_EQ(sched.num_tasks(), 0u);
+}
@@ -0,0 +1,106 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/indexed_layout.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+const std::size_t field_size = 10000;
+const std::size_t list_size = 1111;
+const int         num_fields = 3;
+
+using index_type = oomph::indexed_layout::index_type;
+using field_order = oomph::indexed_layout::field_order;
+
+// deterministic random index list, reproducible on the peer rank
+std::vector<index_type>
+make_indices(int seed, bool sorted)
+{
+    std::vector<index_type> idx(field_size);
+    std::iota(idx.begin(), idx.end(), 0);
+    std::mt19937 gen(seed);
+    std::shuffle(idx.begin(), idx.end(), gen);
+    idx.resize(list_size);
+    if (sorted) std::sort(idx.begin(), idx.end());
+    return idx;
+}
+
+template<typename T>
+T
+value(int rank, int field, index_type i)
+{
+    return static_cast<T>(rank * 100000 + field * 10000 + i);
+}
+
+template<typename T>
+void
+test_exchange(oomph::communicator& comm, bool sorted, field_order order)
+{
+    const auto rank = comm.rank();
+    const auto dst = (rank + 1) % comm.size();
+    const auto src = (rank + comm.size() - 1) % comm.size();
+
+    // send list towards dst is seeded by (rank, dst), recv list from src by (rank, src) + 1
+    const auto s_idx = make_indices(2 * (rank * comm.size() + dst), sorted);
+    const auto r_idx = make_indices(2 * (rank * comm.size() + src) + 1, sorted);
+    // the peer's send list
+    const auto peer_s_idx = make_indices(2 * (src * comm.size() + rank), sorted);
+
+    oomph::indexed_layout s_layout(s_idx);
+    oomph::indexed_layout r_layout(r_idx);
+    EXPECT_EQ(s_layout.size(), list_size);
+    EXPECT_EQ(s_layout.in_order(), sorted);
+
+    std::vector<std::vector<T>> fields(num_fields, std::vector<T>(field_size));
+    for (int f = 0; f < num_fields; ++f)
+        for (std::size_t i = 0; i < field_size; ++i) fields[f][i] = value<T>(rank, f, i);
+
+    auto smsg = comm.make_buffer<T>(s_layout.message_size(num_fields));
+    auto rmsg = comm.make_buffer<T>(r_layout.message_size(num_fields));
+
+    s_layout.pack(smsg, {fields[0].data(), fields[1].data(), fields[2].data()}, order);
+    auto rreq = comm.recv(rmsg, src, 0);
+    comm.send(smsg, dst, 0).wait();
+    rreq.wait();
+
+    for (auto& f : fields) std::fill(f.begin(), f.end(), T(-1));
+    r_layout.unpack(rmsg, {fields[0].data(), fields[1].data(), fields[2].data()}, order);
+
+    for (int f = 0; f < num_fields; ++f)
+        for (std::size_t k = 0; k < list_size; ++k)
+            EXPECT_EQ(fields[f][r_idx[k]], value<T>(src, f, peer_s_idx[k]));
+
+    // single field round trip
+    const auto field = fields[0];
+    s_layout.pack(smsg, field.data());
+    std::fill(fields[0].begin(), fields[0].end(), T(-1));
+    s_layout.unpack(smsg, fields[0].data());
+    for (std::size_t k = 0; k < list_size; ++k) EXPECT_EQ(fields[0][s_idx[k]], field[s_idx[k]]);
+}
+
+TEST_F(mpi_test_fixture, indexed_layout)
+{
+    using namespace oomph;
+    auto ctxt = context(MPI_COMM_WORLD, false);
+    auto comm = ctxt.get_communicator();
+
+    for (auto sorted : {true, false})
+        for (auto order : {field_order::interleaved, field_order::struct_of_arrays})
+        {
+            test_exchange<double>(comm, sorted, order);
+            test_exchange<float>(comm, sorted, order);
+            test_exchange<int>(comm, sorted, order);
+            test_exchange<short>(comm, sorted, order);
+        }
+}
@@ -0,0 +1,146 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define NITERS 10
+#define SIZE   64
+#define NMSGS  8
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+// NITERS rounds of NMSGS messages to the right neighbour, receives with callbacks
+void
+exchange(oomph::communicator& comm)
+{
+    auto const speer = (comm.rank() + 1) % comm.size();
+    auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+    std::vector<message> smsgs, rmsgs;
+    for (int i = 0; i < NMSGS; ++i)
+    {
+        smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+    }
+    for (int it = 0; it < NITERS; ++it)
+    {
+        for (int i = 0; i < NMSGS; ++i) comm.recv(rmsgs[i], rpeer, i, [](message&, int, int) {});
+        for (int i = 0; i < NMSGS; ++i) comm.send_detached(smsgs[i], speer, i);
+        comm.wait_all();
+    }
+}
+
+TEST_F(mpi_test_fixture, latency_histogram)
+{
+    using hist = oomph::latency_histogram;
+    // buckets are contiguous and resolve values to within 1/16
+    for (std::uint64_t v = 0; v < (1u << 20); v += 1 + v / 64)
+    {
+        auto const b = hist::bucket(v);
+        ASSERT_LT(b, hist::num_buckets);
+        EXPECT_LE(hist::lower_bound(b), v);
+        EXPECT_GT(hist::lower_bound(b + 1), v);
+        EXPECT_LE(hist::lower_bound(b + 1) - hist::lower_bound(b), 1 + v / 16);
+    }
+    EXPECT_EQ(hist::bucket(~std::uint64_t(0)), hist::num_buckets - 1);
+
+    hist h;
+    EXPECT_EQ(h.quantile(0.5), 0u);
+    for (std::uint64_t v = 1; v <= 1000; ++v) h.add(v * 1000);
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.max(), 1000000u);
+    EXPECT_NEAR(h.quantile(0.5), 500000.0, 500000.0 / 16);
+    EXPECT_NEAR(h.quantile(0.99), 990000.0, 990000.0 / 16);
+    EXPECT_EQ(h.quantile(1.0), h.max());
+
+    hist g;
+    g.add(5);
+    g += h;
+    EXPECT_EQ(g.count(), 1001u);
+    EXPECT_EQ(g.max(), h.max());
+}
+
+TEST_F(mpi_test_fixture, communicator_latency)
+{
+    setenv("OOMPH_TIMING", "1", 1);
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_TIMING");
+    auto           comm = ctxt.get_communicator();
+    auto const     speer = (comm.rank() + 1) % comm.size();
+    auto const     rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+    exchange(comm);
+
+    std::uint64_t const n = NITERS * NMSGS;
+    auto const          l = comm.latency();
+    ASSERT_EQ(l.size(), (std::size_t)comm.size());
+    for (int r = 0; r < comm.size(); ++r)
+    {
+        EXPECT_EQ(l[r].send.count(), r == speer ? n : 0);
+        EXPECT_EQ(l[r].recv.count(), r == rpeer ? n : 0);
+    }
+    auto const& h = l[rpeer].recv;
+    EXPECT_LE(h.quantile(0.5), h.quantile(0.99));
+    EXPECT_LE(h.quantile(0.99), h.max());
+
+    // receives from any source are not attributed to a peer
+    auto rmsg = comm.make_buffer<rank_type>(SIZE);
+    auto smsg = comm.make_buffer<rank_type>(SIZE);
+    auto req = comm.recv(rmsg, oomph::communicator::any_source, 1000);
+    comm.send(smsg, speer, 1000).wait();
+    req.wait();
+    EXPECT_EQ(comm.latency()[rpeer].recv.count(), n);
+}
+
+TEST_F(mpi_test_fixture, latency_report)
+{
+    setenv("OOMPH_TIMING", "1", 1);
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_TIMING");
+    {
+        // released communicators still count
+        auto comm = ctxt.get_communicator();
+        exchange(comm);
+    }
+    auto comm = ctxt.get_communicator();
+    exchange(comm);
+    auto const speer = (comm.rank() + 1) % comm.size();
+    EXPECT_EQ(ctxt.latency()[speer].send.count(), 2u * NITERS * NMSGS);
+
+    std::ostringstream os;
+    oomph::print_latency_report(ctxt, os);
+    if (comm.rank() == 0)
+    {
+        auto const report = os.str();
+        EXPECT_NE(report.find("send latency p50 [us]"), std::string::npos);
+        EXPECT_NE(report.find("recv latency max [us]"), std::string::npos);
+        EXPECT_NE(report.find("slowest recv links"), std::string::npos);
+    }
+    else
+        EXPECT_TRUE(os.str().empty());
+}
+
+// latencies are only recorded with OOMPH_TIMING
+TEST_F(mpi_test_fixture, latency_disabled)
+{
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    auto           comm = ctxt.get_communicator();
+    exchange(comm);
+    for (auto const& l : comm.latency())
+    {
+        EXPECT_EQ(l.send.count(), 0u);
+        EXPECT_EQ(l.recv.count(), 0u);
+    }
+}
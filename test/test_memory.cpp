@@ -0,0 +1,106 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+#define SIZE  (1 << 20)
+#define NMSGS 300
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+std::uint64_t
+registered(oomph::memory_stats const& s)
+{
+    std::uint64_t n = 0;
+    for (auto const& x : s.registered_host) n += x.current;
+    return n;
+}
+
+void
+expect_consistent(oomph::high_water const& x)
+{
+    EXPECT_LE(x.current, x.peak);
+}
+
+void
+expect_consistent(oomph::memory_stats const& s)
+{
+    for (auto const& x : s.registered_host) expect_consistent(x);
+    for (auto const& x : s.registered_device) expect_consistent(x);
+    expect_consistent(s.rma);
+    expect_consistent(s.addresses);
+    expect_consistent(s.request_pools);
+    expect_consistent(s.queues);
+    expect_consistent(s.total);
+    expect_consistent(s.workers);
+    expect_consistent(s.endpoints);
+    EXPECT_GE(s.total.current, registered(s) + s.rma.current + s.addresses.current +
+                                   s.request_pools.current + s.queues.current);
+}
+
+TEST_F(mpi_test_fixture, memory)
+{
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    auto const     before = ctxt.memory();
+    expect_consistent(before);
+
+    {
+        auto       comm = ctxt.get_communicator();
+        auto const speer = (comm.rank() + 1) % comm.size();
+        auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+        // user memory is registered as well
+        std::vector<rank_type> user(SIZE);
+        auto                   umsg = ctxt.make_buffer<rank_type>(user.data(), user.size());
+        auto                   smsg = comm.make_buffer<rank_type>(SIZE);
+        auto                   rmsg = comm.make_buffer<rank_type>(SIZE);
+        auto const             with_buffers = ctxt.memory();
+        EXPECT_GE(registered(with_buffers), registered(before) + 3 * SIZE * sizeof(rank_type));
+        expect_consistent(with_buffers);
+
+        // more requests than fit into the first chunk of the request pool
+        std::vector<message>            smsgs, rmsgs;
+        std::vector<oomph::send_request> sreqs;
+        std::vector<oomph::recv_request> rreqs;
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            smsgs.push_back(comm.make_buffer<rank_type>(1));
+            rmsgs.push_back(comm.make_buffer<rank_type>(1));
+        }
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            rreqs.push_back(comm.recv(rmsgs[i], rpeer, i));
+            sreqs.push_back(comm.send(smsgs[i], speer, i));
+        }
+        for (auto& r : rreqs) r.wait();
+        for (auto& r : sreqs) r.wait();
+
+        auto const with_requests = ctxt.memory();
+        EXPECT_GT(with_requests.request_pools.current, 0u);
+        EXPECT_GT(with_requests.queues.peak, 0u);
+        expect_consistent(with_requests);
+
+        std::ostringstream os;
+        with_requests.print(os);
+        EXPECT_NE(os.str().find("request pools:"), std::string::npos);
+    }
+
+    // the communicator and its buffers are gone, the high-water marks remain
+    auto const after = ctxt.memory();
+    expect_consistent(after);
+    EXPECT_EQ(after.request_pools.current, 0u);
+    EXPECT_EQ(after.queues.current, 0u);
+    EXPECT_GE(after.total.peak, registered(before) + 3 * SIZE * sizeof(rank_type));
+}
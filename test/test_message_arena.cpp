@@ -0,0 +1,147 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/message_arena.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <cstdint>
+#include <vector>
+
+#define NITERS 5
+#define NHALOS 6
+
+std::size_t
+halo_size(int h)
+{
+    return 10 + 17 * h;
+}
+
+TEST_F(mpi_test_fixture, message_view)
+{
+    using namespace oomph;
+    auto ctxt = context(MPI_COMM_WORLD, false);
+    auto comm = ctxt.get_communicator();
+
+    const auto dst = (comm.rank() + 1) % comm.size();
+    const auto src = (comm.rank() + comm.size() - 1) % comm.size();
+
+    auto smsg = comm.make_buffer<int>(100);
+    auto rmsg = comm.make_buffer<int>(100);
+    for (int i = 0; i < 100; ++i) smsg[i] = comm.rank() * 1000 + i;
+    for (auto& x : rmsg) x = -1;
+
+    // send elements [20, 50) into [60, 90)
+    message_view<int> sv(smsg, 20, 30);
+    message_view<int> rv(rmsg, 60, 30);
+    EXPECT_EQ(sv.size(), 30u);
+    EXPECT_EQ(sv.data(), smsg.data() + 20);
+
+    auto rreq = comm.recv(rv, src, 0);
+    comm.send(sv, dst, 0).wait();
+    rreq.wait();
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i >= 60 && i < 90) EXPECT_EQ(rmsg[i], src * 1000 + i - 40);
+        else
+            EXPECT_EQ(rmsg[i], -1);
+    }
+
+    // callback versions
+    bool received = false;
+    bool sent = false;
+    rreq = comm.recv(message_view<int>(rmsg, 0, 10), src, 1,
+        [&received, &rmsg](message_view<int> v, int, int)
+        {
+            EXPECT_EQ(v.data(), rmsg.data());
+            received = true;
+        });
+    comm.send(message_view<int>(smsg, 90, 10), dst, 1,
+        [&sent](message_view<int>, int, int) { sent = true; });
+    comm.wait_all();
+    EXPECT_TRUE(received);
+    EXPECT_TRUE(sent);
+    for (int i = 0; i < 10; ++i) EXPECT_EQ(rmsg[i], src * 1000 + 90 + i);
+}
+
+TEST_F(mpi_test_fixture, message_arena)
+{
+    using namespace oomph;
+    auto ctxt = context(MPI_COMM_WORLD, false);
+    auto comm = ctxt.get_communicator();
+
+    const auto dst = (comm.rank() + 1) % comm.size();
+    const auto src = (comm.rank() + comm.size() - 1) % comm.size();
+
+    const auto capacity = 2 * message_arena::required_capacity<double>(halo_size(NHALOS), NHALOS);
+    message_arena s_arena(comm, capacity);
+    message_arena r_arena(ctxt, capacity);
+    EXPECT_EQ(s_arena.capacity(), capacity);
+
+    for (int it = 0; it < NITERS; ++it)
+    {
+        s_arena.reset();
+        r_arena.reset();
+        EXPECT_EQ(s_arena.used(), 0u);
+
+        std::vector<message_view<double>> svs, rvs;
+        std::vector<recv_request>         rreqs;
+        std::vector<send_request>         sreqs;
+        for (int h = 0; h < NHALOS; ++h)
+        {
+            svs.push_back(s_arena.make_view<double>(halo_size(h)));
+            rvs.push_back(r_arena.make_view<double>(halo_size(h)));
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(svs.back().data()) %
+                          message_arena::alignment,
+                0u);
+            for (std::size_t i = 0; i < svs[h].size(); ++i)
+                svs[h][i] = comm.rank() * 10000 + it * 1000 + h * 100 + i;
+            for (auto& x : rvs[h]) x = -1;
+        }
+        for (int h = 0; h < NHALOS; ++h) rreqs.push_back(comm.recv(rvs[h], src, h));
+        for (int h = 0; h < NHALOS; ++h) sreqs.push_back(comm.send(svs[h], dst, h));
+        for (auto& r : sreqs) r.wait();
+        for (auto& r : rreqs) r.wait();
+
+        for (int h = 0; h < NHALOS; ++h)
+            for (std::size_t i = 0; i < rvs[h].size(); ++i)
+                EXPECT_EQ(rvs[h][i], src * 10000 + it * 1000 + h * 100 + i);
+
+        // all halos of the step as one iov message
+        std::vector<iov_element> s_iov(svs.begin(), svs.end());
+        std::vector<iov_element> r_iov(rvs.begin(), rvs.end());
+        for (auto& v : rvs)
+            for (auto& x : v) x = -1;
+        auto rreq = comm.recv_iov(r_iov, src, NHALOS);
+        comm.send_iov(s_iov, dst, NHALOS).wait();
+        rreq.wait();
+        for (int h = 0; h < NHALOS; ++h)
+            for (std::size_t i = 0; i < rvs[h].size(); ++i)
+                EXPECT_EQ(rvs[h][i], src * 10000 + it * 1000 + h * 100 + i);
+    }
+
+    // views stay valid when the arena is moved
+    s_arena.reset();
+    r_arena.reset();
+    auto          sv = s_arena.make_view<double>(10);
+    auto          rv = r_arena.make_view<double>(10);
+    message_arena s_moved(std::move(s_arena));
+    message_arena r_moved;
+    r_moved = std::move(r_arena);
+    EXPECT_GE(s_moved.used(), 10 * sizeof(double));
+    for (int i = 0; i < 10; ++i) sv[i] = comm.rank() * 100 + i;
+    auto rreq = comm.recv(rv, src, 0);
+    comm.send(sv, dst, 0).wait();
+    rreq.wait();
+    for (int i = 0; i < 10; ++i) EXPECT_EQ(rv[i], src * 100 + i);
+
+    message_arena small(comm, 16);
+    EXPECT_THROW(small.make_view<double>(100), std::runtime_error);
+    EXPECT_THROW(message_arena{}.make_view<double>(1), std::runtime_error);
+}
@@ -0,0 +1,137 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "../src/recorder.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NITERS 4
+#define SIZE   64
+#define NMSGS  8
+// four records each: more than fit into two chunks
+#define NEXCHANGES (oomph::record_stream::chunk_size / 2 + 1)
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+std::chrono::milliseconds const compute(20);
+std::uint64_t const             compute_ns = 15'000'000; // allowing for timer slack
+
+TEST_F(mpi_test_fixture, record)
+{
+    std::string const prefix = "oomph_test_record";
+    setenv("OOMPH_RECORD", prefix.c_str(), 1);
+    int rank, size, speer, rpeer;
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        auto           comm = ctxt.get_communicator();
+        auto           comm2 = ctxt.get_communicator();
+        rank = comm.rank();
+        size = comm.size();
+        speer = (rank + 1) % size;
+        rpeer = (rank + size - 1) % size;
+
+        std::vector<message> smsgs, rmsgs;
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+            rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        }
+        for (int it = 0; it < NITERS; ++it)
+        {
+            std::this_thread::sleep_for(compute);
+            for (int i = 0; i < NMSGS; ++i)
+                comm.recv(rmsgs[i], rpeer, i, [](message&, int, int) {});
+            for (int i = 0; i < NMSGS; ++i) comm.send_detached(smsgs[i], speer, i);
+            comm.wait_all();
+        }
+
+        // exchanges on the second communicator, filling several chunks of the recording
+        for (std::size_t i = 0; i < NEXCHANGES; ++i)
+        {
+            auto r = comm2.recv(rmsgs[0], rpeer, NMSGS);
+            comm2.send(smsgs[0], speer, NMSGS).wait();
+            r.wait();
+        }
+    }
+    unsetenv("OOMPH_RECORD");
+
+    // the recording is written once the context is destroyed
+    std::ifstream in(prefix + "." + std::to_string(rank) + ".rec", std::ios::binary);
+    EXPECT_TRUE(in.good());
+    oomph::record_file_header h;
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    EXPECT_EQ(std::memcmp(h.m_magic, oomph::record_file_header::magic, 8), 0);
+    EXPECT_EQ(h.m_rank, rank);
+    EXPECT_EQ(h.m_size, size);
+    EXPECT_EQ(h.m_version, oomph::record_file_header::current_version);
+    EXPECT_EQ(h.m_num_streams, 2u);
+
+    // the records of both streams, written in chunks
+    std::vector<oomph::record_entry> records[2];
+    std::size_t                      num_chunks[2] = {0, 0};
+    while ((std::uint64_t)in.tellg() < h.m_streams_offset)
+    {
+        oomph::record_chunk_header ch;
+        in.read(reinterpret_cast<char*>(&ch), sizeof(ch));
+        ASSERT_TRUE(in.good());
+        ASSERT_LT(ch.m_stream, 2u);
+        EXPECT_LE(ch.m_num_records, oomph::record_stream::chunk_size);
+        auto& r = records[ch.m_stream];
+        r.resize(r.size() + ch.m_num_records);
+        in.read(reinterpret_cast<char*>(r.data() + r.size() - ch.m_num_records),
+            ch.m_num_records * sizeof(oomph::record_entry));
+        ++num_chunks[ch.m_stream];
+    }
+    EXPECT_EQ(num_chunks[0], 1u);
+    EXPECT_EQ(num_chunks[1], 3u);
+
+    std::size_t const num_ops[2] = {2 * NITERS * NMSGS, 2 * NEXCHANGES};
+    // the computation shows up as gaps before the first receive of every iteration, the second
+    // communicator is idle until the end (other gaps may be long too when oversubscribed)
+    auto const after_compute = [](int s, std::size_t op)
+    { return s == 0 ? (op - 1) % (2 * NMSGS) == 0 : op == 1; };
+    for (int s = 0; s < 2; ++s)
+    {
+        oomph::record_stream_header sh;
+        in.read(reinterpret_cast<char*>(&sh), sizeof(sh));
+        EXPECT_EQ(sh.m_num_ops, num_ops[s]);
+        EXPECT_EQ(sh.m_num_records, 2 * num_ops[s]);
+        EXPECT_EQ(records[s].size(), sh.m_num_records);
+        EXPECT_TRUE(in.good());
+
+        // every operation is posted, then completed once
+        std::vector<int> state(sh.m_num_ops + 1, 0);
+        for (auto const& r : records[s])
+        {
+            ASSERT_GE(r.m_op, 1u);
+            ASSERT_LE(r.m_op, sh.m_num_ops);
+            if (r.m_kind == oomph::record_kind::complete)
+            {
+                EXPECT_EQ(state[r.m_op], 1);
+                state[r.m_op] = 2;
+                continue;
+            }
+            EXPECT_EQ(state[r.m_op], 0);
+            state[r.m_op] = 1;
+            EXPECT_EQ(r.m_bytes, SIZE * sizeof(rank_type));
+            EXPECT_EQ(r.m_peer, r.m_kind == oomph::record_kind::send ? speer : rpeer);
+            if (after_compute(s, r.m_op)) { EXPECT_GE(r.m_gap_ns, compute_ns); }
+        }
+        for (std::size_t i = 1; i <= sh.m_num_ops; ++i) EXPECT_EQ(state[i], 2);
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <cstdlib>
+#include <vector>
+
+#define NITERS 20
+#define SIZE   4096
+
+// wrap overlapping sub-ranges of long-lived arrays every iteration
+void
+exchange_sub_ranges(oomph::context& ctxt)
+{
+    auto       comm = ctxt.get_communicator();
+    const auto dst = (comm.rank() + 1) % comm.size();
+    const auto src = (comm.rank() + comm.size() - 1) % comm.size();
+
+    std::vector<int> s_field(SIZE);
+    std::vector<int> r_field(SIZE);
+
+    for (int it = 0; it < NITERS; ++it)
+    {
+        // whole array, a range in the middle, and a range extending beyond earlier ones
+        const std::size_t offsets[] = {0, 100 + (std::size_t)it, SIZE / 2};
+        const std::size_t counts[] = {SIZE, 1000, SIZE / 2};
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int i = 0; i < SIZE; ++i) s_field[i] = comm.rank() * 100000 + it * 10 + k + i;
+            for (auto& x : r_field) x = -1;
+            const auto o = offsets[k];
+            const auto n = counts[k];
+
+            auto smsg = comm.make_buffer<int>(s_field.data() + o, n);
+            auto rmsg = ctxt.make_buffer<int>(r_field.data() + o, n);
+            EXPECT_EQ(smsg.data(), s_field.data() + o);
+            EXPECT_EQ(rmsg.data(), r_field.data() + o);
+            EXPECT_EQ(smsg.size(), n);
+
+            auto rreq = comm.recv(rmsg, src, k);
+            comm.send(smsg, dst, k).wait();
+            rreq.wait();
+            for (std::size_t i = 0; i < SIZE; ++i)
+            {
+                if (i >= o && i < o + n) EXPECT_EQ(r_field[i], src * 100000 + it * 10 + k + i);
+                else
+                    EXPECT_EQ(r_field[i], -1);
+            }
+        }
+    }
+
+    // memory which is freed and reallocated
+    for (int it = 0; it < NITERS; ++it)
+    {
+        std::vector<int> s(SIZE, comm.rank() + it);
+        std::vector<int> r(SIZE, -1);
+        {
+            auto smsg = comm.make_buffer<int>(s.data(), SIZE);
+            auto rmsg = comm.make_buffer<int>(r.data(), SIZE);
+            auto rreq = comm.recv(rmsg, src, 0);
+            comm.send(smsg, dst, 0).wait();
+            rreq.wait();
+        }
+        for (auto x : r) EXPECT_EQ(x, src + it);
+        ctxt.invalidate_registrations(s.data(), SIZE * sizeof(int));
+        ctxt.invalidate_registrations(r.data(), SIZE * sizeof(int));
+    }
+}
+
+TEST_F(mpi_test_fixture, registration_cache)
+{
+    setenv("OOMPH_REGISTRATION_CACHE_SIZE", "1G", 1);
+    auto ctxt = oomph::context(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_REGISTRATION_CACHE_SIZE");
+    exchange_sub_ranges(ctxt);
+}
+
+TEST_F(mpi_test_fixture, registration_cache_eviction)
+{
+    // smaller than the arrays: wrapped memory is registered without caching, and smaller ranges
+    // are evicted
+    setenv("OOMPH_REGISTRATION_CACHE_SIZE", "8K", 1);
+    auto ctxt = oomph::context(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_REGISTRATION_CACHE_SIZE");
+    exchange_sub_ranges(ctxt);
+}
+
+TEST_F(mpi_test_fixture, registration_cache_disabled)
+{
+    setenv("OOMPH_REGISTRATION_CACHE_SIZE", "0", 1);
+    auto ctxt = oomph::context(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_REGISTRATION_CACHE_SIZE");
+    exchange_sub_ranges(ctxt);
+}
+
+// disabled by default: wrapped memory which is freed and reused needs no invalidation
+TEST_F(mpi_test_fixture, registration_cache_default)
+{
+    auto       ctxt = oomph::context(MPI_COMM_WORLD, false);
+    auto       comm = ctxt.get_communicator();
+    const auto dst = (comm.rank() + 1) % comm.size();
+    const auto src = (comm.rank() + comm.size() - 1) % comm.size();
+    for (int it = 0; it < NITERS; ++it)
+    {
+        std::vector<int> s(SIZE, comm.rank() + it);
+        std::vector<int> r(SIZE, -1);
+        auto             smsg = comm.make_buffer<int>(s.data(), SIZE);
+        auto             rmsg = comm.make_buffer<int>(r.data(), SIZE);
+        auto             rreq = comm.recv(rmsg, src, 0);
+        comm.send(smsg, dst, 0).wait();
+        rreq.wait();
+        for (auto x : r) EXPECT_EQ(x, src + it);
+    }
+}
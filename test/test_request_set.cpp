@@ -0,0 +1,124 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "./ring_environment.hpp"
+#include <vector>
+
+#define NITERS 20
+#define SIZE   64
+#define NMSGS  8
+
+struct test_environment : public ring_environment
+{
+    std::vector<oomph::send_request> sreqs;
+    std::vector<oomph::recv_request> rreqs;
+
+    test_environment()
+    : ring_environment(NMSGS, SIZE)
+    , sreqs(NMSGS)
+    , rreqs(NMSGS)
+    {
+    }
+
+    void post(int it)
+    {
+        fill_recv_buffers();
+        for (int i = 0; i < NMSGS; ++i) rreqs[i] = comm.recv(rmsgs[i], rpeer_rank, it * NMSGS + i);
+        for (int i = 0; i < NMSGS; ++i) sreqs[i] = comm.send(smsgs[i], speer_rank, it * NMSGS + i);
+    }
+};
+
+TEST_F(mpi_test_fixture, wait_some)
+{
+    test_environment env;
+    auto&            comm = env.comm;
+
+    std::vector<std::size_t> indices(NMSGS);
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.post(it);
+        std::vector<int> completed(NMSGS, 0);
+        int              num_completed = 0;
+        while (std::size_t n = comm.wait_some(env.rreqs, indices))
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                ASSERT_LT(indices[k], (std::size_t)NMSGS);
+                EXPECT_EQ(completed[indices[k]]++, 0);
+                EXPECT_TRUE(env.check_recv_buffer(indices[k]));
+            }
+            num_completed += n;
+        }
+        EXPECT_EQ(num_completed, NMSGS);
+        while (comm.wait_some(env.sreqs, indices)) {}
+        EXPECT_TRUE(comm.is_ready());
+    }
+}
+
+TEST_F(mpi_test_fixture, test_some)
+{
+    test_environment env;
+    auto&            comm = env.comm;
+
+    // fewer slots than requests: the remaining completions are reported by later calls
+    std::size_t indices[3];
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.post(it);
+        std::vector<int> completed(NMSGS, 0);
+        int              num_completed = 0;
+        while (num_completed < NMSGS)
+        {
+            auto const n = comm.test_some(env.rreqs, indices);
+            EXPECT_LE(n, 3u);
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                EXPECT_EQ(completed[indices[k]]++, 0);
+                EXPECT_TRUE(env.check_recv_buffer(indices[k]));
+            }
+            num_completed += n;
+        }
+        EXPECT_EQ(comm.test_some(env.rreqs, indices), 0u);
+        comm.wait_all();
+        EXPECT_EQ(comm.test_some(env.sreqs, indices), 3u);
+        EXPECT_EQ(comm.test_some(env.sreqs, indices), 3u);
+        EXPECT_EQ(comm.test_some(env.sreqs, indices), 2u);
+        EXPECT_EQ(comm.test_some(env.sreqs, indices), 0u);
+    }
+}
+
+TEST_F(mpi_test_fixture, wait_any)
+{
+    test_environment env;
+    auto&            comm = env.comm;
+
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.post(it);
+        std::vector<int> completed(NMSGS, 0);
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            auto const index = comm.wait_any(env.rreqs);
+            ASSERT_LT(index, (std::size_t)NMSGS);
+            EXPECT_EQ(completed[index]++, 0);
+            EXPECT_TRUE(env.check_recv_buffer(index));
+        }
+        EXPECT_EQ(comm.wait_any(env.rreqs), (std::size_t)NMSGS);
+        for (int i = 0; i < NMSGS; ++i) comm.wait_any(env.sreqs);
+        EXPECT_EQ(comm.wait_any(env.sreqs), (std::size_t)NMSGS);
+        EXPECT_TRUE(comm.is_ready());
+    }
+
+    // empty set
+    std::vector<oomph::recv_request> none;
+    EXPECT_EQ(comm.wait_any(none), 0u);
+}
@@ -233,6 +233,49 @@ TEST_F(mpi_test_fixture, send_recv)
 #endif
 }
 
+// detached send, dropped requests
+// ===============================
+template<typename Env>
+void
+test_send_detached(oomph::context& ctxt, std::size_t size, int tid, int num_threads,
+    bool user_alloc)
+{
+    Env env(ctxt, size, tid, num_threads, user_alloc);
+
+    // no request: completion is only visible through scheduled_sends()
+    for (int i = 0; i < NITERS; i++)
+    {
+        auto rreq = env.comm.recv(env.rmsg, env.rpeer_rank, env.tag);
+        env.comm.send_detached(env.smsg, env.speer_rank, env.tag);
+        EXPECT_LE(env.comm.scheduled_sends(), 1u);
+        rreq.wait();
+        while (env.comm.scheduled_sends()) { env.comm.progress(); }
+        EXPECT_TRUE(env.check_recv_buffer());
+        env.fill_recv_buffer();
+    }
+
+    // the send request is discarded before completion
+    for (int i = 0; i < NITERS; i++)
+    {
+        auto rreq = env.comm.recv(env.rmsg, env.rpeer_rank, env.tag);
+        {
+            auto sreq = env.comm.send(env.smsg, env.speer_rank, env.tag);
+        }
+        rreq.wait();
+        env.comm.wait_all();
+        EXPECT_TRUE(env.check_recv_buffer());
+        env.fill_recv_buffer();
+    }
+}
+
+TEST_F(mpi_test_fixture, send_detached)
+{
+    launch_test(test_send_detached<test_environment>);
+#if HWMALLOC_ENABLE_DEVICE
+    launch_test(test_send_detached<test_environment_device>);
+#endif
+}
+
 // callback: pass by l-value reference
 // ===================================
 template<typename Env>
@@ -0,0 +1,103 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <vector>
+#include <cstring>
+
+#define NITERS 10
+#define SIZE   64
+
+const std::size_t wire_size = 8 * sizeof(int) + SIZE * sizeof(double);
+
+int
+header_value(int rank, int it, int i)
+{
+    return rank * 1000 + it * 10 + i;
+}
+
+double
+body_value(int rank, int it, int i)
+{
+    return rank * 1000.0 + it + i;
+}
+
+// wire layout: 4 header ints, SIZE doubles taken from the middle of the body, 4 header ints
+std::vector<char>
+expected_wire(int rank, int it)
+{
+    int    h[8];
+    double b[SIZE];
+    for (int i = 0; i < 8; ++i) h[i] = header_value(rank, it, i);
+    for (int i = 0; i < SIZE; ++i) b[i] = body_value(rank, it, SIZE + i);
+    std::vector<char> w(wire_size);
+    std::memcpy(w.data(), h, 4 * sizeof(int));
+    std::memcpy(w.data() + 4 * sizeof(int), b, SIZE * sizeof(double));
+    std::memcpy(w.data() + 4 * sizeof(int) + SIZE * sizeof(double), h + 4, 4 * sizeof(int));
+    return w;
+}
+
+TEST_F(mpi_test_fixture, send_recv_iov)
+{
+    using namespace oomph;
+    auto ctxt = context(MPI_COMM_WORLD, false);
+    auto comm = ctxt.get_communicator();
+
+    const auto dst = (comm.rank() + 1) % comm.size();
+    const auto src = (comm.rank() + comm.size() - 1) % comm.size();
+
+    auto s_header = comm.make_buffer<int>(8);
+    auto s_body = comm.make_buffer<double>(3 * SIZE);
+    auto r_header = comm.make_buffer<int>(8);
+    auto r_body = comm.make_buffer<double>(SIZE);
+    auto s_flat = comm.make_buffer<char>(wire_size);
+    auto r_flat = comm.make_buffer<char>(wire_size);
+
+    for (int it = 0; it < NITERS; ++it)
+    {
+        for (int i = 0; i < 8; ++i) s_header[i] = header_value(comm.rank(), it, i);
+        for (int i = 0; i < 3 * SIZE; ++i) s_body[i] = body_value(comm.rank(), it, i);
+        const auto expected = expected_wire(src, it);
+
+        // iov to contiguous
+        std::memset(r_flat.data(), 0, wire_size);
+        auto rreq = comm.recv(r_flat, src, it);
+        auto sreq = comm.send_iov({{s_header, 0, 4}, {s_body, SIZE, SIZE}, {s_header, 4, 4}}, dst,
+            it);
+        sreq.wait();
+        rreq.wait();
+        EXPECT_EQ(std::memcmp(r_flat.data(), expected.data(), wire_size), 0);
+
+        // iov to iov with different piece boundaries: the receiver stores the wire rotated
+        const std::size_t half = wire_size / 2 + 3;
+        std::memset(r_flat.data(), 0, wire_size);
+        rreq = comm.recv_iov({{r_flat, half, wire_size - half}, {r_flat, 0, half}}, src, it);
+        sreq = comm.send_iov({{s_header, 0, 4}, {s_body, SIZE, SIZE}, {s_header, 4, 4}}, dst, it);
+        sreq.wait();
+        rreq.wait();
+        EXPECT_EQ(std::memcmp(r_flat.data() + half, expected.data(), wire_size - half), 0);
+        EXPECT_EQ(std::memcmp(r_flat.data(), expected.data() + wire_size - half, half), 0);
+
+        // contiguous to iov
+        const auto own = expected_wire(comm.rank(), it);
+        std::memcpy(s_flat.data(), own.data(), wire_size);
+        for (auto& x : r_header) x = -1;
+        for (auto& x : r_body) x = -1;
+        rreq = comm.recv_iov({{r_header, 0, 4}, r_body, {r_header, 4, 4}}, src, it);
+        comm.send(s_flat, dst, it).wait();
+        rreq.wait();
+        for (int i = 0; i < 8; ++i) EXPECT_EQ(r_header[i], header_value(src, it, i));
+        for (int i = 0; i < SIZE; ++i) EXPECT_EQ(r_body[i], body_value(src, it, SIZE + i));
+
+        EXPECT_EQ(comm.scheduled_sends(), 0u);
+        EXPECT_EQ(comm.scheduled_recvs(), 0u);
+    }
+}
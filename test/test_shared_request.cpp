@@ -0,0 +1,152 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "./ring_environment.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define NITERS 20
+#define SIZE   64
+#define NMSGS  8
+
+TEST_F(mpi_test_fixture, shared_request)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.fill_recv_buffers();
+        auto rreq = comm.recv_shared(env.rmsgs[0], env.rpeer_rank, it);
+        auto sreq = comm.send_shared(env.smsgs[0], env.speer_rank, it);
+        auto copy = rreq;
+        copy.wait();
+        EXPECT_TRUE(rreq.is_ready());
+        EXPECT_TRUE(env.check_recv_buffer(0));
+        while (!sreq.test()) {}
+    }
+    EXPECT_TRUE(comm.is_ready());
+}
+
+TEST_F(mpi_test_fixture, shared_request_other_thread)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+
+    // another thread waits for the receives while this thread progresses the communicator
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.fill_recv_buffers();
+        std::vector<oomph::shared_request> rreqs;
+        for (int i = 0; i < NMSGS; ++i)
+            rreqs.push_back(comm.recv_shared(env.rmsgs[i], env.rpeer_rank, i));
+
+        std::atomic<int> num_correct{0};
+        std::thread      t(
+            [&]()
+            {
+                for (int i = 0; i < NMSGS; ++i)
+                {
+                    rreqs[i].wait();
+                    if (env.check_recv_buffer(i)) ++num_correct;
+                }
+            });
+
+        for (int i = 0; i < NMSGS; ++i) comm.send_detached(env.smsgs[i], env.speer_rank, i);
+        comm.wait_all();
+        t.join();
+        EXPECT_EQ(num_correct.load(), NMSGS);
+    }
+}
+
+TEST_F(mpi_test_fixture, shared_request_then)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+
+    int  received = 0;
+    auto rreq = comm.recv_shared(env.rmsgs[0], env.rpeer_rank, 0);
+    auto r1 = rreq.then([&received]() { ++received; });
+    auto r2 = r1.then([&received]() { received *= 10; });
+    comm.send(env.smsgs[0], env.speer_rank, 0).wait();
+    r2.wait();
+    EXPECT_EQ(received, 10);
+    EXPECT_TRUE(env.check_recv_buffer(0));
+
+    // continuation of a ready request runs immediately
+    bool done = false;
+    rreq.then([&done]() { done = true; });
+    EXPECT_TRUE(done);
+}
+
+TEST_F(mpi_test_fixture, shared_request_when_all_any)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.fill_recv_buffers();
+        std::vector<oomph::shared_request> rreqs;
+        for (int i = 0; i < NMSGS; ++i)
+            rreqs.push_back(comm.recv_shared(env.rmsgs[i], env.rpeer_rank, i));
+        auto all = oomph::when_all(rreqs);
+        auto any = oomph::when_any(rreqs);
+        EXPECT_FALSE(all.is_ready());
+
+        // the last message is sent first: when_any completes before when_all
+        comm.send(env.smsgs[NMSGS - 1], env.speer_rank, NMSGS - 1).wait();
+        any.wait();
+
+        for (int i = 0; i < NMSGS - 1; ++i) comm.send_detached(env.smsgs[i], env.speer_rank, i);
+        all.wait();
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            EXPECT_TRUE(rreqs[i].is_ready());
+            EXPECT_TRUE(env.check_recv_buffer(i));
+        }
+        comm.wait_all();
+    }
+
+    // empty sets
+    EXPECT_TRUE(oomph::when_all({}).is_ready());
+    EXPECT_TRUE(oomph::when_any({}).is_ready());
+}
+
+TEST_F(mpi_test_fixture, shared_request_two_communicators)
+{
+    ring_environment env(NMSGS, SIZE);
+    auto&            comm = env.comm;
+    auto             comm2 = env.ctxt.get_communicator();
+
+    // requests of both communicators are combined on the thread owning them: waiting and testing
+    // progresses both
+    for (int it = 0; it < NITERS; ++it)
+    {
+        env.fill_recv_buffers();
+        auto r0 = comm.recv_shared(env.rmsgs[0], env.rpeer_rank, it);
+        auto r1 = comm2.recv_shared(env.rmsgs[1], env.rpeer_rank, it);
+        auto s0 = comm.send_shared(env.smsgs[0], env.speer_rank, it);
+        auto s1 = comm2.send_shared(env.smsgs[1], env.speer_rank, it);
+        auto any = oomph::when_any({r0, r1});
+        auto all = oomph::when_all({any, r0, r1, s0, s1});
+        while (!any.test()) {}
+        if (it % 2) all.wait();
+        else
+            while (!all.test()) {}
+        EXPECT_TRUE(env.check_recv_buffer(0));
+        EXPECT_TRUE(env.check_recv_buffer(1));
+    }
+    EXPECT_TRUE(comm.is_ready());
+    EXPECT_TRUE(comm2.is_ready());
+}
@@ -0,0 +1,136 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define NITERS 10
+#define SIZE   64
+#define NMSGS  8
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+// NITERS rounds of NMSGS messages to the right neighbour, receives with callbacks
+void
+exchange(oomph::communicator& comm)
+{
+    auto const speer = (comm.rank() + 1) % comm.size();
+    auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+    std::vector<message> smsgs, rmsgs;
+    for (int i = 0; i < NMSGS; ++i)
+    {
+        smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+    }
+    for (int it = 0; it < NITERS; ++it)
+    {
+        for (int i = 0; i < NMSGS; ++i) comm.recv(rmsgs[i], rpeer, i, [](message&, int, int) {});
+        for (int i = 0; i < NMSGS; ++i) comm.send_detached(smsgs[i], speer, i);
+        comm.wait_all();
+    }
+}
+
+TEST_F(mpi_test_fixture, communicator_stats)
+{
+    setenv("OOMPH_TIMING", "1", 1);
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_TIMING");
+    auto           comm = ctxt.get_communicator();
+    auto const     speer = (comm.rank() + 1) % comm.size();
+    auto const     rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+    exchange(comm);
+
+    std::uint64_t const n = NITERS * NMSGS;
+    auto const s = comm.stats();
+    EXPECT_EQ(s.messages_sent, n);
+    EXPECT_EQ(s.bytes_sent, n * SIZE * sizeof(rank_type));
+    EXPECT_EQ(s.messages_received, n);
+    EXPECT_EQ(s.bytes_received, n * SIZE * sizeof(rank_type));
+    // operations may complete right away
+    EXPECT_GE(s.max_sends_in_flight, 1u);
+    EXPECT_LE(s.max_sends_in_flight, NMSGS + 0u);
+    EXPECT_GE(s.max_recvs_in_flight, 1u);
+    EXPECT_LE(s.max_recvs_in_flight, NMSGS + 0u);
+    EXPECT_GT(s.progress_calls, 0u);
+    EXPECT_LE(s.idle_progress_calls, s.progress_calls);
+    EXPECT_EQ(s.callbacks, n);
+    EXPECT_EQ(std::accumulate(s.callback_histogram.begin(), s.callback_histogram.end(), 0ull),
+        s.callbacks);
+    EXPECT_EQ(s.cancellations, 0u);
+
+    ASSERT_EQ(s.peers.size(), (std::size_t)comm.size());
+    for (int r = 0; r < comm.size(); ++r)
+    {
+        EXPECT_EQ(s.peers[r].messages_sent, r == speer ? n : 0);
+        EXPECT_EQ(s.peers[r].messages_received, r == rpeer ? n : 0);
+    }
+
+    // cancelled receives
+    auto msg = comm.make_buffer<rank_type>(SIZE);
+    auto req = comm.recv(msg, rpeer, 1000);
+    EXPECT_TRUE(req.cancel());
+    EXPECT_EQ(comm.stats().cancellations, 1u);
+    EXPECT_EQ(comm.stats().messages_received, n + 1);
+
+    std::ostringstream os;
+    s.print(os);
+    EXPECT_NE(os.str().find("messages sent:       80"), std::string::npos);
+}
+
+TEST_F(mpi_test_fixture, context_stats)
+{
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    {
+        // released communicators still count
+        auto comm = ctxt.get_communicator();
+        exchange(comm);
+    }
+    auto comm = ctxt.get_communicator();
+    exchange(comm);
+
+    auto const s = ctxt.stats();
+    EXPECT_EQ(s.messages_sent, 2u * NITERS * NMSGS);
+    EXPECT_EQ(s.messages_received, 2u * NITERS * NMSGS);
+    EXPECT_LE(s.max_recvs_in_flight, NMSGS + 0u);
+    EXPECT_EQ(s.callbacks, 2u * NITERS * NMSGS);
+    // callbacks are only timed with OOMPH_TIMING
+    EXPECT_EQ(std::accumulate(s.callback_histogram.begin(), s.callback_histogram.end(), 0ull), 0u);
+    EXPECT_EQ(comm.stats().messages_sent, NITERS * NMSGS + 0u);
+}
+
+TEST_F(mpi_test_fixture, stats_dump)
+{
+    std::string const prefix = "oomph_test_stats";
+    setenv("OOMPH_STATS_FILE", prefix.c_str(), 1);
+    int rank;
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        auto           comm = ctxt.get_communicator();
+        rank = comm.rank();
+        exchange(comm);
+    }
+    unsetenv("OOMPH_STATS_FILE");
+
+    // the last report is written when the context is destroyed
+    std::ifstream in(prefix + "." + std::to_string(rank) + ".txt");
+    ASSERT_TRUE(in.good());
+    std::string const report(
+        (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(report.find("# oomph statistics of rank " + std::to_string(rank)), std::string::npos);
+    EXPECT_NE(report.find("messages sent:       80"), std::string::npos);
+}
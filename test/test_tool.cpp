@@ -0,0 +1,151 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <oomph/tool.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define NITERS 10
+#define SIZE   64
+#define NMSGS  8
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+// events seen by the test tool
+struct tool_log
+{
+    void const*              context = nullptr;
+    void const*              comm = nullptr;
+    int                      contexts = 0;
+    int                      comms = 0;
+    int                      sends_posted = 0;
+    int                      recvs_posted = 0;
+    int                      sends_completed = 0;
+    int                      recvs_completed = 0;
+    int                      cancelled = 0;
+    std::size_t              progress_calls = 0;
+    std::size_t              bytes = 0;
+    int                      wrong_comm = 0;
+    void const*              phase_context = nullptr;
+    int                      setup_phases = 0; // reported before context_created
+    std::vector<std::string> phases;
+};
+
+oomph::tool::hooks
+make_hooks(tool_log& log)
+{
+    using namespace oomph::tool;
+    hooks h;
+    h.user_data = &log;
+    h.context_created = [](void* u, context_info const& i)
+    {
+        auto& l = *static_cast<tool_log*>(u);
+        ++l.contexts;
+        l.context = i.context;
+    };
+    h.context_destroyed = [](void* u, void const* c)
+    {
+        auto& l = *static_cast<tool_log*>(u);
+        if (c == l.context) --l.contexts;
+    };
+    h.communicator_created = [](void* u, void const* ctxt, void const* c)
+    {
+        auto& l = *static_cast<tool_log*>(u);
+        if (ctxt != l.context) ++l.wrong_comm;
+        ++l.comms;
+        l.comm = c;
+    };
+    h.communicator_destroyed = [](void* u, void const*)
+    { --static_cast<tool_log*>(u)->comms; };
+    h.posted = [](void* u, operation_info const& op)
+    {
+        auto& l = *static_cast<tool_log*>(u);
+        if (op.communicator != l.comm) ++l.wrong_comm;
+        ++(op.kind == operation_kind::send ? l.sends_posted : l.recvs_posted);
+        l.bytes += op.size;
+    };
+    h.completed = [](void* u, completion_info const& c)
+    {
+        auto& l = *static_cast<tool_log*>(u);
+        if (c.communicator != l.comm) ++l.wrong_comm;
+        ++(c.kind == operation_kind::send ? l.sends_completed : l.recvs_completed);
+    };
+    h.cancelled = [](void* u, void const*) { ++static_cast<tool_log*>(u)->cancelled; };
+    h.progressed = [](void* u, void const*, std::size_t)
+    { ++static_cast<tool_log*>(u)->progress_calls; };
+    h.phase = [](void* u, phase_info const& p)
+    {
+        auto& l = *static_cast<tool_log*>(u);
+        if (l.contexts == 0) ++l.setup_phases;
+        l.phase_context = p.context;
+        l.phases.push_back(p.name);
+    };
+    return h;
+}
+
+TEST_F(mpi_test_fixture, tool_hooks)
+{
+    tool_log log;
+    oomph::tool::attach_tool(make_hooks(log));
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        EXPECT_EQ(log.contexts, 1);
+        EXPECT_GT(log.setup_phases, 0);
+        EXPECT_EQ(log.phase_context, log.context);
+        EXPECT_NE(std::find(log.phases.begin(), log.phases.end(), "rank_topology"),
+            log.phases.end());
+        auto comm = ctxt.get_communicator();
+        EXPECT_EQ(log.comms, 1);
+        auto const speer = (comm.rank() + 1) % comm.size();
+        auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+        std::vector<message> smsgs, rmsgs;
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+            rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        }
+        for (int it = 0; it < NITERS; ++it)
+        {
+            for (int i = 0; i < NMSGS; ++i)
+                comm.recv(rmsgs[i], rpeer, i, [](message&, int, int) {});
+            for (int i = 0; i < NMSGS; ++i) comm.send_detached(smsgs[i], speer, i);
+            comm.wait_all();
+        }
+        EXPECT_EQ(log.sends_posted, NITERS * NMSGS);
+        EXPECT_EQ(log.recvs_posted, NITERS * NMSGS);
+        EXPECT_EQ(log.sends_completed, NITERS * NMSGS);
+        EXPECT_EQ(log.recvs_completed, NITERS * NMSGS);
+        EXPECT_EQ(log.bytes, 2u * NITERS * NMSGS * SIZE * sizeof(rank_type));
+        EXPECT_GT(log.progress_calls, 0u);
+
+        auto req = comm.recv(rmsgs[0], rpeer, 1000);
+        EXPECT_TRUE(req.cancel());
+        EXPECT_EQ(log.cancelled, 1);
+        EXPECT_EQ(log.recvs_completed, NITERS * NMSGS);
+        EXPECT_EQ(log.wrong_comm, 0);
+    }
+    EXPECT_EQ(log.comms, 0);
+    EXPECT_EQ(log.contexts, 0);
+    oomph::tool::detach_tool();
+
+    // nothing is reported without a tool
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        auto           comm = ctxt.get_communicator();
+        comm.progress();
+    }
+    EXPECT_EQ(log.contexts, 0);
+    EXPECT_EQ(log.recvs_posted, NITERS * NMSGS + 1);
+}
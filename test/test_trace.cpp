@@ -0,0 +1,113 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include "../src/trace_format.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define NITERS 10
+#define SIZE   64
+#define NMSGS  8
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+// runs an exchange with tracing enabled and returns the number of records per event type
+std::vector<std::size_t>
+traced_exchange(char const* sample)
+{
+    std::string const prefix = "oomph_test_trace";
+    setenv("OOMPH_TRACE_FILE", prefix.c_str(), 1);
+    setenv("OOMPH_TRACE_SAMPLE", sample, 1);
+    int rank, size;
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        auto           comm = ctxt.get_communicator();
+        rank = comm.rank();
+        size = comm.size();
+        auto const speer = (comm.rank() + 1) % comm.size();
+        auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+        std::vector<message> smsgs, rmsgs;
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+            rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        }
+        int received = 0;
+        for (int it = 0; it < NITERS; ++it)
+        {
+            for (int i = 0; i < NMSGS; ++i)
+                comm.recv(rmsgs[i], rpeer, i, [&received](message&, int, int) { ++received; });
+            for (int i = 0; i < NMSGS; ++i) comm.send_detached(smsgs[i], speer, i);
+            comm.wait_all();
+        }
+        EXPECT_EQ(received, NITERS * NMSGS);
+    }
+    unsetenv("OOMPH_TRACE_FILE");
+    unsetenv("OOMPH_TRACE_SAMPLE");
+
+    // the trace file is complete once the context is destroyed
+    std::vector<std::size_t> counts(10, 0);
+    std::ifstream in(prefix + "." + std::to_string(rank) + ".bin", std::ios::binary);
+    EXPECT_TRUE(in.good());
+    oomph::trace_file_header h;
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    EXPECT_EQ(std::memcmp(h.m_magic, oomph::trace_file_header::magic, 8), 0);
+    EXPECT_EQ(h.m_rank, rank);
+    EXPECT_EQ(h.m_dropped, 0u);
+    EXPECT_GT(h.m_ticks_per_ns, 0.0);
+    std::vector<oomph::trace_record> records(h.m_num_records);
+    in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(records[0]));
+    EXPECT_TRUE(in.good());
+    std::uint64_t last = 0;
+    for (auto const& r : records)
+    {
+        ++counts[(int)r.m_event];
+        EXPECT_GE(r.m_time, last);
+        last = r.m_time;
+        if (r.m_event == oomph::trace_event::post_send)
+        {
+            EXPECT_EQ(r.m_peer, (rank + 1) % size);
+            EXPECT_EQ(r.m_bytes, SIZE * sizeof(rank_type));
+        }
+    }
+    return counts;
+}
+
+TEST_F(mpi_test_fixture, trace)
+{
+    using e = oomph::trace_event;
+    auto  c = traced_exchange("1");
+    EXPECT_EQ(c[(int)e::post_send], NITERS * NMSGS);
+    EXPECT_EQ(c[(int)e::post_recv], NITERS * NMSGS);
+    EXPECT_EQ(c[(int)e::inject], 2 * NITERS * NMSGS);
+    EXPECT_EQ(c[(int)e::complete], 2 * NITERS * NMSGS);
+    // only the receives have callbacks
+    EXPECT_EQ(c[(int)e::callback_begin], NITERS * NMSGS);
+    EXPECT_EQ(c[(int)e::callback_end], NITERS * NMSGS);
+    EXPECT_GT(c[(int)e::progress_begin], 0u);
+    EXPECT_EQ(c[(int)e::progress_begin], c[(int)e::progress_end]);
+}
+
+TEST_F(mpi_test_fixture, trace_sampling)
+{
+    using e = oomph::trace_event;
+    auto  c = traced_exchange("4");
+    EXPECT_EQ(c[(int)e::post_send], NITERS * NMSGS / 4);
+    EXPECT_EQ(c[(int)e::post_recv], NITERS * NMSGS / 4);
+    EXPECT_EQ(c[(int)e::complete], NITERS * NMSGS / 2);
+    EXPECT_EQ(c[(int)e::callback_begin], c[(int)e::post_recv]);
+}
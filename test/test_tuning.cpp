@@ -0,0 +1,112 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define NITERS 10
+#define SIZE   64
+#define NMSGS  8
+
+namespace fs = std::filesystem;
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+void
+exchange(oomph::context& ctxt)
+{
+    auto       comm = ctxt.get_communicator();
+    auto const speer = (comm.rank() + 1) % comm.size();
+    auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+    std::vector<message> smsgs, rmsgs;
+    for (int i = 0; i < NMSGS; ++i)
+    {
+        smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+    }
+    for (int it = 0; it < NITERS; ++it)
+    {
+        std::vector<oomph::recv_request> reqs;
+        for (int i = 0; i < NMSGS; ++i)
+        {
+            for (auto& x : smsgs[i]) x = comm.rank() + it;
+            reqs.push_back(comm.recv(rmsgs[i], rpeer, i));
+            comm.send_detached(smsgs[i], speer, i);
+        }
+        for (auto& r : reqs) r.wait();
+        comm.wait_all();
+        for (int i = 0; i < NMSGS; ++i)
+            for (auto x : rmsgs[i]) EXPECT_EQ(x, rpeer + it);
+    }
+}
+
+std::string
+read_file(fs::path const& p)
+{
+    std::ifstream      is(p);
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+}
+
+TEST_F(mpi_test_fixture, tuning)
+{
+    fs::path const dir = "oomph_test_tuning";
+    if (world_rank == 0)
+    {
+        fs::remove_all(dir);
+        fs::create_directory(dir);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    setenv("OOMPH_TUNE", "1", 1);
+    setenv("OOMPH_TUNE_DIR", dir.c_str(), 1);
+
+    // the first context measures and writes the profile
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        exchange(ctxt);
+    }
+    fs::path profile;
+    if (world_rank == 0)
+    {
+        std::vector<fs::path> files;
+        for (auto const& e : fs::directory_iterator(dir)) files.push_back(e.path());
+        EXPECT_EQ(files.size(), 1u);
+        if (!files.empty()) profile = files[0];
+        EXPECT_EQ(profile.filename().string().rfind("oomph_tuning.", 0), 0u);
+        auto const content = read_file(profile);
+        EXPECT_NE(content.find("progress_spin "), std::string::npos);
+        EXPECT_NE(content.find("callback_threads "), std::string::npos);
+
+        // yield on every progress call from now on
+        std::ofstream(profile) << "progress_spin 1\ncallback_threads 1\n";
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // later contexts use the profile and leave it as is
+    {
+        oomph::context ctxt(MPI_COMM_WORLD, false);
+        exchange(ctxt);
+    }
+    if (world_rank == 0)
+    {
+        EXPECT_EQ(read_file(profile), "progress_spin 1\ncallback_threads 1\n");
+    }
+
+    unsetenv("OOMPH_TUNE");
+    unsetenv("OOMPH_TUNE_DIR");
+}
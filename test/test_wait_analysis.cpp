@@ -0,0 +1,108 @@
+/*
+ * ghex-org
+ *
+ * Copyright (c) 2014-2021, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <oomph/context.hpp>
+#include <gtest/gtest.h>
+#include "./mpi_runner/mpi_test_fixture.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#define NITERS 10
+#define SIZE   64
+#define NMSGS  8
+
+using rank_type = oomph::communicator::rank_type;
+using message = oomph::message_buffer<rank_type>;
+
+std::chrono::milliseconds const delay(50);
+std::uint64_t const             delay_ns = 40'000'000; // allowing for timer slack
+
+// a receive is accounted for once its time stamp has arrived, which may be after the message:
+// progresses until n receives from peer are
+oomph::communication_stats
+accounted(oomph::communicator& comm, int peer, std::uint64_t n)
+{
+    auto s = comm.stats();
+    for (int i = 0; i < 100000 && s.peers[peer].wait_samples + s.wait_unmatched < n; ++i)
+    {
+        comm.progress();
+        s = comm.stats();
+    }
+    return s;
+}
+
+TEST_F(mpi_test_fixture, wait_analysis)
+{
+    setenv("OOMPH_WAIT_ANALYSIS", "1", 1);
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_WAIT_ANALYSIS");
+    auto       comm = ctxt.get_communicator();
+    auto const rank = comm.rank();
+    auto const speer = (rank + 1) % comm.size();
+    auto const rpeer = (rank + comm.size() - 1) % comm.size();
+    auto       smsg = comm.make_buffer<rank_type>(SIZE);
+    auto       rmsg = comm.make_buffer<rank_type>(SIZE);
+
+    // rank 0 sends late
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto rreq = comm.recv(rmsg, rpeer, 0);
+    if (rank == 0) std::this_thread::sleep_for(delay);
+    comm.send(smsg, speer, 0).wait();
+    rreq.wait();
+
+    // rank 1 receives late
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto sreq = comm.send(smsg, speer, 1);
+    if (rank == 1) std::this_thread::sleep_for(delay);
+    comm.recv(rmsg, rpeer, 1, [](message&, int, int) {});
+    comm.wait_all();
+    sreq.wait();
+
+    auto const s = accounted(comm, rpeer, 2);
+    EXPECT_EQ(s.wait_unmatched, 0u);
+    for (int r = 0; r < comm.size(); ++r)
+    {
+        auto const& p = s.peers[r];
+        EXPECT_EQ(p.wait_samples, r == rpeer ? 2u : 0u);
+    }
+    // only rank 1 waited for a late sender and received late
+    auto const& p = s.peers[rpeer];
+    EXPECT_EQ(p.late_sender_ns >= delay_ns, rank == 1);
+    EXPECT_EQ(p.late_receiver_ns >= delay_ns, rank == 1);
+}
+
+TEST_F(mpi_test_fixture, wait_analysis_sampling)
+{
+    setenv("OOMPH_WAIT_ANALYSIS", "4", 1);
+    oomph::context ctxt(MPI_COMM_WORLD, false);
+    unsetenv("OOMPH_WAIT_ANALYSIS");
+    auto       comm = ctxt.get_communicator();
+    auto const speer = (comm.rank() + 1) % comm.size();
+    auto const rpeer = (comm.rank() + comm.size() - 1) % comm.size();
+
+    std::vector<message> smsgs, rmsgs;
+    for (int i = 0; i < NMSGS; ++i)
+    {
+        smsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+        rmsgs.push_back(comm.make_buffer<rank_type>(SIZE));
+    }
+    for (int it = 0; it < NITERS; ++it)
+    {
+        for (int i = 0; i < NMSGS; ++i) comm.recv(rmsgs[i], rpeer, i, [](message&, int, int) {});
+        for (int i = 0; i < NMSGS; ++i) comm.send_detached(smsgs[i], speer, i);
+        comm.wait_all();
+    }
+
+    // messages 0, 4 and 8 of each tag
+    auto const s = accounted(comm, rpeer, 3 * NMSGS);
+    EXPECT_EQ(s.peers[rpeer].wait_samples, 3u * NMSGS);
+    EXPECT_EQ(s.wait_unmatched, 0u);
+}